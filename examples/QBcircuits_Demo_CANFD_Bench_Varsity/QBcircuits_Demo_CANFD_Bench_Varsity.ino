@@ -0,0 +1,151 @@
+/************************************************************************
+CAN FD Bench Demo for the QBcircuits CAN FD Shield. 
+
+Written by BrotherQ. 
+Original tutorial available here: http://www.qbcircuits.com
+
+Distributed as-is; no warranty is given.
+
+Demo summary:
+This demo measures the # of CPU cycles spent in the library on the target
+AVR (ATmega328P Pro Mini / ATmega32U4 Pro Micro). Timer1 runs free at
+Fosc/1, so every number below is in CPU cycles. Interrupts are disabled in
+the measured sections (no Timer0 millis or Timer1 overflow ISR counted) &
+the cycles() call overhead is subtracted; sections must stay < 32768 cycles:
+  - mcp251xfd_init() for CAN FD channels 1 & 2
+  - TX frame (mcp251xfd_msg_write + write_memory + start_transmit) on chn 1
+  - RX frame (mcp251xfd_read_memory) on chn 2
+for CAN 2.0 DLC 0-8 & CAN FD DLC 0-15. CAN FD channels 1 & 2 must be wired
+to the same CANbus network (terminated) so chn 2 recieves what chn 1 sends.
+Results are printed as .csv; a frame chn 2 did not recieve prints RX FAIL.
+Timer1 is taken away from analogWrite(). Without a board the same sections
+run on a simulated ATmega328P: extras/host bench_avr target (simavr).
+*************************************************************************/
+#include <qb_mcp251xfd_defs.h>
+#include <qb_mcp251xfd.h>
+
+// Global Variables *************************************************************************************************************************************************************//
+byte i_u8       = 0;                                                                            // array indexing
+byte fdf_u8     = 0;                                                                            // storing CANbus message FDF value
+byte dlc_u8     = 0;                                                                            // storing CANbus message DLC value
+byte pLen       = 0;                                                                            // storing CANbus message payload length
+byte txData[64] = {0};                                                                          // storing CANbus message payload data byte(s)
+byte rVal[4]    = {0};                                                                          // sub-routines return values
+unsigned long t0_uL     = 0;                                                                    // cycle count at start of measurement
+unsigned long cycOvh_uL = 0;                                                                    // cycles() overhead of an empty measurement
+unsigned long cycInit_uL[2] = {0};                                                              // cycles spent in mcp251xfd_init() per channel
+unsigned long cycTx_uL  = 0;                                                                    // cycles spent transmitting a frame
+unsigned long cycRx_uL  = 0;                                                                    // cycles spent reading a frame
+volatile unsigned long ovf_uL = 0;                                                              // #of Timer1 overflows
+
+chnCAN can1,can2;                                                                               // CAN FD channel structs
+
+// Timer1 overflow **************************************************************************************************************************************************************//
+ISR(TIMER1_OVF_vect){
+  ovf_uL++;                                                                                     // count Timer1 overflows (65536 cycles each)
+}
+
+// Cycle counter ****************************************************************************************************************************************************************//
+unsigned long cycles(){
+  unsigned long ovf;                                                                            // snapshot of overflow counter
+  unsigned int tcnt;                                                                            // snapshot of Timer1 counter
+  byte sreg = SREG;                                                                             // save interrupt state
+
+  cli();                                                                                        // disable interrupts while taking snapshots
+  tcnt = TCNT1;                                                                                 // read Timer1 counter
+  ovf = ovf_uL;                                                                                 // read overflow counter
+  if((TIFR1 & (1<<TOV1)) && (tcnt < 0x8000))                                                    // overflow pending but not yet counted
+    ovf++;                                                                                      // account the pending overflow
+  SREG = sreg;                                                                                  // restore interrupt state
+  return (ovf << 16) | tcnt;                                                                    // assemble 32 bit cycle count
+}
+
+// Setup Function ***************************************************************************************************************************************************************//
+void setup() {
+  Serial.begin(115200);                                                                         // setup serial UART 
+  while (!Serial){}                                                                             // ** pro micro only **
+
+  TCCR1A = 0;                                                                                   // Timer1 normal mode (no PWM)
+  TCCR1B = (1<<CS10);                                                                           // Timer1 clock = Fosc/1
+  TIMSK1 = (1<<TOIE1);                                                                          // Timer1 overflow interrupt enable
+
+  cli();                                                                                        // hold off ISRs while measuring
+  t0_uL = cycles();                                                                             // start measurement
+  cycOvh_uL = cycles() - t0_uL;                                                                 // measure an empty section (overhead)
+  sei();                                                                                        // allow ISRs again
+
+  cli();                                                                                        // hold off ISRs while measuring
+  t0_uL = cycles();                                                                             // start measurement
+  rVal[0] = mcp251xfd_init(CANSPEED_500,&can1,1,TXQ,FIFO1);                                     // setup CAN FD chn 1 for CAN FD & uses TXQ for transmits & FIFO1 for receives
+  cycInit_uL[0] = cycles() - t0_uL - cycOvh_uL;                                                 // stop measurement
+  t0_uL = cycles();                                                                             // start measurement
+  rVal[2] = mcp251xfd_init(CANSPEED_500,&can2,2,TXQ,FIFO1);                                     // setup CAN FD chn 2 for CAN FD & uses TXQ for transmits & FIFO1 for receives
+  cycInit_uL[1] = cycles() - t0_uL - cycOvh_uL;                                                 // stop measurement
+  sei();                                                                                        // allow ISRs again
+  rVal[1] = mcp251xfd_fltr_setup(&can1,FIFO1,FLTRNUM0,FLTRIDX0,FLTRBOTH,0x000,0x000);           // setup CAN FD chn 1 Rx filter to recieve all msg IDs
+  rVal[3] = mcp251xfd_fltr_setup(&can2,FIFO1,FLTRNUM0,FLTRIDX0,FLTRBOTH,0x000,0x000);           // setup CAN FD chn 2 Rx filter to recieve all msg IDs
+
+  if(rVal[0] || rVal[1] || rVal[2] || rVal[3]){                                                 // 1 or more CAN channels failed to initialize
+    Serial.println("Failed to configure CAN channels 1 & 2");                                   // format/print failure diagnostic message
+    Serial.print("CAN1 init status code   = ");Serial.println(rVal[0]);                         // format/print channel 1 setup failure code
+    Serial.print("CAN1 filter status code = ");Serial.println(rVal[1]);                         // format/print channel 1 filter setup failure code
+    Serial.print("CAN2 init status code   = ");Serial.println(rVal[2]);                         // format/print channel 2 setup failure code
+    Serial.print("CAN2 filter status code = ");Serial.println(rVal[3]);                         // format/print channel 2 filter setup failure code
+    while(1){}                                                                                  // wait here forever
+  }
+  for(i_u8=0;i_u8<64;i_u8++){txData[i_u8]=0x55 ^ i_u8;}                                         // fill payload buffer
+
+  Serial.print("F_CPU,");Serial.println(F_CPU);                                                 // format/print CPU clock
+  Serial.print("init,CAN1,");Serial.println(cycInit_uL[0]);                                     // format/print chn 1 init cycles
+  Serial.print("init,CAN2,");Serial.println(cycInit_uL[1]);                                     // format/print chn 2 init cycles
+  Serial.println("[s]   = Start bench");                                                        // hotkeys set 1
+}
+
+// Main Loop ********************************************************************************************************************************************************************//
+void loop(){                                                                                    // system main
+  if(!Serial.available())                                                                       // wait for user to start the bench
+    return;
+  rVal[0] = Serial.read();                                                                      // read user command
+  while(Serial.available()){rVal[1] = Serial.read();}                                           // clear out serial Rx buffer
+  if(rVal[0]!='s' && rVal[0]!='S')                                                              // not a start command
+    return;
+
+  Serial.println("FDF,DLC,Length,TX cycles,RX cycles,RX cycles/byte");                          // format/print .csv header
+  for(fdf_u8=0;fdf_u8<2;fdf_u8++){                                                              // CAN 2.0 then CAN FD frames
+    for(dlc_u8=0;dlc_u8<(fdf_u8 ? 16 : 9);dlc_u8++){                                            // loop thru all valid DLCs
+      pLen = mcp251xfd_len_payload(fdf_u8,dlc_u8);                                              // calculate payload length
+
+      cli();                                                                                    // hold off ISRs while measuring
+      t0_uL = cycles();                                                                         // start TX measurement
+      mcp251xfd_msg_write(&can1,0x123,!IDE,fdf_u8,fdf_u8,!RTR,pLen,txData);                     // populate channel struct with necessary transmit info
+      mcp251xfd_write_memory(TXQ,&can1);                                                        // write the Tx message info to MCP2517 TXQ
+      mcp251xfd_start_transmit(TXQ,&can1);                                                      // initiate a transmit onto the CANbus network
+      cycTx_uL = cycles() - t0_uL - cycOvh_uL;                                                  // stop TX measurement
+      sei();                                                                                    // allow ISRs again
+
+      delay(2);                                                                                 // wait for the frame to cross the bus
+      cycRx_uL = 0;                                                                             // default to no frame recieved
+      rVal[2] = mcp251xfd_check_message(&can2);                                                 // check if chn 2 has recieved the msg
+      if(rVal[2]){                                                                              // chn 2 has recieved the msg
+        cli();                                                                                  // hold off ISRs while measuring
+        t0_uL = cycles();                                                                       // start RX measurement
+        mcp251xfd_read_memory(FIFO1,&can2);                                                     // read the msg recieved by chn 2
+        cycRx_uL = cycles() - t0_uL - cycOvh_uL;                                                // stop RX measurement
+        sei();                                                                                  // allow ISRs again
+      }
+
+      Serial.print(fdf_u8);   Serial.print(",");                                                // format/print FDF field
+      Serial.print(dlc_u8);   Serial.print(",");                                                // format/print DLC field
+      Serial.print(pLen);     Serial.print(",");                                                // format/print payload length
+      Serial.print(cycTx_uL); Serial.print(",");                                                // format/print TX cycles
+      if(!rVal[2]){                                                                             // chn 2 did not recieve the msg
+        Serial.println("RX FAIL,RX FAIL");                                                      // format/print failure (check wiring & termination)
+        continue;
+      }
+      Serial.print(cycRx_uL); Serial.print(",");                                                // format/print RX cycles
+      if(pLen) Serial.println(cycRx_uL / pLen);                                                 // format/print RX cycles per payload byte
+      else     Serial.println(0);                                                               // no payload bytes
+    }
+  }
+  Serial.println(" #GoLong");                                                                   // print acknowledgement
+}
@@ -12,6 +12,7 @@ to read any CAN 2.0/CAN FD messages on the monitored CANbus network.
 *************************************************************************/
 #include <qb_mcp251xfd_defs.h>
 #include <qb_mcp251xfd.h>
+#include <qb_cansurv.h>
 
 // Global Variables *************************************************************************************************************************************************************//
 byte i_u8       = 0;                                                                            // array indexing
@@ -25,6 +26,8 @@ chnCAN can1,can2,*ptrChn[2];
 boolean can1_bL = 1;                                                                            // enable/disable for CAN FD chn 1 (change to 0/1 to disable/enable)
 boolean can2_bL = 1;                                                                            // enable/disable for CAN FD chn 2 (change to 0/1 to disable/enable)
 unsigned long cntOvFlw_uL[2] = {0};                                                             // #of times timer based counter of a CAN FD channel has overflowed
+survEntry survTbl[32];                                                                          // bus survey table (~35 bytes SRAM per ID)
+survCAN surv;                                                                                   // bus survey of both channels
 
 // Setup Function ***************************************************************************************************************************************************************//
 void setup() {
@@ -44,8 +47,11 @@ void setup() {
     ptrChn[1] = &can2;                                                                          // assign chnCAN pointer
     min_u8 = (1 >> can1_bL);                                                                    // calculate min array index for looping thru chnCAN pointers
     max_u8 = (1 << can2_bL);                                                                    // calculate max array index for looping thru chnCAN pointers
+    cansurv_init(&surv,survTbl,32);                                                             // setup bus survey table
 
     Serial.println("[s]   = Start/Stop Logging");                                               // hotkeys set 1
+    Serial.println("[v]   = Start/Stop Survey");                                                // hotkeys set 1
+    Serial.println("[r]   = Print Survey Report");                                              // hotkeys set 1
     Serial.println();                                                                           // format/print new line
     Serial.print("Channel,Time(s),#of overflows,#of (1/40MHz) periods,ID,IDE,FDF,BRS,RTR,DLC,Length,Data");     // format/print .csv header
     Serial.println();                                                                           // format/print new line
@@ -71,7 +77,14 @@ void loop(){
   if(Serial.available()){                                                                           // recieved user selected option (take 1st char recieved)
     rVal[0] = Serial.read();                                                                        // 1st option starts at ASCII "0" so subtract 48 from recieved char to get numeric value
     if(rVal[0]=='s' || rVal[0]=='S'){                                                               // check if recieve start/stop command
-      mode_u8 = !mode_u8;                                                                           // go to state1
+      mode_u8 = (mode_u8 != 1);                                                                     // toggle state1 (logging)
+    }
+    else if(rVal[0]=='v' || rVal[0]=='V'){                                                          // check if recieve start/stop survey command
+      if(mode_u8 != 2) cansurv_clear(&surv);                                                        // starting a new survey
+      mode_u8 = (mode_u8 != 2) ? 2 : 0;                                                             // toggle state2 (survey)
+    }
+    else if(rVal[0]=='r' || rVal[0]=='R'){                                                          // check if recieve survey report command
+      cansurv_report(&surv);                                                                        // format/print survey .csv report
     }
     while(Serial.available()){rVal[0] = Serial.read();}                                             // clear out serial Rx buffer
   }
@@ -89,6 +102,10 @@ void loop(){
         }
         for(i_u8=0;i_u8<CSCNT;i_u8++);                                                              // wait some time before toggling MCP2517 chip select
         mcp251xfd_read_memory(FIFO1,ptrChn[j_u8]);                                                  // read current chnCAN message stored in FIFO1 
+        if(mode_u8 == 2){                                                                           // state2 [survey, no per frame output]
+          cansurv_rx(&surv,ptrChn[j_u8]->chnNum,&ptrChn[j_u8]->msg);                              // account msg into the survey (per channel & ID)
+          continue;
+        }
 
         Serial.print("CAN"); Serial.print(ptrChn[j_u8]->chnNum);Serial.print(",");                  // format/print chn#
 
@@ -0,0 +1,239 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+/**************************************************************************************************
+Host benchmark runner (MCP251XFD_HOST + MCP251XFD_PROF=1 against sim_mcp251xfd.c)
+  Runs mcp251xfd_init() & mcp251xfd_fltr_setup() once, then BENCHREPS frames per size from channel 1
+  (TXQ, write_frame + start_transmit) to channel 2 (FIFO1, read_frame) for CAN 2.0 DLC 0-8 & CAN FD
+  DLC 0-15 (BRS), checking every received frame against the one sent. Per row the mean SPI bytes,
+  CS assertions & register reads per call are reported with the modelled SPI bound frames/s
+  (SIMSPIBPS / bytes). Counts are deterministic, so they are compared exactly against a baseline:
+	bench [--json] [--csv <file>] [--baseline <file> [--update]]
+  exit 0 = no regression, 1 = a row costs more than its baseline (or is missing), 2 = frame mismatch
+  or driver error code. --update rewrites the baseline with this run.
+**************************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_mcp251xfd_prof.h"
+#include "sim_mcp251xfd.h"
+
+#define BENCHREPS		64				// frames per row
+#define BENCHROWS		64				// max #of result rows
+#define BENCHOP			8				// max op name length
+
+typedef struct{
+	char op[BENCHOP];												// init, fltr, tx, rx
+	char kind[BENCHOP];												// cfg, can20, canfd
+	uint8_t len;													// payload bytes
+	unsigned long calls;											// #of calls measured
+	unsigned long bytes;											// SPI bytes per call (mean)
+	unsigned long cs;												// CS assertions per call (mean)
+	unsigned long rdReg;											// register reads per call (mean)
+	unsigned long fps;												// SPI bound frames/s (SIMSPIBPS / bytes)
+} benchRow;
+
+static benchRow benchTbl[BENCHROWS];
+static uint8_t benchCnt;
+
+/**************************************************************************************************
+Purpose: 	Adds a result row from the summed statistics of 1 or 2 profiled calls
+**************************************************************************************************/
+static void bench_row(const char *op,const char *kind,uint8_t len,uint8_t op0,int op1){
+	benchRow *ptrRow = &benchTbl[benchCnt++];
+	unsigned long calls = mcp251xfd_prof[op0].calls;
+	unsigned long sum[PROF_METRICS];
+	uint8_t idx;
+
+	for(idx=0;idx<PROF_METRICS;idx++){
+		sum[idx] = mcp251xfd_prof[op0].sum[idx];
+		if(op1 >= 0)
+			sum[idx] += mcp251xfd_prof[op1].sum[idx];
+	}
+	snprintf(ptrRow->op,BENCHOP,"%s",op);
+	snprintf(ptrRow->kind,BENCHOP,"%s",kind);
+	ptrRow->len = len;
+	ptrRow->calls = calls;
+	ptrRow->bytes = sum[PROF_BYTES] / calls;
+	ptrRow->cs = sum[PROF_CS] / calls;
+	ptrRow->rdReg = sum[PROF_RDREG] / calls;
+	ptrRow->fps = ptrRow->bytes ? SIMSPIBPS / ptrRow->bytes : 0;
+}
+/**************************************************************************************************
+Purpose: 	Sends BENCHREPS frames of 1 size from channel 1 to channel 2 & adds the tx & rx rows
+Outputs:	0 = ok; 2 = driver error or frame mismatch
+**************************************************************************************************/
+static int bench_size(chnCAN *ptrCan1,chnCAN *ptrCan2,uint8_t fdf,uint8_t dlc){
+	msgCAN txMsg, rxMsg;
+	uint8_t buf[64], len, idx;
+	unsigned long id;
+	int rep;
+
+	len = mcp251xfd_len_payload(fdf,dlc);
+	mcp251xfd_prof_reset();
+	for(rep=0;rep<BENCHREPS;rep++){
+		for(idx=0;idx<len;idx++)
+			buf[idx] = rep*7 + idx;
+		id = (rep & 1) ? (unsigned long)(0x18DA00F1UL + rep) : (unsigned long)(0x100 + rep);		// alternate 29 & 11 bit IDs
+		mcp251xfd_frame_prep(&txMsg,id,rep & 1,fdf,fdf,0,len,buf);
+		if(mcp251xfd_write_frame(TXQ,ptrCan1,&txMsg) || mcp251xfd_start_transmit(TXQ,ptrCan1)){
+			fprintf(stderr,"tx error %s len %u rep %d\n",fdf ? "canfd" : "can20",len,rep);
+			return 2;
+		}
+		if(mcp251xfd_read_frame(FIFO1,ptrCan2,&rxMsg)){
+			fprintf(stderr,"rx error %s len %u rep %d\n",fdf ? "canfd" : "can20",len,rep);
+			return 2;
+		}
+		if(mcp251xfd_msg_id(&rxMsg) != mcp251xfd_msg_id(&txMsg) || rxMsg.fdf != fdf || rxMsg.pLen != len ||
+		   memcmp(rxMsg.rxData,buf,len)){
+			fprintf(stderr,"frame mismatch %s len %u rep %d\n",fdf ? "canfd" : "can20",len,rep);
+			return 2;
+		}
+	}
+	bench_row("tx",fdf ? "canfd" : "can20",len,PROF_WRMEM,PROF_TXSTART);
+	bench_row("rx",fdf ? "canfd" : "can20",len,PROF_RDMEM,-1);
+	return 0;
+}
+/**************************************************************************************************
+Purpose: 	Writes the result rows as .csv (fp) or JSON
+**************************************************************************************************/
+static void bench_csv(FILE *fp){
+	uint8_t idx;
+
+	fprintf(fp,"op,kind,len,calls,bytes,cs,rdreg,fps\n");
+	for(idx=0;idx<benchCnt;idx++)
+		fprintf(fp,"%s,%s,%u,%lu,%lu,%lu,%lu,%lu\n",benchTbl[idx].op,benchTbl[idx].kind,benchTbl[idx].len,
+			benchTbl[idx].calls,benchTbl[idx].bytes,benchTbl[idx].cs,benchTbl[idx].rdReg,benchTbl[idx].fps);
+}
+static void bench_json(FILE *fp){
+	uint8_t idx;
+
+	fprintf(fp,"[\n");
+	for(idx=0;idx<benchCnt;idx++)
+		fprintf(fp,"  {\"op\":\"%s\",\"kind\":\"%s\",\"len\":%u,\"calls\":%lu,\"bytes\":%lu,\"cs\":%lu,\"rdreg\":%lu,\"fps\":%lu}%s\n",
+			benchTbl[idx].op,benchTbl[idx].kind,benchTbl[idx].len,benchTbl[idx].calls,benchTbl[idx].bytes,
+			benchTbl[idx].cs,benchTbl[idx].rdReg,benchTbl[idx].fps,(idx+1 < benchCnt) ? "," : "");
+	fprintf(fp,"]\n");
+}
+/**************************************************************************************************
+Purpose: 	Compares the result rows against a baseline .csv
+Outputs:	0 = no regression; 1 = regression or row missing from the baseline
+**************************************************************************************************/
+static int bench_compare(const char *path){
+	FILE *fp = fopen(path,"r");
+	char line[128], op[BENCHOP], kind[BENCHOP];
+	unsigned len, found;
+	unsigned long calls, bytes, cs, rdReg, fps;
+	uint8_t idx;
+	int result = 0;
+
+	if(!fp){
+		fprintf(stderr,"no baseline %s (run with --update)\n",path);
+		return 1;
+	}
+	for(idx=0;idx<benchCnt;idx++){
+		found = 0;
+		rewind(fp);
+		while(fgets(line,sizeof(line),fp)){
+			if(sscanf(line,"%7[^,],%7[^,],%u,%lu,%lu,%lu,%lu,%lu",op,kind,&len,&calls,&bytes,&cs,&rdReg,&fps) != 8)
+				continue;
+			if(strcmp(op,benchTbl[idx].op) || strcmp(kind,benchTbl[idx].kind) || len != benchTbl[idx].len)
+				continue;
+			found = 1;
+			if(benchTbl[idx].bytes > bytes || benchTbl[idx].cs > cs || benchTbl[idx].rdReg > rdReg){
+				printf("REGRESSION %s %s len %u: bytes %lu->%lu cs %lu->%lu rdreg %lu->%lu\n",op,kind,len,
+					bytes,benchTbl[idx].bytes,cs,benchTbl[idx].cs,rdReg,benchTbl[idx].rdReg);
+				result = 1;
+			}
+			else if(benchTbl[idx].bytes < bytes || benchTbl[idx].cs < cs || benchTbl[idx].rdReg < rdReg)
+				printf("improved %s %s len %u: bytes %lu->%lu (run with --update to keep)\n",op,kind,len,bytes,benchTbl[idx].bytes);
+			break;
+		}
+		if(!found){
+			printf("MISSING %s %s len %u in %s\n",benchTbl[idx].op,benchTbl[idx].kind,benchTbl[idx].len,path);
+			result = 1;
+		}
+	}
+	fclose(fp);
+	return result;
+}
+
+int main(int argc,char **argv){
+	chnCAN can1, can2;
+	const char *csvPath = 0, *basePath = 0;
+	int json = 0, update = 0, arg, result;
+	uint8_t dlc;
+	FILE *fp;
+
+	for(arg=1;arg<argc;arg++){
+		if(!strcmp(argv[arg],"--json"))
+			json = 1;
+		else if(!strcmp(argv[arg],"--update"))
+			update = 1;
+		else if(!strcmp(argv[arg],"--csv") && arg+1 < argc)
+			csvPath = argv[++arg];
+		else if(!strcmp(argv[arg],"--baseline") && arg+1 < argc)
+			basePath = argv[++arg];
+		else{
+			fprintf(stderr,"usage: %s [--json] [--csv <file>] [--baseline <file> [--update]]\n",argv[0]);
+			return 2;
+		}
+	}
+
+	sim_reset();
+	mcp251xfd_prof_init();
+	if(mcp251xfd_init(CANSPEED_500,&can1,1,TXQ,FIFO1) || mcp251xfd_init(CANSPEED_500,&can2,2,TXQ,FIFO1)){
+		fprintf(stderr,"mcp251xfd_init() failed\n");
+		return 2;
+	}
+	bench_row("init","cfg",0,PROF_INIT,-1);
+	if(mcp251xfd_fltr_setup(&can2,FIFO1,FLTRNUM0,FLTRIDX0,FLTRBOTH,0,0)){
+		fprintf(stderr,"mcp251xfd_fltr_setup() failed\n");
+		return 2;
+	}
+	bench_row("fltr","cfg",0,PROF_FLTR,-1);
+
+	for(dlc=0;dlc<=8;dlc++){
+		if(bench_size(&can1,&can2,0,dlc))
+			return 2;
+	}
+	for(dlc=0;dlc<=15;dlc++){
+		if(bench_size(&can1,&can2,1,dlc))
+			return 2;
+	}
+
+	if(json)
+		bench_json(stdout);
+	else
+		bench_csv(stdout);
+	if(csvPath && (fp = fopen(csvPath,"w"))){
+		bench_csv(fp);
+		fclose(fp);
+	}
+	if(!basePath)
+		return 0;
+	if(update){
+		if(!(fp = fopen(basePath,"w"))){
+			fprintf(stderr,"cannot write %s\n",basePath);
+			return 2;
+		}
+		bench_csv(fp);
+		fclose(fp);
+		printf("baseline %s updated\n",basePath);
+		return 0;
+	}
+	result = bench_compare(basePath);
+	printf("%s\n",result ? "FAIL" : "PASS");
+	return result;
+}
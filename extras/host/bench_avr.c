@@ -0,0 +1,80 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+/**************************************************************************************************
+ATmega328P cycle benchmark firmware (avr-gcc, run by bench_simavr under simavr)
+  The same sections as QBcircuits_Demo_CANFD_Bench_Varsity: mcp251xfd_init() for channels 1 & 2, a
+  TX frame (mcp251xfd_msg_write + write_memory + start_transmit) on channel 1 & the RX frame
+  (mcp251xfd_read_memory) on channel 2 for CAN 2.0 DLC 0-8 & CAN FD DLC 0-15, framed by GPIOR0
+  marks (bench_avr.h). Interrupts stay disabled, so the counts are library cycles only.
+**************************************************************************************************/
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_mcp251xfd_defs.h"
+#include "bench_avr.h"
+
+static chnCAN can1, can2;
+static uint8_t txData[64];
+
+int main(void){
+	uint8_t fdf, dlc, pLen, idx, rVal;
+
+	cli();
+	GPIOR0 = BENCHSTART;											// empty section
+	GPIOR0 = BENCHOVH;
+
+	GPIOR1 = 1;
+	GPIOR0 = BENCHSTART;
+	rVal = mcp251xfd_init(CANSPEED_500,&can1,1,TXQ,FIFO1);
+	GPIOR0 = BENCHINIT;
+	GPIOR1 = 2;
+	GPIOR0 = BENCHSTART;
+	rVal |= mcp251xfd_init(CANSPEED_500,&can2,2,TXQ,FIFO1);
+	GPIOR0 = BENCHINIT;
+	rVal |= mcp251xfd_fltr_setup(&can2,FIFO1,FLTRNUM0,FLTRIDX0,FLTRBOTH,0x000,0x000);
+	if(rVal)
+		GPIOR0 = BENCHINITFAIL;
+
+	for(idx=0;idx<64;idx++)
+		txData[idx] = 0x55 ^ idx;
+	for(fdf=0;!rVal && (fdf<2);fdf++){								// CAN 2.0 then CAN FD frames
+		for(dlc=0;dlc<(fdf ? 16 : 9);dlc++){						// loop thru all valid DLCs
+			pLen = mcp251xfd_len_payload(fdf,dlc);
+			GPIOR1 = (fdf << 4) | dlc;
+			GPIOR0 = BENCHSTART;
+			mcp251xfd_msg_write(&can1,0x123,!IDE,fdf,fdf,!RTR,pLen,txData);
+			mcp251xfd_write_memory(TXQ,&can1);
+			mcp251xfd_start_transmit(TXQ,&can1);
+			GPIOR0 = BENCHTX;
+
+			if(!mcp251xfd_check_message(&can2)){					// chn 2 did not receive the msg
+				GPIOR0 = BENCHRXFAIL;
+				continue;
+			}
+			GPIOR0 = BENCHSTART;
+			mcp251xfd_read_memory(FIFO1,&can2);
+			GPIOR0 = BENCHRX;
+			for(idx=0;idx<pLen;idx++){								// check the payload
+				if(can2.msg.rxData[idx] != txData[idx]){
+					GPIOR0 = BENCHRXFAIL;
+					break;
+				}
+			}
+		}
+	}
+	GPIOR0 = BENCHDONE;
+	sleep_cpu();													// interrupts off: simavr stops (cpu_Done)
+	return 0;
+}
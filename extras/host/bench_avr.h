@@ -0,0 +1,36 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#ifndef	BENCH_AVR_H
+#define	BENCH_AVR_H
+
+/**************************************************************************************************
+Marker protocol between bench_avr.c (ATmega328P firmware) & bench_simavr.c (simavr runner)
+  The firmware writes the row (FDF << 4 | DLC, or the channel # for init) to GPIOR1, then BENCHSTART
+  to GPIOR0 before a measured section & a BENCHx stop mark after it. The runner latches the simavr
+  cycle counter on every GPIOR0 write, so a section costs (stop - start) cycles less the cost of an
+  empty section (BENCHOVH).
+**************************************************************************************************/
+#define BENCHFCPU		16000000UL		// Pro Mini clock (cycles/s)
+#define BENCHGPIOR0		0x3E			// GPIOR0 data space address (marks)
+#define BENCHGPIOR1		0x4A			// GPIOR1 data space address (row)
+
+#define BENCHSTART		1				// mark - start of a measured section
+#define BENCHOVH		2				// mark - end of an empty section (measurement overhead)
+#define BENCHINIT		3				// mark - end of mcp251xfd_init() (row = channel #)
+#define BENCHTX			4				// mark - end of a TX frame (msg_write + write_memory + start_transmit)
+#define BENCHRX			5				// mark - end of an RX frame (read_memory)
+#define BENCHRXFAIL		6				// mark - no frame received or payload mismatch (row = FDF << 4 | DLC)
+#define BENCHINITFAIL	7				// mark - mcp251xfd_init() or filter setup failed
+#define BENCHDONE		8				// mark - all rows measured
+
+#endif	// BENCH_AVR_H
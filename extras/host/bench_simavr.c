@@ -0,0 +1,145 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+/**************************************************************************************************
+simavr runner for the ATmega328P cycle benchmark (bench_avr.c built with avr-gcc)
+  Runs the firmware on a simulated ATmega328P at BENCHFCPU with sim_mcp251xfd.c attached as the
+  SPI peripheral: SPI output bytes are clocked thru mcp251xfd_host_xfer() & answered on the SPI
+  input, CS1 (PB2) & CS2 (PC3) drive mcp251xfd_host_cs() & INT1 (PD7) & INT2 (PB0) follow
+  mcp251xfd_host_int() after every SPI transaction. simavr counts AVR cycles per instruction & SPI
+  bytes at the SPCR/SPSR clock (Fosc/2), so SPIF polling, CSCNT loops & msg field packing are counted.
+	bench_simavr <bench_avr.elf>
+  .csv on stdout (op,kind,len,cycles); exit 0 = all rows measured, 2 = init failed, frame lost or
+  mismatched, firmware crashed or did not finish.
+**************************************************************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/avr_spi.h>
+#include <simavr/avr_ioport.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_mcp251xfd_host.h"
+#include "sim_mcp251xfd.h"
+#include "bench_avr.h"
+
+#define BENCHLIMIT		(BENCHFCPU * 10)	// cycles before the firmware is given up on (10 s)
+
+static avr_irq_t *spiIn;											// SPI input (byte clocked in by the master)
+static avr_irq_t *intIrq[SIMCHNS];									// INT1 & INT2 pins
+static avr_cycle_count_t t0, ovh;									// start of section, empty section cycles
+static int fails, done;
+
+/**************************************************************************************************
+Purpose: 	SPI byte sent by the firmware - clock it thru the simulated MCP2517FD & answer it
+**************************************************************************************************/
+static void bench_spi(struct avr_irq_t *irq,uint32_t value,void *param){
+	(void)irq;
+	(void)param;
+	avr_raise_irq(spiIn,mcp251xfd_host_xfer(value));
+}
+/**************************************************************************************************
+Purpose: 	CS pin change - select/deselect a channel & update the INT pins at the end of a transaction
+**************************************************************************************************/
+static void bench_cs(struct avr_irq_t *irq,uint32_t value,void *param){
+	uint8_t chnNum = (uint8_t)(uintptr_t)param, idx;
+
+	(void)irq;
+	mcp251xfd_host_cs(chnNum,value & 1);
+	if(!(value & 1))
+		return;
+	for(idx=0;idx<SIMCHNS;idx++)
+		avr_raise_irq(intIrq[idx],mcp251xfd_host_int(idx + 1));
+}
+/**************************************************************************************************
+Purpose: 	GPIOR0 write - latch the cycle counter & print a row at a stop mark
+**************************************************************************************************/
+static void bench_mark(avr_t *avr,avr_io_addr_t addr,uint8_t v,void *param){
+	uint8_t row = avr->data[BENCHGPIOR1];
+	avr_cycle_count_t cyc = avr->cycle - t0 - ovh;
+
+	(void)param;
+	avr->data[addr] = v;
+	switch(v){
+	case BENCHSTART:
+		t0 = avr->cycle;
+		break;
+	case BENCHOVH:
+		ovh = avr->cycle - t0;
+		break;
+	case BENCHINIT:
+		printf("init,CAN%u,0,%llu\n",row,(unsigned long long)cyc);
+		break;
+	case BENCHTX:
+	case BENCHRX:
+		printf("%s,%s,%u,%llu\n",(v == BENCHTX) ? "tx" : "rx",(row >> 4) ? "canfd" : "can20",
+			mcp251xfd_len_payload(row >> 4,row & 0x0F),(unsigned long long)cyc);
+		break;
+	case BENCHRXFAIL:
+		fprintf(stderr,"rx error %s dlc %u\n",(row >> 4) ? "canfd" : "can20",row & 0x0F);
+		fails++;
+		break;
+	case BENCHINITFAIL:
+		fprintf(stderr,"mcp251xfd_init() or mcp251xfd_fltr_setup() failed\n");
+		fails++;
+		break;
+	case BENCHDONE:
+		done = 1;
+		break;
+	}
+}
+
+int main(int argc,char **argv){
+	elf_firmware_t fw;
+	avr_t *avr;
+	int state;
+
+	if(argc != 2){
+		fprintf(stderr,"usage: %s <bench_avr.elf>\n",argv[0]);
+		return 2;
+	}
+	memset(&fw,0,sizeof(fw));
+	if(elf_read_firmware(argv[1],&fw)){
+		fprintf(stderr,"cannot read %s\n",argv[1]);
+		return 2;
+	}
+	if(!(avr = avr_make_mcu_by_name("atmega328p")))
+		return 2;
+	avr_init(avr);
+	avr_load_firmware(avr,&fw);
+	avr->frequency = BENCHFCPU;
+
+	sim_reset();
+	spiIn = avr_io_getirq(avr,AVR_IOCTL_SPI_GETIRQ(0),SPI_IRQ_INPUT);
+	avr_irq_register_notify(avr_io_getirq(avr,AVR_IOCTL_SPI_GETIRQ(0),SPI_IRQ_OUTPUT),bench_spi,NULL);
+	avr_irq_register_notify(avr_io_getirq(avr,AVR_IOCTL_IOPORT_GETIRQ('B'),2),bench_cs,(void *)1);
+	avr_irq_register_notify(avr_io_getirq(avr,AVR_IOCTL_IOPORT_GETIRQ('C'),3),bench_cs,(void *)2);
+	intIrq[0] = avr_io_getirq(avr,AVR_IOCTL_IOPORT_GETIRQ('D'),7);
+	intIrq[1] = avr_io_getirq(avr,AVR_IOCTL_IOPORT_GETIRQ('B'),0);
+	avr_raise_irq(intIrq[0],1);										// INT pins idle high
+	avr_raise_irq(intIrq[1],1);
+	avr_register_io_write(avr,BENCHGPIOR0,bench_mark,NULL);
+
+	printf("op,kind,len,cycles\n");
+	do{
+		state = avr_run(avr);
+	}while((state != cpu_Done) && (state != cpu_Crashed) && !done && (avr->cycle < BENCHLIMIT));
+	if(!done){
+		fprintf(stderr,"firmware %s at cycle %llu\n",(state == cpu_Crashed) ? "crashed" : "did not finish",
+			(unsigned long long)avr->cycle);
+		return 2;
+	}
+	return fails ? 2 : 0;
+}
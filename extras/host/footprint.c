@@ -0,0 +1,52 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+/**************************************************************************************************
+Build profile SRAM footprint (built once per profile by CMakeLists.txt)
+  Prints the AVR SRAM of msgCAN & chnCAN for the profile it is compiled with as a .csv row. AVR
+  structs have no padding & a 4 byte unsigned long, so the sizes are summed from the members rather
+  than taken from the host sizeof():
+	footprint [<msgCAN bytes> <chnCAN bytes>]
+  with the expected sizes given, exit 1 if either differs (the figures in qb_mcp251xfd.h).
+**************************************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+#include "qb_mcp251xfd.h"
+
+#define AVR_ULONG		4				// sizeof(unsigned long) on AVR
+
+#ifndef FOOTPRINT_NAME
+#define FOOTPRINT_NAME	"default"
+#endif
+
+int main(int argc,char **argv){
+	msgCAN msg;
+	chnCAN chn;
+	unsigned long msgSize, chnSize;
+
+	msgSize = offsetof(msgCAN,rxData) + sizeof(msg.rxData)			// T0,T1 + timestamp & payload union
+			+ AVR_ULONG + sizeof(msg.pLen);							// tStamp, pLen
+	chnSize = sizeof(chn.chnNum) + sizeof(chn.regWr) + sizeof(chn.regRd) + sizeof(chn.rxCnt) + sizeof(chn.txCnt);
+#if !MCP251XFD_COMPACT
+	chnSize += msgSize;												// embedded msg member
+#endif
+
+	printf("profile,maxpayload,compact,msgCAN,chnCAN,2 chnCAN\n");
+	printf("%s,%u,%u,%lu,%lu,%lu\n",FOOTPRINT_NAME,MCP251XFD_MAXPAYLOAD,MCP251XFD_COMPACT,msgSize,chnSize,2*chnSize);
+	if(argc == 3 && (msgSize != strtoul(argv[1],0,10) || chnSize != strtoul(argv[2],0,10))){
+		printf("FAIL expected msgCAN %s chnCAN %s\n",argv[1],argv[2]);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,47 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#ifndef	HOST_ARDUINO_H
+#define	HOST_ARDUINO_H
+
+/**************************************************************************************************
+Host stand in for the Arduino core (host tests of the C++ library modules only): fixed width types,
+  flash access as plain memory (avr/pgmspace.h) & a Serial that discards its output.
+**************************************************************************************************/
+#include <stdint.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+
+#define HEX				16
+#define DEC				10
+
+typedef uint8_t byte;
+typedef bool boolean;
+class __FlashStringHelper;
+#define F(s)			((const __FlashStringHelper *)(s))
+
+struct hostSerial{
+	void begin(unsigned long){}
+	template<class T> void print(T){}
+	template<class T> void print(T,int){}
+	template<class T> void println(T){}
+	template<class T> void println(T,int){}
+	void println(void){}
+	void write(uint8_t){}
+	void write(const uint8_t *,int){}
+	int available(void){ return 0; }
+	int read(void){ return -1; }
+	operator bool(void){ return true; }
+};
+extern hostSerial Serial;
+
+#endif	// HOST_ARDUINO_H
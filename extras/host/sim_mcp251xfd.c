@@ -0,0 +1,433 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#include <string.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_mcp251xfd_host.h"
+#include "sim_mcp251xfd.h"
+
+#define SIMCON(m)		(0x050 + 12*(m))						// TXQCON/FIFOCONm
+#define SIMSTA(m)		(0x054 + 12*(m))						// TXQSTA/FIFOSTAm
+#define SIMUA(m)		(0x058 + 12*(m))						// TXQUA/FIFOUAm
+
+simChn			simChnTbl[SIMCHNS];
+void 			(*simBus)(uint8_t chnNum,const uint8_t *ptrObj) = sim_bus_loop;
+unsigned long 	simBytes;
+unsigned long 	simCs;
+
+static uint8_t 	simSel;												// selected channel (0 = CS high)
+static uint8_t 	simState;											// 0 = cmd byte;1 = addr byte;2 = data bytes
+static uint8_t 	simCmd;												// SPI cmd of the transaction
+static uint16_t simAddr;											// address of the next data byte
+static uint16_t simCyc;												// Fosc cycle counter
+
+static const uint8_t simPlSize[8] = {8,12,16,20,24,32,48,64};		// PLSIZE -> #of payload bytes
+static const uint8_t simDlcMem[16] = {0,4,4,4,4,8,8,8,8,12,16,20,24,32,48,64};	// DLC -> #of msg object payload bytes
+
+/**************************************************************************************************
+Purpose: 	Little endian 32 bit word of the simulated address space
+**************************************************************************************************/
+static unsigned long sim_rd32(const uint8_t *ptr){
+	return (unsigned long)ptr[0] | ((unsigned long)ptr[1] << 8) | ((unsigned long)ptr[2] << 16) | ((unsigned long)ptr[3] << 24);
+}
+static void sim_wr32(uint8_t *ptr,unsigned long val){
+	ptr[0] = val;
+	ptr[1] = val >> 8;
+	ptr[2] = val >> 16;
+	ptr[3] = val >> 24;
+}
+/**************************************************************************************************
+Purpose: 	Checks if TXQ/FIFOm is a TX buffer
+**************************************************************************************************/
+static uint8_t sim_is_tx(simChn *ptrSim,uint8_t m){
+	return !m || (ptrSim->mem[SIMCON(m)] >> TXEN) & 1;
+}
+/**************************************************************************************************
+Purpose: 	Checks if an operation mode sends frames (normal FD/2.0, internal/external loopback)
+**************************************************************************************************/
+static uint8_t sim_mode_tx(uint8_t mode){
+	return mode == CANMODE_NORMALFD || mode == CANMODE_INTLOOP || mode == CANMODE_EXTLOOP || mode == CANMODE_NORMAL20;
+}
+/**************************************************************************************************
+Purpose: 	Allocates message RAM as the controller does on leaving configuration mode
+				(TEF, then TXQ, then FIFO1-31, each FSIZE+1 objects)
+**************************************************************************************************/
+static void sim_alloc(simChn *ptrSim){
+	uint8_t m;
+	uint16_t off = 0;												// RAM offset of the next object
+	uint8_t *con;
+
+	if((ptrSim->mem[ADDR_C1CON+2] >> 3) & 1)						// STEF=1 -> TEF allocated 1st
+		off = ((ptrSim->mem[ADDR_C1TEFCON+3] & 0x1F) + 1) * (8 + 4*((ptrSim->mem[ADDR_C1TEFCON] >> TEFTSEN) & 1));
+	for(m=0;m<32;m++){
+		con = &ptrSim->mem[SIMCON(m)];
+		ptrSim->head[m] = 0;
+		ptrSim->cnt[m] = 0;
+		if(!m && !((ptrSim->mem[ADDR_C1CON+2] >> 4) & 1)){			// TXQEN=0 -> no TXQ
+			ptrSim->depth[m] = 0;
+			continue;
+		}
+		ptrSim->depth[m] = (con[3] & 0x1F) + 1;
+		ptrSim->objLen[m] = 8 + simPlSize[con[3] >> PLSIZE];
+		if(!sim_is_tx(ptrSim,m) && ((con[0] >> RXTSEN) & 1))		// RX FIFO storing timestamps
+			ptrSim->objLen[m] += 4;
+		ptrSim->base[m] = off;
+		off += ptrSim->depth[m] * ptrSim->objLen[m];
+		if(off > SIMRAMSIZE)										// out of RAM (controller flags a config error)
+			ptrSim->depth[m] = 0;
+	}
+}
+/**************************************************************************************************
+Purpose: 	Refreshes the status registers (FIFOSTA, FIFOUA, C1RXIF, C1TXREQ, C1INT RXIF) from the
+				FIFO state before a read
+**************************************************************************************************/
+static void sim_sync(simChn *ptrSim){
+	uint8_t m, *sta, idx;
+	unsigned long rxIf = 0, txReq = 0;
+
+	for(m=0;m<32;m++){
+		sta = &ptrSim->mem[SIMSTA(m)];
+		sta[0] &= (1<<3);											// keep RXOVIF (cleared by the application)
+		if(!ptrSim->depth[m]){
+			sim_wr32(&ptrSim->mem[SIMUA(m)],0);
+			continue;
+		}
+		if(sim_is_tx(ptrSim,m)){
+			idx = (ptrSim->head[m] + ptrSim->cnt[m]) % ptrSim->depth[m];	// next free object
+			sta[0] |= (ptrSim->cnt[m] < ptrSim->depth[m]) << TFNRFNIF;	// not full
+			sta[0] |= (2*ptrSim->cnt[m] <= ptrSim->depth[m]) << TFHRFHIF;	// half empty
+			sta[0] |= (!ptrSim->cnt[m]) << TFERFFIF;				// empty
+			if((ptrSim->mem[SIMCON(m)+1] >> TXREQ) & 1)
+				txReq |= 1UL << m;
+		}
+		else{
+			idx = ptrSim->head[m];									// oldest object
+			sta[0] |= (ptrSim->cnt[m] > 0) << TFNRFNIF;				// not empty
+			sta[0] |= (2*ptrSim->cnt[m] >= ptrSim->depth[m]) << TFHRFHIF;	// half full
+			sta[0] |= (ptrSim->cnt[m] == ptrSim->depth[m]) << TFERFFIF;	// full
+			if(ptrSim->cnt[m])
+				rxIf |= 1UL << m;
+		}
+		sta[1] = idx;												// FIFOCI
+		sim_wr32(&ptrSim->mem[SIMUA(m)],ptrSim->base[m] + idx*ptrSim->objLen[m]);
+	}
+	sim_wr32(&ptrSim->mem[ADDR_C1RXIF],rxIf);
+	sim_wr32(&ptrSim->mem[ADDR_C1TXREQ],txReq);
+	ptrSim->mem[ADDR_C1INT] = (ptrSim->mem[ADDR_C1INT] & ~0x02) | ((rxIf != 0) << 1);
+}
+/**************************************************************************************************
+Purpose: 	Sends all msg objects loaded in TXQ/FIFOm to the bus (advances the time base of every
+				channel by SIMTBCFRAME per frame)
+**************************************************************************************************/
+static void sim_tx(simChn *ptrSim,uint8_t chnNum,uint8_t m){
+	uint8_t c;
+	const uint8_t *ptrObj;
+
+	ptrSim->mem[SIMCON(m)+1] &= ~(1<<TXREQ);
+	while(ptrSim->cnt[m]){
+		ptrObj = &ptrSim->mem[SIMRAM + ptrSim->base[m] + ptrSim->head[m]*ptrSim->objLen[m]];
+		ptrSim->head[m] = (ptrSim->head[m] + 1) % ptrSim->depth[m];
+		ptrSim->cnt[m]--;
+		ptrSim->txFrames++;
+		for(c=0;c<SIMCHNS;c++){
+			if(simChnTbl[c].mem[ADDR_C1TSCON+2] & 1)				// TBCEN=1
+				sim_wr32(&simChnTbl[c].mem[ADDR_C1TBC],sim_rd32(&simChnTbl[c].mem[ADDR_C1TBC]) + SIMTBCFRAME);
+		}
+		simBus(chnNum,ptrObj);
+	}
+}
+/**************************************************************************************************
+Purpose: 	Applies a C1CON REQOP write: OPMOD follows at once. Entering configuration mode resets
+				all FIFOs; leaving it (re)allocates message RAM & completes pending FRESETs.
+**************************************************************************************************/
+static void sim_mode(simChn *ptrSim,uint8_t chnNum,uint8_t mode){
+	uint8_t m;
+
+	if(mode == ptrSim->opMode)
+		return;
+	if(mode == CANMODE_CONFIG){
+		for(m=0;m<32;m++){
+			ptrSim->head[m] = 0;
+			ptrSim->cnt[m] = 0;
+			ptrSim->mem[SIMCON(m)+1] &= ~(1<<TXREQ);
+		}
+	}
+	else if(ptrSim->opMode == CANMODE_CONFIG){
+		sim_alloc(ptrSim);
+		for(m=0;m<32;m++)
+			ptrSim->mem[SIMCON(m)+1] &= ~(1<<FRESET);
+		ptrSim->mem[ADDR_C1TEFCON+1] &= ~(1<<FRESET);
+	}
+	ptrSim->opMode = mode;
+	ptrSim->mem[ADDR_C1CON+2] = (ptrSim->mem[ADDR_C1CON+2] & 0x1F) | (mode << 5);
+	if(sim_mode_tx(mode)){											// send TX requests held while not sending
+		for(m=0;m<32;m++){
+			if(ptrSim->depth[m] && sim_is_tx(ptrSim,m) && ((ptrSim->mem[SIMCON(m)+1] >> TXREQ) & 1))
+				sim_tx(ptrSim,chnNum,m);
+		}
+	}
+}
+/**************************************************************************************************
+Purpose: 	Applies a write to TXQCON/FIFOCONm byte 1 (UINC, TXREQ, FRESET)
+**************************************************************************************************/
+static void sim_fifo_ctl(simChn *ptrSim,uint8_t chnNum,uint8_t m,uint8_t data){
+	uint8_t *ctl = &ptrSim->mem[SIMCON(m)+1];
+
+	if(ptrSim->opMode == CANMODE_CONFIG){							// FIFOs are held in reset
+		*ctl = data & (1<<FRESET);
+		return;
+	}
+	if((data >> FRESET) & 1){
+		ptrSim->head[m] = 0;
+		ptrSim->cnt[m] = 0;
+	}
+	if(((data >> UINC) & 1) && ptrSim->depth[m]){
+		if(sim_is_tx(ptrSim,m)){									// TX - object loaded
+			if(ptrSim->cnt[m] < ptrSim->depth[m])
+				ptrSim->cnt[m]++;
+		}
+		else if(ptrSim->cnt[m]){									// RX - object read
+			ptrSim->head[m] = (ptrSim->head[m] + 1) % ptrSim->depth[m];
+			ptrSim->cnt[m]--;
+		}
+	}
+	*ctl = data & (1<<TXREQ);										// TXREQ held until sent, TXREQ=0 aborts
+	if(*ctl && ptrSim->depth[m] && sim_is_tx(ptrSim,m) && sim_mode_tx(ptrSim->opMode))
+		sim_tx(ptrSim,chnNum,m);
+}
+/**************************************************************************************************
+Purpose: 	Applies 1 byte written over SPI
+**************************************************************************************************/
+static void sim_write(simChn *ptrSim,uint8_t chnNum,uint16_t addr,uint8_t data){
+	uint8_t m, r;
+
+	if(addr == ADDR_C1CON+2){										// OPMOD is read only
+		ptrSim->mem[addr] = (data & 0x1F) | (ptrSim->opMode << 5);
+		return;
+	}
+	if(addr == ADDR_C1CON+3){										// REQOP
+		ptrSim->mem[addr] = data;
+		sim_mode(ptrSim,chnNum,data & 0x07);
+		return;
+	}
+	if(addr == ADDR_C1TEFCON+1){
+		ptrSim->mem[addr] = (ptrSim->opMode == CANMODE_CONFIG) ? (data & (1<<FRESET)) : 0;
+		return;
+	}
+	if(addr >= SIMCON(0) && addr < SIMCON(32)){
+		m = (addr - SIMCON(0)) / 12;
+		r = (addr - SIMCON(0)) % 12;
+		if(r >= 4)													// FIFOSTA/FIFOUA (status & flags)
+			return;
+		if(r == 1){
+			sim_fifo_ctl(ptrSim,chnNum,m,data);
+			return;
+		}
+		if(ptrSim->opMode != CANMODE_CONFIG){						// TXEN/RTREN/RXTSEN, FSIZE & PLSIZE config mode only
+			if(r == 3)
+				return;
+			if(r == 0)
+				data = (data & 0x1F) | (ptrSim->mem[addr] & 0xE0);
+		}
+	}
+	ptrSim->mem[addr] = data;
+}
+/**************************************************************************************************
+Purpose: 	Resets a channel (SPI RESET cmd): registers to their reset values, configuration mode
+**************************************************************************************************/
+static void sim_chn_reset(simChn *ptrSim){
+	uint8_t m;
+
+	memset(ptrSim,0,sizeof(simChn));
+	sim_wr32(&ptrSim->mem[ADDR_C1CON],0x04980760UL);				// C1CON reset value (REQOP=OPMOD=4)
+	ptrSim->opMode = CANMODE_CONFIG;
+	for(m=1;m<32;m++)
+		ptrSim->mem[SIMCON(m)+2] = 0x60;							// TXAT=3
+}
+/**************************************************************************************************
+Purpose: 	Resets both channels, the SPI decoder & counters; frames are looped between channels
+Inputs:		None
+Outputs:	None
+**************************************************************************************************/
+void sim_reset(void){
+	uint8_t c;
+
+	for(c=0;c<SIMCHNS;c++)
+		sim_chn_reset(&simChnTbl[c]);
+	simBus = sim_bus_loop;
+	simBytes = 0;
+	simCs = 0;
+	simSel = 0;
+	simState = 0;
+	simCyc = 0;
+}
+/**************************************************************************************************
+Purpose: 	Points to a byte of the simulated address space (e.g. to set C1TREC/C1BDIAG counters)
+Inputs:		chnNum	- channel (1 or 2)
+			addr	- 12 bit address
+Outputs:	pointer to the byte
+**************************************************************************************************/
+uint8_t *sim_reg(uint8_t chnNum,uint16_t addr){
+	return &simChnTbl[(chnNum > 1)].mem[addr & (SIMMEMSIZE-1)];
+}
+/**************************************************************************************************
+Purpose: 	Returns the #of payload bytes of a msg object (T1 DLC/FDF, multiple of 4)
+**************************************************************************************************/
+uint8_t sim_obj_len(const uint8_t *ptrObj){
+	uint8_t dlc = ptrObj[4] & 0x0F;
+
+	if(!((ptrObj[4] >> 7) & 1) && dlc > 8)							// CAN 2.0 DLC 9-15 = 8 bytes
+		dlc = 8;
+	return simDlcMem[dlc];
+}
+/**************************************************************************************************
+Purpose: 	Receives a frame on a channel: 1st enabled filter that matches selects the FIFO. A TX
+				FIFO with RTREN=1 answers a matching remote frame with its loaded msg.
+Inputs:		chnNum	- channel (1 or 2)
+			*ptrObj	- msg object (T0,T1,payload)
+Outputs:	1 = frame stored/answered; 0 = dropped (no match, FIFO full or channel not receiving)
+**************************************************************************************************/
+uint8_t sim_rx(uint8_t chnNum,const uint8_t *ptrObj){
+	simChn *ptrSim = &simChnTbl[(chnNum > 1)];
+	unsigned long t0, fltrObj, fltrMsk;
+	uint8_t f, m, ide, len, *dst;
+
+	if(ptrSim->opMode == CANMODE_CONFIG || ptrSim->opMode == CANMODE_SLEEP){
+		ptrSim->rxDrop++;
+		return 0;
+	}
+	t0 = sim_rd32(ptrObj);
+	ide = (ptrObj[4] >> 4) & 1;
+	for(f=0;f<32;f++){
+		if(!((ptrSim->mem[C1FLTCON(0) + f] >> 7) & 1))				// FLTEN=0
+			continue;
+		fltrObj = sim_rd32(&ptrSim->mem[C1FLTOBJ(f)]);
+		fltrMsk = sim_rd32(&ptrSim->mem[C1MASK(f)]);
+		if((t0 ^ fltrObj) & fltrMsk & 0x1FFFFFFFUL)					// SID/EID/SID11 mismatch
+			continue;
+		if(((fltrMsk >> 30) & 1) && ((fltrObj >> 30) & 1) != ide)	// MIDE=1 -> EXIDE must match IDE
+			continue;
+
+		m = ptrSim->mem[C1FLTCON(0) + f] & 0x1F;					// FnBP
+		if(!m || !ptrSim->depth[m])
+			break;
+		if(sim_is_tx(ptrSim,m)){									// remote frame auto answer
+			if(((ptrObj[4] >> 5) & 1) && ((ptrSim->mem[SIMCON(m)] >> RTREN) & 1) && ptrSim->cnt[m]){
+				sim_tx(ptrSim,chnNum,m);
+				return 1;
+			}
+			break;
+		}
+		if(ptrSim->cnt[m] == ptrSim->depth[m]){						// overflow
+			ptrSim->mem[SIMSTA(m)] |= (1<<3);						// RXOVIF
+			break;
+		}
+		dst = &ptrSim->mem[SIMRAM + ptrSim->base[m] + ((ptrSim->head[m] + ptrSim->cnt[m]) % ptrSim->depth[m])*ptrSim->objLen[m]];
+		memcpy(dst,ptrObj,5);										// R0, R1 flags & DLC
+		dst[5] = (ptrObj[5] & 0x01) | (f << 3);						// ESI;FILHIT
+		dst[6] = 0;
+		dst[7] = 0;
+		len = 8;
+		if((ptrSim->mem[SIMCON(m)] >> RXTSEN) & 1){					// timestamp
+			memcpy(&dst[8],&ptrSim->mem[ADDR_C1TBC],4);
+			len = 12;
+		}
+		memcpy(&dst[len],&ptrObj[8],(sim_obj_len(ptrObj) < ptrSim->objLen[m] - len) ? sim_obj_len(ptrObj) : ptrSim->objLen[m] - len);
+		ptrSim->cnt[m]++;
+		ptrSim->rxFrames++;
+		return 1;
+	}
+	ptrSim->rxDrop++;
+	return 0;
+}
+/**************************************************************************************************
+Purpose: 	Default simBus: the frame reaches all other channels (listen only & restricted included,
+				FD frames dropped in normal CAN 2.0 mode) & the own channel in loopback modes
+Inputs:		chnNum	- sending channel (1 or 2)
+			*ptrObj	- msg object (T0,T1,payload)
+Outputs:	None
+**************************************************************************************************/
+void sim_bus_loop(uint8_t chnNum,const uint8_t *ptrObj){
+	uint8_t c, mode;
+	uint8_t own = (chnNum > 1);
+
+	mode = simChnTbl[own].opMode;
+	if(mode == CANMODE_INTLOOP || mode == CANMODE_EXTLOOP)
+		sim_rx(chnNum,ptrObj);
+	if(mode == CANMODE_INTLOOP)										// frame never reaches the bus
+		return;
+	for(c=0;c<SIMCHNS;c++){
+		if(c == own)
+			continue;
+		if(simChnTbl[c].opMode == CANMODE_NORMAL20 && ((ptrObj[4] >> 7) & 1))
+			continue;
+		sim_rx(c + 1,ptrObj);
+	}
+}
+
+/**************************************************************************************************
+qb_mcp251xfd_host.h hooks
+**************************************************************************************************/
+uint8_t mcp251xfd_host_xfer(uint8_t data){
+	simChn *ptrSim;
+	uint8_t rd = 0;
+
+	simBytes++;
+	simCyc += SIMCYCBYTE;
+	if(!simSel)														// no chip selected
+		return 0xFF;
+	ptrSim = &simChnTbl[simSel - 1];
+	if(simState == 0){												// cmd & addr bits 11:8
+		simCmd = data >> 4;
+		simAddr = (uint16_t)(data & 0x0F) << 8;
+		simState = 1;
+	}
+	else if(simState == 1){											// addr bits 7:0
+		simAddr |= data;
+		simState = 2;
+		if(simCmd == SPI_RESET)
+			sim_chn_reset(ptrSim);
+		else if(simCmd == SPI_READ)
+			sim_sync(ptrSim);
+	}
+	else{
+		if(simCmd == SPI_READ)
+			rd = ptrSim->mem[simAddr];
+		else if(simCmd == SPI_WRITE)
+			sim_write(ptrSim,simSel,simAddr,data);
+		simAddr = (simAddr + 1) & (SIMMEMSIZE-1);
+	}
+	return rd;
+}
+void mcp251xfd_host_cs(uint8_t chnNum,uint8_t level){
+	if(!level){
+		simSel = (chnNum > 1) + 1;
+		simState = 0;
+		simCs++;
+	}
+	else
+		simSel = 0;
+}
+uint8_t mcp251xfd_host_int(uint8_t chnNum){
+	simChn *ptrSim = &simChnTbl[(chnNum > 1)];
+	uint8_t m;
+
+	for(m=1;m<32;m++){
+		if(ptrSim->depth[m] && !sim_is_tx(ptrSim,m) && ptrSim->cnt[m])
+			return 0;												// RX FIFO not empty -> INT active (low)
+	}
+	return 1;
+}
+uint16_t mcp251xfd_host_cycles(void){
+	return simCyc;
+}
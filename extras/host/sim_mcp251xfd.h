@@ -0,0 +1,71 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#ifndef	SIM_MCP251XFD_H
+#define	SIM_MCP251XFD_H
+
+#include <inttypes.h>
+#ifdef __cplusplus
+
+extern "C"
+{
+
+#endif
+
+/**************************************************************************************************
+Simulated MCP2517FD (host builds only, supplies the qb_mcp251xfd_host.h hooks)
+  2 channels (CS 1 & 2) decoding the SPI RESET/READ/WRITE cmds against a 4k byte address space.
+  Modelled: C1CON REQOP -> OPMOD, FIFO RAM allocation on leaving configuration mode (TEF, TXQ,
+  FIFO1-31 by FSIZE/PLSIZE/RXTSEN), FIFOSTA/FIFOUA/FIFOCI, UINC/TXREQ/FRESET, filters & masks
+  (FLTCON/FLTOBJ/MASK), RX timestamps, RTREN auto answer & the INT pin (any RX FIFO not empty).
+  Frames sent thru TXREQ are handed to simBus (default: all other channels in a receiving mode,
+  plus the own channel in loopback modes). Not modelled: bit timing, arbitration, errors, TEF
+  objects, CRC/safe SPI cmds. Error counters (C1TREC/C1BDIAG) are plain memory: set them with
+  sim_reg() to play a bus.
+**************************************************************************************************/
+#define SIMCHNS			2				// #of simulated channels
+#define SIMMEMSIZE		0x1000			// 12 bit SPI address space
+#define SIMRAM			0x400			// 1st byte of message RAM
+#define SIMRAMSIZE		2048			// #of message RAM bytes
+#define SIMSPIBPS		1000000UL		// SPI bytes/s at Fosc/2 = 8MHz (used for modelled frames/s)
+#define SIMCYCBYTE		16				// Fosc cycles per SPI byte (mcp251xfd_host_cycles())
+#define SIMTBCFRAME		4000			// C1TBC ticks added per frame on the bus (100us at 40MHz)
+
+typedef struct{
+	uint8_t mem[SIMMEMSIZE];										// SFR, message RAM & OSC/IOCON address space
+	uint8_t head[32];												// TXQ/FIFOn index of the oldest msg object
+	uint8_t cnt[32];												// TXQ/FIFOn #of msg objects loaded
+	uint8_t depth[32];												// TXQ/FIFOn #of msg objects allocated (0 = none)
+	uint8_t objLen[32];												// TXQ/FIFOn bytes per msg object
+	uint16_t base[32];												// TXQ/FIFOn RAM offset of msg object 0 (from SIMRAM)
+	uint8_t opMode;													// current OPMOD (CANMODE_x)
+	unsigned long txFrames;											// #of frames sent to the bus
+	unsigned long rxFrames;											// #of frames stored in RX FIFOs
+	unsigned long rxDrop;											// #of frames not matching a filter or hitting a full FIFO
+} simChn;
+
+extern simChn		simChnTbl[SIMCHNS];
+extern void 		(*simBus)(uint8_t chnNum,const uint8_t *ptrObj);	// frame sent by chnNum (T0,T1,payload)
+extern unsigned long simBytes;										// #of SPI bytes clocked (all channels)
+extern unsigned long simCs;											// #of CS assertions (all channels)
+
+void 			sim_reset(void);
+uint8_t 		*sim_reg(uint8_t chnNum,uint16_t addr);
+uint8_t 		sim_rx(uint8_t chnNum,const uint8_t *ptrObj);
+void 			sim_bus_loop(uint8_t chnNum,const uint8_t *ptrObj);
+uint8_t 		sim_obj_len(const uint8_t *ptrObj);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// SIM_MCP251XFD_H
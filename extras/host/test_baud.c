@@ -0,0 +1,105 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+/**************************************************************************************************
+Host test - canbaud_start()/canbaud_poll() bit rate detection against a played bus
+  The simulated controller does not model bit timing, so every BAUDSTEP ms the test plays the bus
+  into the C1BDIAG counters from the bit timing channel 1 is set to: a matching nominal rate adds
+  1 error free msg (plus 1 data phase RX error if the bus sends BRS frames & the data phase rate
+  differs, or is 4M without automatic TDC), a wrong nominal rate adds 3 nominal RX errors. Checked:
+  the locked rates, the detection time (tLock, in played ms - not a hardware figure), TDC on for a
+  4M data phase & BAUDFAIL on an idle bus.
+**************************************************************************************************/
+#include <stdio.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_mcp251xfd_defs.h"
+#include "qb_canbaud.h"
+#include "sim_mcp251xfd.h"
+
+#define BAUDSTEP		2				// ms between canbaud_poll() calls (1 bus msg per step)
+#define BAUDDWELL		50				// dwell time per candidate (ms)
+#define BAUDLIMIT		5000			// ms before the test gives up
+#define BUSIDLE			0xFF			// busSpeed - no msgs on the bus (CANSPEED_1000 is 0)
+
+static unsigned long fails;
+
+static void check(int ok,const char *what){
+	if(!ok && fails++ < 10)
+		printf("FAIL %s\n",what);
+}
+/**************************************************************************************************
+Purpose: 	C1NBTCFG/C1DBTCFG TSEG1 (byte 2) of a rate (unique per rate in the driver tables)
+**************************************************************************************************/
+static uint8_t nom_tseg1(uint8_t speed){
+	return (speed == CANSPEED_125) ? 0xFE : (speed == CANSPEED_250) ? 0x7E : (speed == CANSPEED_1000) ? 0x1E : 0x3E;
+}
+static uint8_t data_tseg1(uint8_t dataSpeed){
+	return (dataSpeed == CANDATA_1M) ? 0x1E : (dataSpeed == CANDATA_4M) ? 0x06 : 0x0E;
+}
+/**************************************************************************************************
+Purpose: 	Runs detection on a played bus (busSpeed BUSIDLE = idle bus;brs = bus sends BRS frames)
+Outputs:	canbaud_poll() result
+**************************************************************************************************/
+static uint8_t baud_run(baudCAN *ptrBaud,chnCAN *ptrChn,uint8_t busSpeed,uint8_t busData,uint8_t brs){
+	uint8_t *diag = sim_reg(1,ADDR_C1BDIAG0);						// C1BDIAG0 (NRERRCNT,NTERRCNT,DRERRCNT,DTERRCNT) & C1BDIAG1
+	uint8_t dataOk, result;
+	unsigned long t = 0;
+
+	result = canbaud_start(ptrBaud,ptrChn,BAUDDWELL,t);
+	while((result == BAUDBUSY) && (t < BAUDLIMIT)){
+		t += BAUDSTEP;
+		if((busSpeed != BUSIDLE) && (*sim_reg(1,ADDR_C1NBTCFG+2) == nom_tseg1(busSpeed))){
+			diag[4]++;												// EFMSGCNT
+			dataOk = (*sim_reg(1,ADDR_C1DBTCFG+2) == data_tseg1(busData)) &&
+					 ((busData != CANDATA_4M) || ((*sim_reg(1,ADDR_C1TDC+2) & 0x03) == 2));
+			if(brs && !dataOk)
+				diag[2]++;											// DRERRCNT
+		}
+		else if(busSpeed != BUSIDLE)
+			diag[0] += 3;											// NRERRCNT
+		result = canbaud_poll(ptrBaud,t);
+	}
+	return result;
+}
+
+int main(void){
+	chnCAN can1;
+	baudCAN baud;
+
+	sim_reset();
+	check(!mcp251xfd_init(CANSPEED_500,&can1,1,TXQ,FIFO1),"init");
+
+	// 250k/1M: 500k dropped early, 250k locked early, 2M dropped on data errors, 1M clean for a dwell
+	check(baud_run(&baud,&can1,CANSPEED_250,CANDATA_1M,1) == BAUDLOCKED,"250k/1M locked");
+	check(baud.speed == CANSPEED_250 && baud.dataSpeed == CANDATA_1M,"250k/1M rates");
+	check(baud.tLock == 66,"250k/1M lock time 66 ms");
+	check(simChnTbl[0].opMode == CANMODE_LISTEN,"left in listen only");
+	printf("250k/1M locked in %lu ms (dwell %u ms, %u ms polls)\n",baud.tLock,BAUDDWELL,BAUDSTEP);
+
+	// 500k/4M: 4M only receives error free with automatic TDC
+	check(baud_run(&baud,&can1,CANSPEED_500,CANDATA_4M,1) == BAUDLOCKED,"500k/4M locked");
+	check(baud.speed == CANSPEED_500 && baud.dataSpeed == CANDATA_4M,"500k/4M rates");
+	check((*sim_reg(1,ADDR_C1TDC+2) & 0x03) == 2 && *sim_reg(1,ADDR_C1TDC+1) == 7,"4M TDCMOD=2 TDCO=7");
+	printf("500k/4M locked in %lu ms\n",baud.tLock);
+
+	// 1M without BRS frames keeps 2M, TDC off
+	check(baud_run(&baud,&can1,CANSPEED_1000,CANDATA_2M,0) == BAUDLOCKED,"1M locked");
+	check(baud.speed == CANSPEED_1000 && baud.dataSpeed == CANDATA_2M,"1M keeps 2M");
+	check(!(*sim_reg(1,ADDR_C1TDC+2) & 0x03),"2M TDC off");
+
+	// idle bus
+	check(baud_run(&baud,&can1,BUSIDLE,0,0) == BAUDFAIL,"idle bus fails");
+
+	printf("%s (%lu failures)\n",fails ? "FAIL" : "PASS",fails);
+	return fails != 0;
+}
@@ -0,0 +1,80 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+/**************************************************************************************************
+Host test - qb_cancyc msgs due in the same tick against the simulated controller
+  simBus counts the frames sent by channel 1. Checked: 2 msgs with the same period & offset sent every
+  period without a missed transmission from a 2 msg deep TX FIFO (mcp251xfd_txfifo_depth(), 1 transmit
+  request per tick) & from the 1 msg deep TXQ (a full load sends the tick so far & loads the msg again).
+**************************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_cancyc.h"
+#include "sim_mcp251xfd.h"
+
+#define CYCPERIOD		10				// period of both msgs (ticks)
+#define CYCROUNDS		5				// #of periods run
+
+static unsigned long sentCnt;
+static unsigned long fails;
+
+static void check(int ok,const char *what){
+	if(!ok && fails++ < 10)
+		printf("FAIL %s\n",what);
+}
+/**************************************************************************************************
+Purpose: 	simBus - counts the frames sent by channel 1
+**************************************************************************************************/
+static void cyc_bus(uint8_t chnNum,const uint8_t *ptrObj){
+	(void)ptrObj;
+	if(chnNum == 1)
+		sentCnt++;
+}
+/**************************************************************************************************
+Purpose: 	Runs 2 msgs due in the same tick from a TX buffer of channel 1
+**************************************************************************************************/
+static void cyc_run(uint8_t bufIdx,const char *what){
+	chnCAN can1;
+	cycCAN cyc;
+	cycEntry entTbl[2];
+	msgCAN msgA, msgB;
+	uint8_t data[8] = {0};
+	uint16_t t;
+
+	sim_reset();
+	simBus = cyc_bus;
+	sentCnt = 0;
+	check(!mcp251xfd_init(CANSPEED_500,&can1,1,TXQ,FIFO1),what);
+	if(bufIdx != TXQ)
+		check(!mcp251xfd_txfifo_depth(&can1,bufIdx,0,0,2),what);
+	mcp251xfd_frame_prep(&msgA,0x100,0,0,0,0,8,data);
+	mcp251xfd_frame_prep(&msgB,0x101,0,0,0,0,8,data);
+	cancyc_init(&cyc,&can1,bufIdx,entTbl,2,40000);
+	check(!cancyc_add(&cyc,&msgA,CYCPERIOD,0) && !cancyc_add(&cyc,&msgB,CYCPERIOD,0),what);
+	for(t=0;t<CYCPERIOD*CYCROUNDS;t++){
+		cancyc_tick(&cyc);
+		cancyc_poll(&cyc);
+	}
+	check(!entTbl[0].missed && !entTbl[1].missed,what);
+	check(entTbl[0].sent == CYCROUNDS && entTbl[1].sent == CYCROUNDS && sentCnt == 2*CYCROUNDS,what);
+	printf("%s: sent=%lu missed=%u\n",what,sentCnt,entTbl[0].missed + entTbl[1].missed);
+}
+
+int main(void){
+	cyc_run(FIFO2,"2 msgs per tick from a 2 msg deep TX FIFO");
+	cyc_run(TXQ,"2 msgs per tick from the 1 msg deep TXQ");
+
+	printf("%s (%lu failures)\n",fails ? "FAIL" : "PASS",fails);
+	return fails != 0;
+}
@@ -0,0 +1,77 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+/**************************************************************************************************
+Host test - candec_add()/candec_rx() DECCHANGE against caller owned payload buffers (no controller)
+  Checked: ERR_DECBUF without a buffer, an unchanged payload dropped & a changed byte or length kept,
+  a payload longer than the rule's buffer always kept without writing past the buffer, & the buffer
+  following its rule when a rule with a lower ID is inserted before it.
+**************************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_candec.h"
+
+static unsigned long fails;
+
+static void check(int ok,const char *what){
+	if(!ok && fails++ < 10)
+		printf("FAIL %s\n",what);
+}
+/**************************************************************************************************
+Purpose: 	Builds a received msg of an ID with pLen bytes of value val
+**************************************************************************************************/
+static msgCAN *dec_msg(msgCAN *ptrMsg,unsigned long idWord,uint8_t pLen,uint8_t val){
+	memset(ptrMsg,0,sizeof(msgCAN));
+	mcp251xfd_hdr_pack(&ptrMsg->sid07_00,idWord,(pLen > 8) ? 0x80 | CANFD_LEN_DLC(pLen) : pLen);
+	ptrMsg->pLen = pLen;
+	memset(ptrMsg->rxData,val,pLen);
+	return ptrMsg;
+}
+
+int main(void){
+	decCAN dec;
+	decRule ruleTbl[4];
+	msgCAN msg;
+	uint8_t buf[8 + 1];												// 8 byte buffer + guard byte
+	decRule *ptrRule;
+
+	candec_init(&dec,ruleTbl,4,DECALL);
+	check(candec_add(&dec,0x200,DECCHANGE,8,0) == ERR_DECBUF,"DECCHANGE without a buffer");
+	check(candec_add(&dec,0x200,DECCHANGE,0,buf) == ERR_DECBUF,"DECCHANGE with a 0 byte buffer");
+	check(dec.cnt == 0,"no rule added on ERR_DECBUF");
+	buf[8] = 0xEE;
+	check(!candec_add(&dec,0x200,DECCHANGE,8,buf),"DECCHANGE rule");
+	check(!candec_add(&dec,0x300,DECNTH,2,0),"DECNTH rule without a buffer");
+
+	check(candec_rx(&dec,dec_msg(&msg,0x200,8,0x11)) == 1,"1st msg kept");
+	check(candec_rx(&dec,dec_msg(&msg,0x200,8,0x11)) == 0,"same payload dropped");
+	msg.rxData[7] = 0x12;
+	check(candec_rx(&dec,&msg) == 1,"changed byte kept");
+	check(candec_rx(&dec,dec_msg(&msg,0x200,4,0x11)) == 1,"changed length kept");
+
+	// payload longer than the buffer
+	check(candec_rx(&dec,dec_msg(&msg,0x200,16,0x22)) == 1,"long payload kept");
+	check(candec_rx(&dec,dec_msg(&msg,0x200,16,0x22)) == 1,"long payload kept again");
+	check(buf[8] == 0xEE,"buffer guard byte untouched");
+
+	// lower ID inserted: the DECCHANGE rule moves with its buffer
+	check(!candec_add(&dec,0x100,DECNTH,2,0),"insert lower ID");
+	ptrRule = candec_find(&dec,0x200);
+	check(ptrRule && ptrRule->ptrData == buf,"buffer follows its rule");
+	check(candec_rx(&dec,dec_msg(&msg,0x200,8,0x33)) == 1 && candec_rx(&dec,&msg) == 0,"compare after the move");
+	check(ptrRule->kept == 6 && ptrRule->dropped == 2,"kept/dropped counters");
+
+	printf("%s (%lu failures)\n",fails ? "FAIL" : "PASS",fails);
+	return fails != 0;
+}
@@ -0,0 +1,107 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+/**************************************************************************************************
+Host test - qb_cangw batches against the simulated controller
+  simBus records the frames sent by channel 2. Checked: a batch of 4 msgs forwarded from channel 1 to
+  a 4 msg deep TX FIFO (mcp251xfd_txfifo_depth()) with 1 transmit request & to the 1 msg deep TXQ (each
+  full load sends the batch so far & loads the msg again), in order & without losses, & a CAN 2.0
+  frame with DLC 12 converted to CAN FD (GWFD) with DLC 8.
+**************************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_cangw.h"
+#include "sim_mcp251xfd.h"
+
+#define GWBATCH			4				// #of msgs per batch
+
+static unsigned long sentId[8];
+static uint8_t sentT1[8];
+static uint8_t sentCnt;
+static unsigned long fails;
+
+static void check(int ok,const char *what){
+	if(!ok && fails++ < 10)
+		printf("FAIL %s\n",what);
+}
+/**************************************************************************************************
+Purpose: 	simBus - records the frames sent by channel 2
+**************************************************************************************************/
+static void gw_bus(uint8_t chnNum,const uint8_t *ptrObj){
+	if((chnNum != 2) || (sentCnt >= 8))
+		return;
+	sentId[sentCnt] = mcp251xfd_hdr_unpack(ptrObj);
+	sentT1[sentCnt++] = ptrObj[4];
+}
+/**************************************************************************************************
+Purpose: 	Puts a CAN 2.0 frame into the channel 1 RX FIFO
+**************************************************************************************************/
+static void gw_rx(unsigned long idWord,uint8_t dlc){
+	uint8_t obj[16];
+
+	memset(obj,0,sizeof(obj));
+	mcp251xfd_hdr_pack(obj,idWord,dlc);
+	sim_rx(1,obj);
+}
+/**************************************************************************************************
+Purpose: 	Forwards a batch of GWBATCH msgs from channel 1 to a TX buffer of channel 2
+**************************************************************************************************/
+static void gw_batch(uint8_t txBuf,const char *what){
+	chnCAN can1, can2;
+	gwCAN gw;
+	gwRoute routeTbl[2];
+	uint8_t idx, ok;
+
+	sim_reset();
+	simBus = gw_bus;
+	sentCnt = 0;
+	check(!mcp251xfd_init(CANSPEED_500,&can1,1,TXQ,FIFO1) && !mcp251xfd_init(CANSPEED_500,&can2,2,TXQ,FIFO1),what);
+	check(!mcp251xfd_fltr_setup(&can1,FIFO1,FLTRNUM0,FLTRIDX0,FLTRSID,0,0),what);
+	if(txBuf != TXQ)
+		check(!mcp251xfd_txfifo_depth(&can2,txBuf,0,0,GWBATCH),what);
+	cangw_init(&gw,&can1,FIFO1,TXQ,&can2,FIFO1,txBuf,routeTbl,2,GWBATCH);
+	check(!cangw_add(&gw,0,0,0,1,0,0),what);
+	for(idx=0;idx<GWBATCH;idx++)
+		gw_rx(0x100 + idx,8);
+	check(cangw_poll(&gw) == GWBATCH,what);
+	ok = (gw.fwd[0] == GWBATCH) && !gw.txFull && (sentCnt == GWBATCH);
+	for(idx=0;ok && (idx<GWBATCH);idx++)
+		ok = (sentId[idx] == 0x100UL + idx);
+	check(ok,what);
+	printf("%s: fwd=%lu txFull=%lu sent=%u\n",what,gw.fwd[0],gw.txFull,sentCnt);
+}
+
+int main(void){
+	chnCAN can1, can2;
+	gwCAN gw;
+	gwRoute routeTbl[2];
+
+	gw_batch(FIFO2,"batch into a 4 msg deep TX FIFO");
+	gw_batch(TXQ,"batch into the 1 msg deep TXQ");
+
+	// GWFD: CAN 2.0 DLC 9-15 means 8 bytes, sent as CAN FD DLC 8
+	sim_reset();
+	simBus = gw_bus;
+	sentCnt = 0;
+	check(!mcp251xfd_init(CANSPEED_500,&can1,1,TXQ,FIFO1) && !mcp251xfd_init(CANSPEED_500,&can2,2,TXQ,FIFO1),"init");
+	check(!mcp251xfd_fltr_setup(&can1,FIFO1,FLTRNUM0,FLTRIDX0,FLTRSID,0,0),"filter");
+	cangw_init(&gw,&can1,FIFO1,TXQ,&can2,FIFO1,TXQ,routeTbl,2,GWBATCH);
+	check(!cangw_add(&gw,0,0,0,1,GWFD,0),"GWFD route");
+	gw_rx(0x300,12);
+	check(cangw_poll(&gw) == 1 && sentCnt == 1,"DLC 12 frame forwarded");
+	check((sentT1[0] & CANFRAME_FD) && ((sentT1[0] & 0x0F) == 8),"CAN FD DLC 8");
+
+	printf("%s (%lu failures)\n",fails ? "FAIL" : "PASS",fails);
+	return fails != 0;
+}
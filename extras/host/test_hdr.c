@@ -0,0 +1,109 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+/**************************************************************************************************
+Host test - mcp251xfd_hdr_pack()/mcp251xfd_hdr_unpack() ID word <-> T0/T1 codec
+  Standard & extended ID boundaries against the T0 bytes of the MCP2517FD message object layout
+  (SID[10:0] in T0 bits 10:0, EID[17:0] in T0 bits 28:11, extended ID = SID << 18 | EID), then a
+  randomized round trip (fixed seed) checked against a per field reference decoder.
+**************************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "qb_mcp251xfd.h"
+
+#define FUZZCNT			1000000UL		// #of random round trips
+
+static unsigned long fails;
+static unsigned long lcg = 1;										// random state (fixed seed)
+
+static unsigned long rnd(void){
+	lcg = lcg * 1103515245UL + 12345UL;
+	return (lcg >> 8) & 0xFFFFFFUL;
+}
+static void check(int ok,const char *what,unsigned long idWord){
+	if(!ok && fails++ < 10)
+		printf("FAIL %s (ID word 0x%08lX)\n",what,idWord);
+}
+/**************************************************************************************************
+Purpose: 	Reference decoder: ID from the T0 fields one at a time
+**************************************************************************************************/
+static unsigned long ref_id(const uint8_t *ptrObj){
+	unsigned long sid = ptrObj[0] | ((unsigned long)(ptrObj[1] & 0x07) << 8);
+	unsigned long eid = (ptrObj[1] >> 3) | ((unsigned long)ptrObj[2] << 5) | ((unsigned long)(ptrObj[3] & 0x1F) << 13);
+
+	return ((ptrObj[4] >> 4) & 1) ? ((sid << 18) | eid | CANID_EXT) : sid;
+}
+/**************************************************************************************************
+Purpose: 	Packs an ID word & checks T0 bytes, IDE, the round trip & the reference decoder
+**************************************************************************************************/
+static void check_bytes(unsigned long idWord,uint8_t b0,uint8_t b1,uint8_t b2,uint8_t b3){
+	uint8_t obj[8];
+
+	memset(obj,0xA5,sizeof(obj));
+	mcp251xfd_hdr_pack(obj,idWord,CANFRAME_FD | CANFRAME_BRS | 15);
+	check(obj[0] == b0 && obj[1] == b1 && obj[2] == b2 && obj[3] == b3,"T0 bytes",idWord);
+	check(((obj[4] >> 4) & 1) == (idWord >> 31),"IDE",idWord);
+	check((obj[4] & ~CANFRAME_EXT) == (CANFRAME_FD | CANFRAME_BRS | 15),"T1 flags & DLC",idWord);
+	check(!obj[5] && !obj[6] && !obj[7],"T1 SEQ cleared",idWord);
+	check(mcp251xfd_hdr_unpack(obj) == idWord,"round trip",idWord);
+	check(ref_id(obj) == idWord,"reference decode",idWord);
+}
+
+int main(void){
+	unsigned long idx, id, idWord;
+	uint8_t obj[8], t1;
+	msgCAN msg;
+	uint8_t buf[8] = {0};
+
+	// standard ID: SID in T0 bits 10:0, EID 0
+	check_bytes(0x000,0x00,0x00,0x00,0x00);
+	check_bytes(0x001,0x01,0x00,0x00,0x00);
+	check_bytes(0x400,0x00,0x04,0x00,0x00);
+	check_bytes(0x7FF,0xFF,0x07,0x00,0x00);
+	// extended ID: ID[28:18] -> SID, ID[17:0] -> EID
+	check_bytes(CANID_EXT | 0x00000000UL,0x00,0x00,0x00,0x00);
+	check_bytes(CANID_EXT | 0x00000001UL,0x00,0x08,0x00,0x00);		// EID bit 0 = T0 bit 11
+	check_bytes(CANID_EXT | 0x000007FFUL,0x00,0xF8,0x3F,0x00);		// low ID bits stay in EID
+	check_bytes(CANID_EXT | 0x0003FFFFUL,0x00,0xF8,0xFF,0x1F);		// EID all 1s, SID 0
+	check_bytes(CANID_EXT | 0x00040000UL,0x01,0x00,0x00,0x00);		// SID bit 0 = ID bit 18
+	check_bytes(CANID_EXT | 0x1FFC0000UL,0xFF,0x07,0x00,0x00);		// SID all 1s, EID 0
+	check_bytes(CANID_EXT | 0x1FFFFFFFUL,0xFF,0xFF,0xFF,0x1F);		// all 29 bits
+	check_bytes(CANID_EXT | 0x18DAF110UL,0x36,0x86,0x88,0x17);		// OBD2 physical response ID (SID 0x636, EID 0x2F110)
+
+	// ID bits above the ID word are ignored, SID11 (T0 bit 29) stays 0
+	mcp251xfd_hdr_pack(obj,CANID_EXT | 0x1FFFFFFFUL,0);
+	check(!(obj[3] & 0xE0),"T0 bits 31:29",CANID_EXT | 0x1FFFFFFFUL);
+
+	// frame_prep: IDs > 0x7FF are sent extended even with ide=0
+	mcp251xfd_frame_prep(&msg,0x800,0,0,0,0,8,buf);
+	check(msg.ide && mcp251xfd_msg_id(&msg) == 0x800,"frame_prep 0x800 ide=0",0x800);
+	mcp251xfd_frame_prep(&msg,0x7FF,0,0,0,0,8,buf);
+	check(!msg.ide && mcp251xfd_msg_id(&msg) == 0x7FF,"frame_prep 0x7FF ide=0",0x7FF);
+	mcp251xfd_frame_prep(&msg,0x7FF,1,0,0,0,8,buf);
+	check(msg.ide && mcp251xfd_msg_id(&msg) == 0x7FF,"frame_prep 0x7FF ide=1",CANID_EXT | 0x7FF);
+
+	// randomized round trip
+	for(idx=0;idx<FUZZCNT;idx++){
+		id = ((rnd() << 8) ^ rnd()) & CANID_MASK;
+		idWord = (rnd() & 1) ? (id | CANID_EXT) : (id & 0x7FF);
+		t1 = rnd() & ~CANFRAME_EXT;
+		mcp251xfd_hdr_pack(obj,idWord,t1);
+		check(mcp251xfd_hdr_unpack(obj) == idWord,"fuzz round trip",idWord);
+		check(ref_id(obj) == idWord,"fuzz reference decode",idWord);
+		check((obj[4] & ~CANFRAME_EXT) == t1,"fuzz T1 flags & DLC",idWord);
+		check(!(obj[3] & 0xE0),"fuzz T0 bits 31:29",idWord);
+	}
+
+	printf("%s (%lu failures)\n",fails ? "FAIL" : "PASS",fails);
+	return fails != 0;
+}
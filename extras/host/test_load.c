@@ -0,0 +1,73 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+/**************************************************************************************************
+Host test - canload_add()/canload_update() sliding window with mixed timestamp sources
+  Frames are accounted with played timestamps (no controller needed): LOADFRAMES classic 8 byte
+  frames per bucket for a full window, then the window is moved on by a TBC style canload_update()
+  & a frame whose RX timestamp is older than the current bucket start is added. Checked: the load of
+  the full window, the late frame accounted into the current bucket without resetting the window &
+  a window left idle for longer than its length reading 0.
+**************************************************************************************************/
+#include <stdio.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_canload.h"
+
+#define LOADWIN			80				// window length (ms)
+#define LOADFRAMES		10				// frames per bucket
+
+static unsigned long fails;
+
+static void check(int ok,const char *what){
+	if(!ok && fails++ < 10)
+		printf("FAIL %s\n",what);
+}
+
+int main(void){
+	loadCAN load;
+	unsigned long bkt, t, frameTicks;
+	uint16_t nomBits, datBits, full;
+	uint8_t idx, jdx;
+
+	canload_init(&load,CANSPEED_500,CANFD_DBPS,LOADWIN);
+	bkt = load.bktTicks;
+	nomBits = canload_frame_bits(0,0,0,0,8,&datBits);
+	frameTicks = (unsigned long)nomBits * load.nomTq;
+
+	// full window of LOADFRAMES frames per bucket
+	canload_update(&load,0);
+	for(idx=0;idx<LOADBKTS;idx++){
+		for(jdx=0;jdx<LOADFRAMES;jdx++)
+			canload_add(&load,idx*bkt + jdx*1000UL,0,0,0,0,8);
+	}
+	canload_update(&load,LOADBKTS*bkt);
+	full = load.load;
+	check(full == LOADFRAMES*frameTicks / (bkt/1000),"full window load");
+	printf("window load %u.%u %%\n",full/10,full%10);
+
+	// TBC moved the window on, then an RX frame stamped before the bucket start arrives
+	t = LOADBKTS*bkt + bkt/2;
+	canload_update(&load,t);
+	canload_add(&load,LOADBKTS*bkt - 5000,0,0,0,0,8);
+	check(load.load == full,"late frame keeps the window load");
+	check(load.bktBusy[load.bktIdx] == frameTicks,"late frame in the current bucket");
+	canload_update(&load,(LOADBKTS + 1)*bkt);
+	check(load.load > 0,"load after the late frame");
+
+	// idle for longer than the window
+	canload_update(&load,(2*LOADBKTS + 2)*bkt);
+	check(load.load == 0,"idle window reads 0");
+
+	printf("%s (%lu failures)\n",fails ? "FAIL" : "PASS",fails);
+	return fails != 0;
+}
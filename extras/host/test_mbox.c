@@ -0,0 +1,74 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+/**************************************************************************************************
+Host test - canmbox_add()/canmbox_rx()/canmbox_read() slot handling (no controller needed)
+  Checked: a latest value read back from its slot, canmbox_read() of MBOXNONE from a full table &
+  of a mailbox whose canmbox_init() failed returning 0 without touching the caller's buffer. The slot
+  storage is followed by a guard slot that must stay unused.
+**************************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_canmbox.h"
+
+#define MBOXSLOTS		4				// #of slots given to canmbox_init()
+
+static unsigned long fails;
+
+static void check(int ok,const char *what){
+	if(!ok && fails++ < 10)
+		printf("FAIL %s\n",what);
+}
+/**************************************************************************************************
+Purpose: 	Builds a received msg of an ID with a 1 byte payload
+**************************************************************************************************/
+static void mbox_msg(msgCAN *ptrMsg,unsigned long idWord,uint8_t val){
+	memset(ptrMsg,0,sizeof(msgCAN));
+	mcp251xfd_hdr_pack(&ptrMsg->sid07_00,idWord,1);
+	ptrMsg->pLen = 1;
+	ptrMsg->rxData[0] = val;
+}
+
+int main(void){
+	mboxCAN mbox;
+	mboxSlot slotTbl[MBOXSLOTS + 1];
+	msgCAN msg;
+	uint8_t buf[MBOXLEN], len, slot, idx;
+
+	memset(slotTbl,0,sizeof(slotTbl));
+	check(!canmbox_init(&mbox,slotTbl,MBOXSLOTS),"init");
+	slot = canmbox_add(&mbox,0x100);
+	mbox_msg(&msg,0x100,0x42);
+	check(canmbox_rx(&mbox,&msg) == 1,"rx subscribed ID");
+	check(canmbox_read(&mbox,slot,buf,&len,0) && len == 1 && buf[0] == 0x42,"latest value read");
+
+	// full table: canmbox_add() gives MBOXNONE, reading it returns 0
+	for(idx=1;idx<MBOXSLOTS;idx++)
+		check(canmbox_add(&mbox,0x100 + idx) != MBOXNONE,"add");
+	slot = canmbox_add(&mbox,0x200);
+	check(slot == MBOXNONE,"full table gives MBOXNONE");
+	buf[0] = 0xA5;
+	len = 0xA5;
+	check(!canmbox_read(&mbox,slot,buf,&len,0) && buf[0] == 0xA5 && len == 0xA5,"read MBOXNONE returns 0");
+	check(!canmbox_read(&mbox,MBOXSLOTS,buf,&len,0),"read past the table returns 0");
+	check(slotTbl[MBOXSLOTS].id == 0 && slotTbl[MBOXSLOTS].seq == 0,"guard slot untouched");
+
+	// failed canmbox_init(): no slots
+	check(canmbox_init(&mbox,0,MBOXSLOTS) == ERR_MBOXSIZE,"init without storage fails");
+	check(canmbox_add(&mbox,0x100) == MBOXNONE,"add to a mailbox without slots");
+	check(!canmbox_read(&mbox,0,buf,&len,0),"read a mailbox without slots returns 0");
+
+	printf("%s (%lu failures)\n",fails ? "FAIL" : "PASS",fails);
+	return fails != 0;
+}
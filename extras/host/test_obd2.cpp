@@ -0,0 +1,191 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+/**************************************************************************************************
+Host test - obd2s1PidLen() & the qb_obd2cli client against simulated ECUs
+  simBus plays zero latency ECUs on channel 1: a service 0x01 request is answered with the data
+  bytes of every requested PID (obd2s1PidLen() long, byte value PID + index), as a single frame or a
+  first frame & consecutive frames after the flow control (ISO 15765-2). Checked: SAE J1979 PID
+  lengths, a multi PID response split after a PID with undecoded data bytes (0x50), the PID sample
+  rate of 2 ECUs (6 PIDs + 1 PID) re-armed on completion with a 1 ms obd2cli_poll() for 1 s of
+  simulated time (OBD2RATE; zero latency ECUs, so an upper bound - not a vehicle figure) & a repeated
+  ECU discovery (0x7DF answered by both ECUs) adding each ECU once, next to an obd2cli_add() request.
+**************************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_obd2.h"
+#include "qb_obd2cli.h"
+#include "sim_mcp251xfd.h"
+
+#define OBD2ECUS		2				// #of simulated ECUs (request IDs 0x7E0, 0x7E1)
+#define OBD2RATE		((1000 / 3) * 7)	// PID samples in 1 s: both ECUs done every 3rd poll (shared 1 msg TXQ)
+
+hostSerial Serial;
+
+typedef struct{
+	uint8_t rsp[OBD2RSPLEN];										// response being sent (0x41,PID,data..)
+	uint8_t len;													// #of response bytes
+	uint8_t pos;													// #of response bytes sent
+} simEcu;
+
+static simEcu ecuTbl[OBD2ECUS];
+static unsigned long fails;
+
+static void check(int ok,const char *what){
+	if(!ok && fails++ < 10)
+		printf("FAIL %s\n",what);
+}
+/**************************************************************************************************
+Purpose: 	Puts a classic 8 byte frame from an ECU into the channel 1 RX FIFO
+**************************************************************************************************/
+static void ecu_tx(unsigned long idWord,const uint8_t *ptrData){
+	uint8_t obj[16];
+
+	mcp251xfd_hdr_pack(obj,idWord,8);
+	memcpy(&obj[8],ptrData,8);
+	sim_rx(1,obj);
+}
+/**************************************************************************************************
+Purpose: 	An ECU answering a service 0x01 single frame request: single frame or first frame
+**************************************************************************************************/
+static void ecu_req(simEcu *ptrEcu,unsigned long rspId,const uint8_t *ptrData){
+	uint8_t frame[8], idx, jdx;
+
+	if((ptrData[0] > 7) || (ptrData[1] != 0x01))					// not a service 0x01 single frame
+		return;
+	ptrEcu->len = 0;
+	ptrEcu->rsp[ptrEcu->len++] = 0x41;
+	for(idx=2;idx<=ptrData[0];idx++){								// loop thru requested PIDs
+		ptrEcu->rsp[ptrEcu->len++] = ptrData[idx];
+		for(jdx=0;jdx<obd2s1PidLen(ptrData[idx]);jdx++)
+			ptrEcu->rsp[ptrEcu->len++] = ptrData[idx] + jdx;
+	}
+	memset(frame,0,8);
+	if(ptrEcu->len <= 7){											// single frame
+		frame[0] = ptrEcu->len;
+		memcpy(&frame[1],ptrEcu->rsp,ptrEcu->len);
+		ptrEcu->pos = ptrEcu->len;
+	}
+	else{															// first frame
+		frame[0] = 0x10;
+		frame[1] = ptrEcu->len;
+		memcpy(&frame[2],ptrEcu->rsp,6);
+		ptrEcu->pos = 6;
+	}
+	ecu_tx(rspId,frame);
+}
+/**************************************************************************************************
+Purpose: 	simBus - ECUs answering the frames sent by channel 1 (0x7DF = all ECUs, 0x7E0 + n = ECU n)
+**************************************************************************************************/
+static void ecu_bus(uint8_t chnNum,const uint8_t *ptrObj){
+	unsigned long idWord = mcp251xfd_hdr_unpack(ptrObj);
+	const uint8_t *ptrData = &ptrObj[8];
+	simEcu *ptrEcu;
+	uint8_t frame[8], idx, sn;
+
+	if((chnNum == 1) && (idWord == 0x7DF)){							// functional request
+		for(idx=0;idx<OBD2ECUS;idx++)
+			ecu_req(&ecuTbl[idx],0x7E8 + idx,ptrData);
+		return;
+	}
+	if((chnNum != 1) || (idWord < 0x7E0) || (idWord >= 0x7E0 + OBD2ECUS))
+		return;
+	ptrEcu = &ecuTbl[idWord - 0x7E0];
+	if((ptrData[0] >> 4) == 3){										// flow control - send the consecutive frames
+		for(sn=1;ptrEcu->pos < ptrEcu->len;sn++){
+			memset(frame,0,8);
+			frame[0] = 0x20 | (sn & 0x0F);
+			for(idx=1;(idx < 8) && (ptrEcu->pos < ptrEcu->len);idx++)
+				frame[idx] = ptrEcu->rsp[ptrEcu->pos++];
+			ecu_tx(idWord + 8,frame);
+		}
+		return;
+	}
+	ecu_req(ptrEcu,idWord + 8,ptrData);
+}
+
+int main(void){
+	chnCAN can1;
+	obd2Cli cli;
+	obd2Req reqTbl[4], discTbl[4];
+	obd2Val val;
+	const uint8_t *ptrData;
+	uint8_t pids6[6] = {0x0C,0x0D,0x05,0x04,0x11,0x0B}, pids1[1] = {0x0C}, pidsMix[3] = {0x50,0x0D,0x64};
+	uint8_t len, idx, pass;
+	unsigned long t, samples;
+
+	// SAE J1979 data byte counts
+	check(obd2s1PidLen(0x00) == 4 && obd2s1PidLen(0xA0) == 4,"bitmap PIDs 4 bytes");
+	check(obd2s1PidLen(0x01) == 4 && obd2s1PidLen(0x03) == 2,"undecoded PIDs 0x01/0x03");
+	check(obd2s1PidLen(0x0C) == 2 && obd2s1PidLen(0x0D) == 1,"PID 0x0C/0x0D");
+	check(obd2s1PidLen(0x50) == 4,"PID 0x50 4 bytes (only A decoded)");
+	check(obd2s1PidLen(0x4F) == 4 && obd2s1PidLen(0x64) == 5,"PID 0x4F/0x64");
+	check(obd2s1PidLen(0x68) == 0 && obd2s1PidLen(0xA1) == 0,"unknown lengths 0");
+
+	sim_reset();
+	simBus = ecu_bus;
+	check(!mcp251xfd_init(CANSPEED_500,&can1,1,TXQ,FIFO1),"init");
+	check(!mcp251xfd_fltr_setup(&can1,FIFO1,FLTRNUM0,FLTRIDX0,FLTRSID,0x7E8,0x7F8),"filter 0x7E8-0x7EF");
+	obd2cli_init(&cli,&can1,TXQ,FIFO1,reqTbl,4);
+	check(!obd2cli_add(&cli,0x7E0,pids6,6,0) && !obd2cli_add(&cli,0x7E1,pids1,1,0),"add");
+	check(!obd2cli_add(&cli,0x7E0,pidsMix,3,0),"add 0x50,0x0D,0x64");
+
+	// multi PID response split after PID 0x50 (A decoded, B-D skipped)
+	obd2cli_send(&cli,2);
+	for(t=0;(t<10) && (reqTbl[2].state != OBD2DONE);t++)
+		obd2cli_poll(&cli,t);
+	check(reqTbl[2].state == OBD2DONE,"mixed request done");
+	check(obd2cli_decode(&reqTbl[2],0x50,&val) == 1 && val.val[0] == 0x50 * 10,"0x50 decoded");
+	ptrData = obd2cli_data(&reqTbl[2],0x0D,&len);
+	check(ptrData && len == 1 && ptrData[0] == 0x0D,"0x0D found after 0x50");
+	check(obd2cli_decode(&reqTbl[2],0x64,&val) == 5 && val.val[4] == 0x64 + 4 - 125,"0x64 E byte");
+
+	// PID sample rate: re-arm each request as soon as it finishes
+	samples = 0;
+	obd2cli_send(&cli,0);
+	obd2cli_send(&cli,1);
+	for(t=100;t<1100;t++){
+		obd2cli_poll(&cli,t);
+		for(idx=0;idx<2;idx++){
+			if(reqTbl[idx].state < OBD2DONE)
+				continue;
+			if(reqTbl[idx].state == OBD2DONE)
+				samples += reqTbl[idx].pidCnt;
+			obd2cli_send(&cli,idx);
+		}
+	}
+	check(!cli.neg && !cli.tmo,"no negative responses or timeouts");
+	check(samples == OBD2RATE,"PID samples/s");
+	printf("%lu PID samples/s (6 + 1 PIDs, 1 ms poll, zero latency ECUs)\n",samples);
+
+	for(;((reqTbl[0].state < OBD2DONE) || (reqTbl[1].state < OBD2DONE)) && (t<1200);t++)
+		obd2cli_poll(&cli,t);											// finish the requests in flight
+
+	// repeated discovery: ECU 0x7E8 added once & refreshed, ECU 0x7E9 keeps its obd2cli_add() request
+	obd2cli_init(&cli,&can1,TXQ,FIFO1,discTbl,4);
+	check(!obd2cli_add(&cli,0x7E1,pids1,1,0),"add before discovery");
+	for(pass=0;pass<2;pass++){
+		check(!obd2cli_discover(&cli,OBD2DISC11,20,t),"discover");
+		for(;cli.disc && (t<2000);t++)
+			obd2cli_poll(&cli,t);
+		check(cli.cnt == 2,"1 request per ECU after discovery");
+		check(discTbl[1].rxId == 0x7E8 && discTbl[1].state == OBD2DONE,"ECU 0x7E8 bitmaps");
+		check(obd2cli_spt(&discTbl[1],0x10) && !obd2cli_spt(&discTbl[1],0x0F),"ECU 0x7E8 supported PIDs");
+		check(discTbl[0].pidCnt == 1 && discTbl[0].state == OBD2IDLE,"obd2cli_add() request kept");
+		discTbl[1].state = OBD2IDLE;
+	}
+
+	printf("%s (%lu failures)\n",fails ? "FAIL" : "PASS",fails);
+	return fails != 0;
+}
@@ -0,0 +1,121 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+/**************************************************************************************************
+Host test - canrtr_setup()/canrtr_refresh()/canrtr_reload() & canupd_write() UPDRAM against the
+  simulated controller. Channel 1 runs 2 remote frame responders (FIFO2 & FIFO3), channel 2 sends
+  the remote frames & reads the answers from FIFO1. Checked: the 2nd canrtr_setup() does not lose
+  the 1st response or count a phantom answer, in place payload updates reach the bus, & after a
+  configuration mode trip that moves message RAM (FIFO1 of channel 1 setup again as a 1 msg TX FIFO)
+  both the responders & an UPDRAM FIFO write their msg objects at the new address.
+**************************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_mcp251xfd_defs.h"
+#include "qb_canrtr.h"
+#include "qb_canupd.h"
+#include "sim_mcp251xfd.h"
+
+#define RTRID1			0x123			// ID answered by responder 1
+#define RTRID2			0x18DAF110UL	// ID answered by responder 2 (extended)
+
+static unsigned long fails;
+static chnCAN can1, can2;
+
+static void check(int ok,const char *what){
+	if(!ok && fails++ < 10)
+		printf("FAIL %s\n",what);
+}
+/**************************************************************************************************
+Purpose: 	Sends a remote frame from channel 2 & reads the answer
+Outputs:	1st payload byte of the answer; -1 = not answered
+**************************************************************************************************/
+static int rtr_ask(unsigned long id,uint8_t ide){
+	msgCAN req, rsp;
+	uint8_t buf[8] = {0};
+
+	mcp251xfd_frame_prep(&req,id,ide,0,0,1,8,buf);
+	if(mcp251xfd_write_frame(TXQ,&can2,&req) || mcp251xfd_start_transmit(TXQ,&can2))
+		return -1;
+	if(!simChnTbl[1].cnt[FIFO1])									// no answer in FIFO1
+		return -1;
+	if(mcp251xfd_read_frame(FIFO1,&can2,&rsp) || mcp251xfd_msg_id(&rsp) != id)
+		return -1;
+	return rsp.rxData[0];
+}
+/**************************************************************************************************
+Purpose: 	Reads the 1st payload byte of the msg object loaded in a channel 1 TX FIFO
+**************************************************************************************************/
+static int obj_byte(uint8_t bufIdx){
+	return simChnTbl[0].mem[SIMRAM + simChnTbl[0].base[bufIdx] + 8];
+}
+
+int main(void){
+	rtrCAN rtr1, rtr2;
+	updCAN upd;
+	msgCAN rsp1, rsp2, hot, rx;
+	uint8_t buf[8] = {0};
+	uint16_t base2;
+
+	sim_reset();
+	check(!mcp251xfd_init(CANSPEED_500,&can1,1,TXQ,FIFO1) && !mcp251xfd_init(CANSPEED_500,&can2,2,TXQ,FIFO1),"init");
+	check(!mcp251xfd_fltr_setup(&can2,FIFO1,FLTRNUM0,FLTRIDX0,FLTRBOTH,0,0),"channel 2 filter");
+	canupd_init(&upd,&can1,FIFO4,UPDRAM);
+	check(!mcp251xfd_txfifo_setup(&can1,FIFO4,0,0),"setup FIFO4");
+
+	// 2 responders: the 2nd setup's configuration mode trip empties FIFO2
+	buf[0] = 0x11;
+	mcp251xfd_frame_prep(&rsp1,RTRID1,0,0,0,0,8,buf);
+	buf[0] = 0x21;
+	mcp251xfd_frame_prep(&rsp2,RTRID2,1,0,0,0,8,buf);
+	check(!canrtr_setup(&rtr1,&can1,FIFO2,FLTRNUM1,FLTRIDX0,&rsp1),"setup responder 1");
+	check(!canrtr_setup(&rtr2,&can1,FIFO3,FLTRNUM1,FLTRIDX1,&rsp2),"setup responder 2");
+	check(!canrtr_refresh(&rtr1) && !canrtr_refresh(&rtr2),"1st refresh loads, no answer");
+	check(rtr1.answered == 0 && rtr2.answered == 0,"no phantom answer after 2 setups");
+	check(rtr_ask(RTRID1,0) == 0x11,"responder 1 answers");
+	check(rtr_ask(RTRID2,1) == 0x21,"responder 2 answers");
+	check(canrtr_refresh(&rtr1) == 1 && rtr1.answered == 1,"responder 1 answer counted");
+
+	// in place payload update of the loaded response
+	rsp1.txData[0] = 0x12;
+	check(!canrtr_refresh(&rtr1) && obj_byte(FIFO2) == 0x12,"in place update");
+	check(rtr_ask(RTRID1,0) == 0x12,"updated payload answered");
+	check(canrtr_refresh(&rtr1) == 1 && canrtr_refresh(&rtr2) == 1,"both answers counted");
+
+	// UPDRAM msg pending (listen only holds TXREQ), then a configuration mode trip moving message
+	// RAM: FIFO1 of channel 1 setup again as a 1 msg TX FIFO
+	buf[0] = 0x31;
+	mcp251xfd_frame_prep(&hot,0x200,0,0,0,0,8,buf);
+	check(!mcp251xfd_mode_req(&can1,CANMODE_LISTEN),"listen only");
+	check(canupd_write(&upd,&hot) == UPDNEW,"UPDRAM 1st write loads");
+	base2 = simChnTbl[0].base[FIFO2];
+	check(!mcp251xfd_txfifo_setup(&can1,FIFO1,0,0),"setup FIFO1 as TX FIFO");
+	check(simChnTbl[0].base[FIFO2] != base2,"message RAM moved");
+	check(canupd_write(&upd,&hot) == UPDNEW,"UPDRAM write after the trip loads");
+	hot.txData[0] = 0x32;
+	check(canupd_write(&upd,&hot) == UPDOVER && obj_byte(FIFO4) == 0x32,"UPDRAM overwrite at the new address");
+	check(!mcp251xfd_mode_req(&can1,CANMODE_NORMALFD),"normal mode");
+	check(!mcp251xfd_read_frame(FIFO1,&can2,&rx) && mcp251xfd_msg_id(&rx) == 0x200 && rx.rxData[0] == 0x32,"UPDRAM latest value sent");
+
+	// responders after the RAM move
+	check(!canrtr_reload(&rtr1) && !canrtr_reload(&rtr2),"reload");
+	check(rtr1.answered == 2 && rtr2.answered == 1,"reload not counted as answered");
+	rsp1.txData[0] = 0x13;
+	check(!canrtr_refresh(&rtr1) && obj_byte(FIFO2) == 0x13,"in place update at the new address");
+	check(rtr_ask(RTRID1,0) == 0x13,"answered after the RAM move");
+	check(rtr_ask(RTRID2,1) == 0x21,"responder 2 answered after the RAM move");
+
+	printf("%s (%lu failures)\n",fails ? "FAIL" : "PASS",fails);
+	return fails != 0;
+}
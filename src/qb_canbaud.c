@@ -0,0 +1,126 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+
+#include <stdint.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_mcp251xfd_defs.h"
+#include "qb_canbaud.h"
+
+static const uint8_t nomCand[] = {CANSPEED_500,CANSPEED_250,CANSPEED_125,CANSPEED_1000};	// most common 1st
+static const uint8_t dataCand[] = {CANDATA_2M,CANDATA_1M,CANDATA_4M};
+
+/**************************************************************************************************
+Purpose: 	Clears the bus diagnostic counters & restarts the dwell time
+Inputs:		*ptrBaud	- baudCAN pointer
+			tNow		- current time in ms
+
+Outputs:	None
+**************************************************************************************************/
+static void canbaud_clear(baudCAN *ptrBaud,unsigned long tNow){
+	uint8_t	regClr[8] = {0};										// C1BDIAG0,C1BDIAG1 cleared values
+
+	mcp251xfd_write_block(ADDR_C1BDIAG0,ptrBaud->ptrChn,regClr,8);	// clear C1BDIAG0 & C1BDIAG1
+	ptrBaud->tStart = tNow;
+}
+/**************************************************************************************************
+Purpose: 	Applies the current candidate in listen only mode & clears the bus diagnostic counters
+Inputs:		*ptrBaud	- baudCAN pointer
+			tNow		- current time in ms
+
+Outputs:	result		- BAUDBUSY or BAUDFAIL (mode/register fault)
+**************************************************************************************************/
+static uint8_t canbaud_apply(baudCAN *ptrBaud,unsigned long tNow){
+	uint8_t idx;
+
+	if(!ptrBaud->phase)
+		ptrBaud->speed = nomCand[ptrBaud->cand];
+	ptrBaud->dataSpeed = (ptrBaud->phase) ? dataCand[ptrBaud->cand] : CANDATA_2M;
+	if(mcp251xfd_bitrate_set(ptrBaud->ptrChn,ptrBaud->speed,ptrBaud->dataSpeed,CANMODE_LISTEN))
+		return ptrBaud->state = BAUDFAIL;
+	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
+	canbaud_clear(ptrBaud,tNow);
+	return BAUDBUSY;
+}
+/**************************************************************************************************
+Purpose: 	Starts bit rate detection (call after mcp251xfd_init(); FIFO contents are lost)
+Inputs:		*ptrBaud	- baudCAN pointer
+			*ptrChn		- chnCAN pointer
+			dwell		- max time per candidate in ms (e.g. 50; long enough for BAUDMINMSGS msgs)
+			tNow		- current time in ms (e.g. millis())
+
+Outputs:	result		- BAUDBUSY or BAUDFAIL
+**************************************************************************************************/
+uint8_t canbaud_start(baudCAN *ptrBaud,chnCAN *ptrChn,uint16_t dwell,unsigned long tNow){
+	ptrBaud->ptrChn = ptrChn;
+	ptrBaud->dwell = dwell;
+	ptrBaud->state = BAUDBUSY;
+	ptrBaud->phase = 0;
+	ptrBaud->cand = 0;
+	ptrBaud->cycles = 0;
+	ptrBaud->tBegin = tNow;
+	ptrBaud->tLock = 0;
+	return canbaud_apply(ptrBaud,tNow);
+}
+/**************************************************************************************************
+Purpose: 	Runs bit rate detection (call from loop() until the result is not BAUDBUSY)
+Inputs:		*ptrBaud	- baudCAN pointer
+			tNow		- current time in ms (e.g. millis())
+
+Outputs:	result		- BAUDBUSY/BAUDLOCKED/BAUDFAIL (speed & dataSpeed hold the locked rates;
+							use mcp251xfd_mode_set() to leave listen only)
+**************************************************************************************************/
+uint8_t canbaud_poll(baudCAN *ptrBaud,unsigned long tNow){
+	uint8_t	regBuf[8];												// C1BDIAG0,C1BDIAG1
+	uint16_t msgs;
+	uint8_t errs, done, next;
+
+	if(ptrBaud->state != BAUDBUSY)
+		return ptrBaud->state;
+	mcp251xfd_read_block(ADDR_C1BDIAG0,ptrBaud->ptrChn,regBuf,8);	// read C1BDIAG0 & C1BDIAG1
+	msgs = ((uint16_t)regBuf[5] << 8) | regBuf[4];					// EFMSGCNT
+	done = (tNow - ptrBaud->tStart) >= ptrBaud->dwell;				// dwell time over
+
+	if(!ptrBaud->phase){											// nominal bit rate
+		errs = regBuf[0];											// NRERRCNT
+		if((msgs >= BAUDMINMSGS) && (!errs || (done && (errs <= (msgs >> 2))))){	// locked
+			ptrBaud->phase = 1;
+			ptrBaud->cand = 0;										// CANDATA_2M is applied already
+			canbaud_clear(ptrBaud,tNow);
+			return BAUDBUSY;
+		}
+		next = done || (!msgs && (errs >= BAUDMINERRS));			// drop the candidate
+		if(!next)
+			return BAUDBUSY;
+		if(++ptrBaud->cand >= sizeof(nomCand)){						// end of a pass
+			ptrBaud->cand = 0;
+			if(++ptrBaud->cycles >= BAUDCYCLES)
+				return ptrBaud->state = BAUDFAIL;
+		}
+		return canbaud_apply(ptrBaud,tNow);
+	}
+
+	errs = regBuf[2];												// DRERRCNT
+	if(!errs && !done)												// no data phase errors yet
+		return BAUDBUSY;
+	if(!errs || (ptrBaud->cand >= sizeof(dataCand) - 1)){			// data phase speed kept
+		if(errs)													// no candidate without errors
+			ptrBaud->dataSpeed = CANDATA_2M;
+		if(errs && mcp251xfd_bitrate_set(ptrBaud->ptrChn,ptrBaud->speed,ptrBaud->dataSpeed,CANMODE_LISTEN))
+			return ptrBaud->state = BAUDFAIL;
+		ptrBaud->tLock = tNow - ptrBaud->tBegin;
+		return ptrBaud->state = BAUDLOCKED;
+	}
+	ptrBaud->cand++;
+	return canbaud_apply(ptrBaud,tNow);
+}
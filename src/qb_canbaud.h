@@ -0,0 +1,66 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#ifndef	QB_CANBAUD_H
+#define	QB_CANBAUD_H
+
+#include <inttypes.h>
+#include "qb_mcp251xfd.h"
+#ifdef __cplusplus
+
+extern "C"
+{
+
+#endif
+
+/**************************************************************************************************
+Algorithm variables 
+  Bit rate detection in listen only mode (no ACK & no error frames sent, so the bus is not disturbed).
+  Nominal candidates 500k, 250k, 125k, 1M are tried in turn (mcp251xfd_bitrate_set()); C1BDIAG0/1 are
+  read each canbaud_poll() & the candidate is:
+    locked		- BAUDMINMSGS error free msgs with no nominal RX errors (early) or errors <= msgs/4 at the
+				  end of the dwell time
+    dropped		- BAUDMINERRS nominal RX errors with no error free msg (early) or at the end of the dwell
+  With the nominal rate locked, data phase candidates 2M, 1M, 4M (automatic TDC) are checked for a
+  dwell each: the 1st one without data phase RX errors is kept (a bus without BRS frames keeps 2M). All nominal candidates
+  are retried BAUDCYCLES times (e.g. an idle bus) before giving up.
+**************************************************************************************************/
+#define BAUDMINMSGS		4				// error free msgs to lock a candidate
+#define BAUDMINERRS		8				// RX errors to drop a candidate early
+#define BAUDCYCLES		3				// passes thru the nominal candidates before BAUDFAIL
+
+#define BAUDBUSY		0				// canbaud_poll() result - detection running
+#define BAUDLOCKED		1				// canbaud_poll() result - speed & dataSpeed found (channel left in listen only)
+#define BAUDFAIL		2				// canbaud_poll() result - no candidate matched (or a mode/register fault)
+
+typedef struct{
+	chnCAN *ptrChn;													// channel
+	uint16_t dwell;													// dwell time per candidate (ms)
+	uint8_t state;													// BAUDBUSY/BAUDLOCKED/BAUDFAIL
+	uint8_t phase;													// 0 = nominal;1 = data phase
+	uint8_t cand;													// candidate index
+	uint8_t cycles;													// passes thru the nominal candidates
+	uint8_t speed;													// nominal speed tried/locked (CANSPEED_x)
+	uint8_t dataSpeed;												// data phase speed tried/locked (CANDATA_x)
+	unsigned long tStart;											// time the candidate was applied (ms)
+	unsigned long tBegin;											// time canbaud_start() was called (ms)
+	unsigned long tLock;											// detection time (ms)
+} baudCAN;
+
+uint8_t 		canbaud_start(baudCAN *ptrBaud,chnCAN *ptrChn,uint16_t dwell,unsigned long tNow);
+uint8_t 		canbaud_poll(baudCAN *ptrBaud,unsigned long tNow);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// QB_CANBAUD_H
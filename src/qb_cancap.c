@@ -0,0 +1,183 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+
+#include <stdint.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_cancap.h"
+
+/**************************************************************************************************
+Purpose: 	Initializes a capCAN object with caller owned ring storage & arms it
+Inputs:		*ptrCap		- capCAN pointer
+			*ptrRing	- capEntry array
+			size		- #of entries in *ptrRing (2-255)
+			post		- #of msgs to capture after the trigger msg (< size)
+			*ptrTrig	- trigger (copied)
+
+Outputs:	None
+**************************************************************************************************/
+void cancap_init(capCAN *ptrCap,capEntry *ptrRing,uint8_t size,uint8_t post,capTrig *ptrTrig){
+	uint8_t idx;													// used to step thru pattern bytes
+
+	ptrCap->ptrRing = ptrRing;
+	ptrCap->size = size;
+	ptrCap->post = (post < size) ? post : (size - 1);
+	ptrCap->trig = *ptrTrig;
+	ptrCap->trig.id &= ptrCap->trig.mask;							// pre-mask so the per msg check is 1 compare
+	if(ptrCap->trig.patLen > CAPPATLEN)
+		ptrCap->trig.patLen = CAPPATLEN;
+	for(idx=0;idx<CAPPATLEN;idx++){									// loop thru pattern bytes
+		ptrCap->trig.pat[idx] &= ptrCap->trig.patMsk[idx];
+	}
+	cancap_arm(ptrCap);
+}
+/**************************************************************************************************
+Purpose: 	Empties the ring & waits for the next trigger
+Inputs:		*ptrCap		- capCAN pointer
+
+Outputs:	None
+**************************************************************************************************/
+void cancap_arm(capCAN *ptrCap){
+	ptrCap->head = 0;
+	ptrCap->fill = 0;
+	ptrCap->postLeft = 0;
+	ptrCap->trigIdx = CAPNOTRIG;
+	ptrCap->state = CAPARMED;
+}
+/**************************************************************************************************
+Purpose: 	Fires the trigger on the last captured msg (manual trigger; also used by cancap_rx/err)
+			On an empty ring there is no trigger msg (trigIdx = CAPNOTRIG), post msgs are still captured
+Inputs:		*ptrCap		- capCAN pointer
+
+Outputs:	None
+**************************************************************************************************/
+void cancap_fire(capCAN *ptrCap){
+	if(ptrCap->state != CAPARMED)									// already triggered
+		return;
+	if(!ptrCap->fill)												// nothing captured yet
+		ptrCap->trigIdx = CAPNOTRIG;
+	else if(ptrCap->fill < ptrCap->size)							// partial ring, last msg is at fill-1
+		ptrCap->trigIdx = ptrCap->fill - 1;
+	else
+		ptrCap->trigIdx = (ptrCap->head + ptrCap->size - 1) % ptrCap->size;
+	ptrCap->postLeft = ptrCap->post;
+	ptrCap->state = (ptrCap->post) ? CAPPOST : CAPDONE;
+}
+/**************************************************************************************************
+Purpose: 	Captures a msg read by mcp251xfd_read_frame() & checks the ID/pattern trigger
+Inputs:		*ptrCap		- capCAN pointer
+			chnNum		- channel the msg was read on
+			*ptrMsg		- msgCAN pointer
+
+Outputs:	result		- 1 = this msg fired the trigger; else 0
+**************************************************************************************************/
+uint8_t cancap_rx(capCAN *ptrCap,uint8_t chnNum,msgCAN *ptrMsg){
+	capEntry *ptrEnt;												// ring entry of the msg
+	unsigned long idWord;
+	uint8_t idx, len;
+
+	if(ptrCap->state == CAPDONE)									// ring frozen
+		return 0;
+
+	idWord = mcp251xfd_hdr_unpack(&ptrMsg->sid07_00);
+	ptrEnt = &ptrCap->ptrRing[ptrCap->head];
+	len = (ptrMsg->pLen > CAPLEN) ? CAPLEN : ptrMsg->pLen;
+	ptrEnt->chnNum = chnNum;
+	ptrEnt->t1 = *(&ptrMsg->sid07_00 + 4);							// T1 byte 0
+	ptrEnt->len = len;
+	ptrEnt->tStamp = ptrMsg->tStamp;
+	ptrEnt->id = idWord;
+	for(idx=0;idx<len;idx++){										// loop thru payload
+		ptrEnt->data[idx] = ptrMsg->rxData[idx];
+	}
+	if(++ptrCap->head >= ptrCap->size)
+		ptrCap->head = 0;
+	if(ptrCap->fill < ptrCap->size)
+		ptrCap->fill++;
+
+	if(ptrCap->state == CAPPOST){									// capturing post-trigger msgs
+		if(--ptrCap->postLeft == 0)
+			ptrCap->state = CAPDONE;								// freeze the ring
+		return 0;
+	}
+
+	if((idWord & ptrCap->trig.mask) != ptrCap->trig.id)				// ID trigger
+		return 0;
+	if(ptrCap->trig.patLen){										// payload pattern trigger
+		if((ptrCap->trig.patOfs + ptrCap->trig.patLen) > ptrMsg->pLen)
+			return 0;
+		for(idx=0;idx<ptrCap->trig.patLen;idx++){					// loop thru pattern bytes
+			if((ptrMsg->rxData[ptrCap->trig.patOfs + idx] & ptrCap->trig.patMsk[idx]) != ptrCap->trig.pat[idx])
+				return 0;
+		}
+	}
+	cancap_fire(ptrCap);
+	return 1;
+}
+/**************************************************************************************************
+Purpose: 	Checks the error counter trigger (call after mcp251xfd_stat_sample())
+Inputs:		*ptrCap		- capCAN pointer
+			*ptrStat	- statCAN pointer
+
+Outputs:	result		- 1 = trigger fired; else 0
+**************************************************************************************************/
+uint8_t cancap_err(capCAN *ptrCap,statCAN *ptrStat){
+	if(!ptrCap->trig.errLvl || (ptrCap->state != CAPARMED))
+		return 0;
+	if((ptrStat->tec < ptrCap->trig.errLvl) && (ptrStat->rec < ptrCap->trig.errLvl))
+		return 0;
+	cancap_fire(ptrCap);
+	return 1;
+}
+/**************************************************************************************************
+Purpose: 	Writes the captured msgs in binary, oldest 1st (format in qb_cancap.h)
+Inputs:		*ptrCap		- capCAN pointer
+			write		- binary output sub-routine
+
+Outputs:	None
+**************************************************************************************************/
+void cancap_dump(capCAN *ptrCap,capWrite write){
+	capEntry *ptrEnt;
+	uint8_t rec[CAPRECLEN];											// used to serialize a record
+	uint8_t idx, jdx, start;
+
+	start = (ptrCap->fill < ptrCap->size) ? 0 : ptrCap->head;		// oldest entry
+	rec[0] = 'Q'; rec[1] = 'B'; rec[2] = 'C'; rec[3] = 'P';
+	rec[4] = 1;														// version
+	rec[5] = CAPRECLEN;
+	rec[6] = ptrCap->fill;
+	if((ptrCap->state == CAPARMED) || (ptrCap->trigIdx == CAPNOTRIG))	// not triggered or no trigger msg
+		rec[7] = CAPNOTRIG;
+	else
+		rec[7] = (ptrCap->trigIdx + ptrCap->size - start) % ptrCap->size;
+	write(rec,8);
+
+	for(idx=0;idx<ptrCap->fill;idx++){								// loop thru entries
+		ptrEnt = &ptrCap->ptrRing[(start + idx) % ptrCap->size];
+		rec[0] = ptrEnt->chnNum;
+		rec[1] = ptrEnt->tStamp;
+		rec[2] = ptrEnt->tStamp >> 8;
+		rec[3] = ptrEnt->tStamp >> 16;
+		rec[4] = ptrEnt->tStamp >> 24;
+		rec[5] = ptrEnt->id;
+		rec[6] = ptrEnt->id >> 8;
+		rec[7] = ptrEnt->id >> 16;
+		rec[8] = ptrEnt->id >> 24;
+		rec[9] = ptrEnt->t1;
+		rec[10] = ptrEnt->len;
+		for(jdx=0;jdx<CAPLEN;jdx++){								// loop thru payload (unused bytes 0)
+			rec[11 + jdx] = (jdx < ptrEnt->len) ? ptrEnt->data[jdx] : 0;
+		}
+		write(rec,CAPRECLEN);
+	}
+}
@@ -0,0 +1,90 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#ifndef	QB_CANCAP_H
+#define	QB_CANCAP_H
+
+#include <inttypes.h>
+#include "qb_mcp251xfd.h"
+#ifdef __cplusplus
+
+extern "C"
+{
+
+#endif
+
+/**************************************************************************************************
+Algorithm variables 
+  Pre-trigger capture: cancap_rx() keeps the last N msgs of both channels in a caller owned ring.
+  A trigger (ID/mask & optional payload byte pattern checked per msg, or an error counter threshold
+  checked by cancap_err()) freezes the ring after post more msgs, leaving N-1-post msgs before the
+  trigger msg. cancap_dump() then writes the frozen ring in binary, oldest msg 1st:
+    header	- "QBCP",version(1),record length(CAPRECLEN),#of records,trigger record index (CAPNOTRIG =
+			  not triggered, or fired on an empty ring)
+    record	- chnNum,tStamp(4,LSB 1st),ID word(4,LSB 1st),T1 byte 0 (DLC,IDE,RTR,BRS,FDF),len,data(CAPLEN)
+**************************************************************************************************/
+#ifndef CAPLEN
+#define CAPLEN			8				// #of payload bytes kept per msg (longer payloads are truncated)
+#endif
+#define CAPPATLEN		4				// max #of payload bytes in a trigger pattern
+#define CAPRECLEN		(11 + CAPLEN)	// #of bytes per dumped record
+#define CAPNOTRIG		0xFF			// trigger record index - no trigger msg in the ring
+
+#define CAPARMED		0				// state - filling ring, waiting for trigger
+#define CAPPOST			1				// state - triggered, capturing post-trigger msgs
+#define CAPDONE			2				// state - ring frozen, ready to dump
+
+typedef struct{
+	uint8_t chnNum;													// channel the msg was read on
+	uint8_t t1;														// T1 byte 0 (DLC,IDE,RTR,BRS,FDF)
+	uint8_t len;													// #of payload bytes in data
+	unsigned long tStamp;											// timestamp of the msg (1/40MHz periods)
+	unsigned long id;												// ID word (CANID_EXT for extended IDs)
+	uint8_t data[CAPLEN];											// payload
+} capEntry;
+
+typedef struct{
+	unsigned long id;												// ID word to match (after mask)
+	unsigned long mask;												// ID word bits compared (0 = any ID;CANID_EXT | CANID_MASK = exact)
+	uint8_t patOfs;													// payload index of the 1st pattern byte
+	uint8_t patLen;													// #of pattern bytes (0 = no payload pattern)
+	uint8_t pat[CAPPATLEN];											// pattern bytes (after patMsk)
+	uint8_t patMsk[CAPPATLEN];										// pattern bits compared
+	uint8_t errLvl;													// TEC/REC threshold for cancap_err() (0 = off)
+} capTrig;
+
+typedef struct{
+	capEntry *ptrRing;												// caller owned ring storage
+	uint8_t size;													// #of entries in the ring
+	uint8_t head;													// index of the next entry to write
+	uint8_t fill;													// #of entries written (up to size)
+	uint8_t post;													// #of msgs to capture after the trigger msg
+	uint8_t postLeft;												// #of post-trigger msgs still to capture
+	uint8_t state;													// CAPARMED/CAPPOST/CAPDONE
+	uint8_t trigIdx;												// ring index of the trigger msg (CAPNOTRIG = none)
+	capTrig trig;													// trigger
+} capCAN;
+
+typedef void (*capWrite)(const uint8_t *ptrBuf,uint8_t len);		// binary output (e.g. wraps Serial.write())
+
+void 			cancap_init(capCAN *ptrCap,capEntry *ptrRing,uint8_t size,uint8_t post,capTrig *ptrTrig);
+void 			cancap_arm(capCAN *ptrCap);
+uint8_t 		cancap_rx(capCAN *ptrCap,uint8_t chnNum,msgCAN *ptrMsg);
+uint8_t 		cancap_err(capCAN *ptrCap,statCAN *ptrStat);
+void 			cancap_fire(capCAN *ptrCap);
+void 			cancap_dump(capCAN *ptrCap,capWrite write);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// QB_CANCAP_H
@@ -0,0 +1,192 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+
+#ifndef MCP251XFD_HOST
+#include <avr/io.h>
+#endif
+#include <stdint.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_cancyc.h"
+
+/**************************************************************************************************
+Purpose: 	Links a msg into the slot of its due tick
+Inputs:		*ptrCyc		- cycCAN pointer
+			idx			- msg index
+
+Outputs:	None
+**************************************************************************************************/
+static void cancyc_link(cycCAN *ptrCyc,uint8_t idx){
+	uint8_t slot = ptrCyc->ptrTbl[idx].due & (CYCSLOTS - 1);
+
+	ptrCyc->ptrTbl[idx].next = ptrCyc->head[slot];
+	ptrCyc->head[slot] = idx;
+}
+/**************************************************************************************************
+Purpose: 	Initializes a cycCAN object
+Inputs:		*ptrCyc		- cycCAN pointer
+			*ptrChn		- chnCAN pointer
+			bufIdx		- TX FIFO the msgs are loaded into (as deep as the msgs due in 1 tick, refer to
+							mcp251xfd_txfifo_depth())
+			*ptrTbl		- cycEntry array
+			size		- #of entries in *ptrTbl (max 255)
+			tickTbc		- tick length in 1/40MHz periods (jitter reference, e.g. 40000 for a 1ms tick)
+
+Outputs:	None
+**************************************************************************************************/
+void cancyc_init(cycCAN *ptrCyc,chnCAN *ptrChn,uint8_t bufIdx,cycEntry *ptrTbl,uint8_t size,unsigned long tickTbc){
+	uint8_t idx;
+
+	ptrCyc->ptrChn = ptrChn;
+	ptrCyc->bufIdx = bufIdx;
+	ptrCyc->ptrTbl = ptrTbl;
+	ptrCyc->size = (size < CYCNONE) ? size : CYCNONE - 1;
+	ptrCyc->cnt = 0;
+	for(idx=0;idx<CYCSLOTS;idx++){									// empty wheel
+		ptrCyc->head[idx] = CYCNONE;
+	}
+	ptrCyc->ticks = 0;
+	ptrCyc->done = 0;
+	ptrCyc->now = 0;
+	ptrCyc->tickTbc = tickTbc;
+	ptrCyc->lagMax = 0;
+}
+/**************************************************************************************************
+Purpose: 	Adds a periodic msg (call with the tick ISR stopped or before it is started)
+Inputs:		*ptrCyc		- cycCAN pointer
+			*ptrMsg		- msgCAN pointer (prepared by mcp251xfd_frame_prep())
+			period		- period (1-32767 ticks)
+			offset		- ticks before the 1st transmission (0 = next tick)
+
+Outputs:	result		- error code (defined in qb_mcp251xfd.h)
+							ERR_CYCFULL = msg table is full
+**************************************************************************************************/
+uint8_t cancyc_add(cycCAN *ptrCyc,msgCAN *ptrMsg,uint16_t period,uint16_t offset){
+	cycEntry *ptrEnt;
+
+	if(ptrCyc->cnt >= ptrCyc->size)									// check if table is full
+		return ERR_CYCFULL;											// return error code
+	ptrEnt = &ptrCyc->ptrTbl[ptrCyc->cnt];
+	ptrEnt->ptrMsg = ptrMsg;
+	ptrEnt->period = (period) ? (period & 0x7FFF) : 1;
+	ptrEnt->due = ptrCyc->now + 1 + (offset & 0x7FFF);
+	ptrEnt->tLast = 0;
+	ptrEnt->jitMax = 0;
+	ptrEnt->missed = 0;
+	ptrEnt->sent = 0;
+	cancyc_link(ptrCyc,ptrCyc->cnt++);
+	return 0;
+}
+/**************************************************************************************************
+Purpose: 	Counts 1 tick (call from the timer ISR; no SPI access is made)
+Inputs:		*ptrCyc		- cycCAN pointer
+
+Outputs:	None
+**************************************************************************************************/
+void cancyc_tick(cycCAN *ptrCyc){
+	ptrCyc->ticks++;
+}
+/**************************************************************************************************
+Purpose: 	Transmits the msgs due in the ticks elapsed since the last call (call from loop())
+Inputs:		*ptrCyc		- cycCAN pointer
+
+Outputs:	result		- #of msgs loaded into the TX FIFO
+**************************************************************************************************/
+uint8_t cancyc_poll(cycCAN *ptrCyc){
+	cycEntry *ptrEnt;
+	unsigned long tNow, dt, nom;
+	uint8_t idx, prev, next, slot, lag, cnt, pend, total, result;
+
+	lag = ptrCyc->ticks - ptrCyc->done;								// 8 bit read, atomic on AVR
+	if(lag > ptrCyc->lagMax)
+		ptrCyc->lagMax = lag;
+	total = 0;
+	while(lag){														// loop thru elapsed ticks
+		lag--;
+		ptrCyc->done++;
+		ptrCyc->now++;
+		slot = ptrCyc->now & (CYCSLOTS - 1);
+		cnt = 0;
+		pend = 0;
+		tNow = 0;
+		prev = CYCNONE;
+		for(idx=ptrCyc->head[slot];idx!=CYCNONE;idx=next){			// walk slot list
+			ptrEnt = &ptrCyc->ptrTbl[idx];
+			next = ptrEnt->next;
+			if(ptrEnt->due != ptrCyc->now){							// due in a later round
+				prev = idx;
+				continue;
+			}
+			if(!cnt)
+				tNow = mcp251xfd_tbc_read(ptrCyc->ptrChn);			// 1 TBC read per batch
+			result = mcp251xfd_write_frame(ptrCyc->bufIdx,ptrCyc->ptrChn,ptrEnt->ptrMsg);
+			if(result && pend){										// TX FIFO full - request the msgs of the tick so far
+				mcp251xfd_start_transmit(ptrCyc->bufIdx,ptrCyc->ptrChn);
+				pend = 0;
+				result = mcp251xfd_write_frame(ptrCyc->bufIdx,ptrCyc->ptrChn,ptrEnt->ptrMsg);	// & load again once
+			}
+			if(result)												// TX FIFO still full
+				ptrEnt->missed++;
+			else{
+				if(ptrEnt->sent){									// period jitter
+					dt = tNow - ptrEnt->tLast;
+					nom = ptrCyc->tickTbc * ptrEnt->period;
+					dt = (dt > nom) ? dt - nom : nom - dt;
+					if(dt > ptrEnt->jitMax)
+						ptrEnt->jitMax = (dt > 0xFFFF) ? 0xFFFF : dt;
+				}
+				ptrEnt->tLast = tNow;
+				ptrEnt->sent++;
+				pend++;
+				cnt++;
+			}
+			ptrEnt->due += ptrEnt->period;							// reschedule
+			if((ptrEnt->due & (CYCSLOTS - 1)) != slot){				// move to another slot
+				if(prev == CYCNONE)
+					ptrCyc->head[slot] = next;
+				else
+					ptrCyc->ptrTbl[prev].next = next;
+				cancyc_link(ptrCyc,idx);
+			}
+			else
+				prev = idx;
+		}
+		if(pend)													// 1 transmit request per tick
+			mcp251xfd_start_transmit(ptrCyc->bufIdx,ptrCyc->ptrChn);
+		total += cnt;
+	}
+	return total;
+}
+/**************************************************************************************************
+Purpose: 	Sets up a 1ms compare match interrupt: Timer3 on the ATmega32U4 (takes it away from tone()),
+				else Timer2 (takes it away from tone() & PWM on its pins). The sketch supplies the ISR:
+				ISR(CYCTIMER_vect){ cancyc_tick(&cyc); }
+Inputs:		None
+
+Outputs:	None
+**************************************************************************************************/
+void cancyc_timer(void){
+#ifndef MCP251XFD_HOST
+#if defined(__AVR_ATmega32U4__) || defined(__AVR_ATmega16U4__)
+	TCCR3A = 0;
+	TCCR3B = (1<<WGM32) | (1<<CS31) | (1<<CS30);					// CTC mode, Fosc/64
+	OCR3A = (F_CPU / 64000UL) - 1;									// 1ms (249 at 16MHz;124 at 8MHz)
+	TIMSK3 = (1<<OCIE3A);											// compare match A interrupt
+#elif defined(TCCR2A)
+	TCCR2A = (1<<WGM21);											// CTC mode
+	TCCR2B = (1<<CS22);												// Fosc/64
+	OCR2A = (F_CPU / 64000UL) - 1;									// 1ms (249 at 16MHz;124 at 8MHz)
+	TIMSK2 = (1<<OCIE2A);											// compare match A interrupt
+#endif
+#endif
+}
@@ -0,0 +1,81 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#ifndef	QB_CANCYC_H
+#define	QB_CANCYC_H
+
+#include <inttypes.h>
+#include "qb_mcp251xfd.h"
+#ifdef __cplusplus
+
+extern "C"
+{
+
+#endif
+
+/**************************************************************************************************
+Algorithm variables 
+  Cyclic TX scheduler: each msg has a period & offset in ticks and sits in a hashed timer wheel of
+  CYCSLOTS slots (slot = due tick & (CYCSLOTS-1)). cancyc_tick() is called from a hardware timer ISR
+  (e.g. the 1ms timer setup by cancyc_timer()) & only counts ticks; cancyc_poll() in loop() catches up on
+  the ticks elapsed, walking 1 slot per tick, loads the due msgs of the tick into the TX FIFO & makes
+  1 transmit request, so the TX FIFO should hold the msgs due in 1 tick (mcp251xfd_txfifo_depth()); a
+  TX FIFO that fills up gets the transmit request early & the msg is loaded again once. Per tick cost is bounded by the #of msgs hashed into the slot (spread msgs by
+  offset). Jitter is the difference between the measured (TBC at the batch) & nominal period.
+**************************************************************************************************/
+#define CYCSLOTS		16				// #of timer wheel slots (power of 2)
+#define CYCNONE			0xFF			// end of slot list
+
+// Arduino Pro Micro (ATmega32U4 has no Timer2): cancyc_timer() uses Timer3
+#if defined(__AVR_ATmega32U4__) || defined(__AVR_ATmega16U4__)
+#define CYCTIMER_vect	TIMER3_COMPA_vect
+// Arduino Pro Mini, Uno, mega: cancyc_timer() uses Timer2
+#else
+#define CYCTIMER_vect	TIMER2_COMPA_vect
+#endif
+
+typedef struct{
+	msgCAN *ptrMsg;													// caller owned TX msg (mcp251xfd_frame_prep()); payload may be updated any time
+	uint16_t period;												// period (ticks)
+	uint16_t due;													// tick of the next transmission
+	uint8_t next;													// next msg in the same slot
+	unsigned long tLast;											// TBC of the last transmission
+	uint16_t jitMax;												// max period jitter (1/40MHz periods, saturates at 65535)
+	uint16_t missed;												// #of transmissions missed (TX FIFO full)
+	unsigned long sent;												// #of transmissions
+} cycEntry;
+
+typedef struct{
+	chnCAN *ptrChn;													// channel
+	uint8_t bufIdx;													// TX FIFO
+	cycEntry *ptrTbl;												// caller owned msg table
+	uint8_t size;													// #of msgs the table holds
+	uint8_t cnt;													// #of msgs added
+	uint8_t head[CYCSLOTS];											// 1st msg of each slot
+	volatile uint8_t ticks;											// ticks counted by cancyc_tick()
+	uint8_t done;													// ticks processed by cancyc_poll()
+	uint16_t now;													// current tick
+	unsigned long tickTbc;											// tick length (1/40MHz periods, e.g. 40000 for 1ms)
+	uint8_t lagMax;													// max #of ticks cancyc_poll() had to catch up on
+} cycCAN;
+
+void 			cancyc_init(cycCAN *ptrCyc,chnCAN *ptrChn,uint8_t bufIdx,cycEntry *ptrTbl,uint8_t size,unsigned long tickTbc);
+uint8_t 		cancyc_add(cycCAN *ptrCyc,msgCAN *ptrMsg,uint16_t period,uint16_t offset);
+void 			cancyc_tick(cycCAN *ptrCyc);
+uint8_t 		cancyc_poll(cycCAN *ptrCyc);
+void 			cancyc_timer(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// QB_CANCYC_H
@@ -0,0 +1,175 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+
+#include <stdint.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_candec.h"
+
+/**************************************************************************************************
+Purpose: 	Initializes a decCAN object with caller owned rule storage
+Inputs:		*ptrDec		- decCAN pointer
+			*ptrTbl		- decRule array
+			size		- #of rules in *ptrTbl
+			defMode		- mode for IDs without a rule (DECALL or DECNONE)
+
+Outputs:	None
+**************************************************************************************************/
+void candec_init(decCAN *ptrDec,decRule *ptrTbl,uint8_t size,uint8_t defMode){
+	ptrDec->ptrTbl = ptrTbl;
+	ptrDec->size = size;
+	ptrDec->cnt = 0;
+	ptrDec->defMode = defMode;
+	candec_clear(ptrDec);
+}
+/**************************************************************************************************
+Purpose: 	Adds or replaces the rule of an ID (table stays in ascending ID order)
+Inputs:		*ptrDec		- decCAN pointer
+			idWord		- ID (| CANID_EXT for an extended ID)
+			mode		- DECALL/DECNTH/DECRATE/DECCHANGE/DECNONE
+			param		- DECNTH: N (1-255);DECRATE: max msgs per second;DECCHANGE: #of bytes in *ptrBuf
+						  (payloads longer than the buffer are always kept);else ignored
+			*ptrBuf		- DECCHANGE: caller owned buffer for the last kept payload;else ignored (0)
+
+Outputs:	result		- error code (defined in qb_mcp251xfd.h)
+							ERR_DECFULL = table is full
+							ERR_DECBUF	= DECCHANGE without a buffer (ptrBuf 0 or param 0)
+**************************************************************************************************/
+uint8_t candec_add(decCAN *ptrDec,unsigned long idWord,uint8_t mode,unsigned long param,uint8_t *ptrBuf){
+	decRule *ptrRule;												// rule of the ID
+	uint8_t idx;													// used to step thru rules
+
+	if((mode == DECCHANGE) && (!ptrBuf || !param))					// no payload buffer to compare against
+		return ERR_DECBUF;											// return error code
+	idWord &= (CANID_EXT | CANID_MASK);
+	ptrRule = candec_find(ptrDec,idWord);
+	if(!ptrRule){													// new ID
+		if(ptrDec->cnt >= ptrDec->size)								// check if table is full
+			return ERR_DECFULL;										// return error code
+		for(idx=ptrDec->cnt;(idx>0) && (ptrDec->ptrTbl[idx-1].id > idWord);idx--){	// shift larger IDs up
+			ptrDec->ptrTbl[idx] = ptrDec->ptrTbl[idx-1];
+		}
+		ptrDec->cnt++;
+		ptrRule = &ptrDec->ptrTbl[idx];
+		ptrRule->id = idWord;
+	}
+	if(mode == DECNTH)
+		param = (param < 1) ? 1 : (param > 255) ? 255 : param;
+	else if(mode == DECRATE)
+		param = (param < 1) ? MCP251XFD_TBCLK : (MCP251XFD_TBCLK / param);	// max Hz -> min ticks between msgs
+	ptrRule->mode = mode;
+	ptrRule->param = param;
+	ptrRule->ptrData = (mode == DECCHANGE) ? ptrBuf : 0;
+	ptrRule->nCnt = 0;
+	ptrRule->len = 0;
+	ptrRule->tLast = 0;
+	ptrRule->kept = 0;
+	ptrRule->dropped = 0;
+	return 0;
+}
+/**************************************************************************************************
+Purpose: 	Looks up the rule of an ID
+Inputs:		*ptrDec		- decCAN pointer
+			idWord		- ID (| CANID_EXT for an extended ID, as returned by mcp251xfd_hdr_unpack())
+
+Outputs:	result		- decRule pointer; 0 if the ID has no rule
+**************************************************************************************************/
+decRule *candec_find(decCAN *ptrDec,unsigned long idWord){
+	uint8_t lo, hi, mid;											// binary search bounds
+
+	lo = 0;
+	hi = ptrDec->cnt;
+	while(lo < hi){													// binary search for 1st id >= idWord
+		mid = lo + ((hi - lo) >> 1);
+		if(ptrDec->ptrTbl[mid].id < idWord)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if((lo < ptrDec->cnt) && (ptrDec->ptrTbl[lo].id == idWord))
+		return &ptrDec->ptrTbl[lo];
+	return 0;
+}
+/**************************************************************************************************
+Purpose: 	Decides if a msg read by mcp251xfd_read_frame() is kept & counts the decision
+Inputs:		*ptrDec		- decCAN pointer
+			*ptrMsg		- msgCAN pointer
+
+Outputs:	result		- 1 = keep (output the msg); 0 = drop
+**************************************************************************************************/
+uint8_t candec_rx(decCAN *ptrDec,msgCAN *ptrMsg){
+	decRule *ptrRule;												// rule of the msg ID
+	uint8_t keep, idx;
+
+	ptrRule = candec_find(ptrDec,mcp251xfd_hdr_unpack(&ptrMsg->sid07_00));
+	if(!ptrRule){													// ID without a rule
+		if(ptrDec->defMode == DECNONE){
+			ptrDec->defDropped++;
+			return 0;
+		}
+		ptrDec->defKept++;
+		return 1;
+	}
+	switch(ptrRule->mode){
+		case DECNTH:
+			keep = (ptrRule->nCnt == 0);							// 1st of every N msgs
+			if(++ptrRule->nCnt >= ptrRule->param)
+				ptrRule->nCnt = 0;
+			break;
+		case DECRATE:
+			keep = (!ptrRule->kept) || ((ptrMsg->tStamp - ptrRule->tLast) >= ptrRule->param);
+			if(keep)
+				ptrRule->tLast = ptrMsg->tStamp;
+			break;
+		case DECCHANGE:
+			keep = (!ptrRule->kept) || (ptrMsg->pLen != ptrRule->len) || (ptrMsg->pLen > ptrRule->param);	// 1st msg, length changed or longer than the buffer
+			for(idx=0;!keep && (idx<ptrMsg->pLen);idx++){			// compare against the last kept payload
+				if(ptrMsg->rxData[idx] != ptrRule->ptrData[idx])
+					keep = 1;
+			}
+			if(keep){												// keep a copy of the new payload
+				ptrRule->len = ptrMsg->pLen;
+				for(idx=0;(idx<ptrMsg->pLen) && (idx<ptrRule->param);idx++)
+					ptrRule->ptrData[idx] = ptrMsg->rxData[idx];
+			}
+			break;
+		case DECNONE:
+			keep = 0;
+			break;
+		default:													// DECALL
+			keep = 1;
+			break;
+	}
+	if(keep)
+		ptrRule->kept++;
+	else
+		ptrRule->dropped++;
+	return keep;
+}
+/**************************************************************************************************
+Purpose: 	Clears the kept/dropped counters & decimation state of all rules
+Inputs:		*ptrDec		- decCAN pointer
+
+Outputs:	None
+**************************************************************************************************/
+void candec_clear(decCAN *ptrDec){
+	uint8_t idx;													// used to step thru rules
+
+	for(idx=0;idx<ptrDec->cnt;idx++){								// loop thru rules
+		ptrDec->ptrTbl[idx].nCnt = 0;
+		ptrDec->ptrTbl[idx].kept = 0;
+		ptrDec->ptrTbl[idx].dropped = 0;
+	}
+	ptrDec->defKept = 0;
+	ptrDec->defDropped = 0;
+}
@@ -0,0 +1,70 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#ifndef	QB_CANDEC_H
+#define	QB_CANDEC_H
+
+#include <inttypes.h>
+#include "qb_mcp251xfd.h"
+#ifdef __cplusplus
+
+extern "C"
+{
+
+#endif
+
+/**************************************************************************************************
+Algorithm variables 
+  Per ID decimation between RX & output: candec_rx() returns 1 for msgs to keep. Rules are kept in
+  ascending ID order (binary searched); IDs without a rule use the default mode of candec_init().
+  Kept & dropped msgs are counted per rule so downstream analysis knows what was elided.
+  DECCHANGE rules compare against a copy of the last kept payload in a caller owned buffer given to
+  candec_add() (sized for the ID, e.g. 8 bytes for a CAN 2.0 ID), so other rules cost no payload SRAM.
+**************************************************************************************************/
+#define DECALL			0				// keep every msg
+#define DECNTH			1				// keep every Nth msg (param = N)
+#define DECRATE			2				// keep at most param msgs per second (RX timestamps, RXTSEN=1)
+#define DECCHANGE		3				// keep only msgs whose payload (or length) changed
+#define DECNONE			4				// drop every msg
+
+typedef struct{
+	unsigned long id;												// ID word (CANID_EXT for extended IDs)
+	uint8_t mode;													// DECALL/DECNTH/DECRATE/DECCHANGE/DECNONE
+	uint8_t nCnt;													// DECNTH - msgs since the last kept
+	unsigned long param;											// DECNTH - N;DECRATE - min ticks between kept msgs;DECCHANGE - #of bytes in *ptrData
+	unsigned long tLast;											// DECRATE - timestamp of the last kept msg
+	unsigned long kept;												// #of msgs kept
+	unsigned long dropped;											// #of msgs dropped
+	uint8_t len;													// DECCHANGE - length of the last kept payload
+	uint8_t *ptrData;												// DECCHANGE - caller owned buffer of the last kept payload
+} decRule;
+
+typedef struct{
+	decRule *ptrTbl;												// caller owned rule storage
+	uint8_t size;													// #of rules the table holds
+	uint8_t cnt;													// #of rules registered
+	uint8_t defMode;												// mode for IDs without a rule (DECALL or DECNONE)
+	unsigned long defKept;											// #of msgs without a rule kept
+	unsigned long defDropped;										// #of msgs without a rule dropped
+} decCAN;
+
+void 			candec_init(decCAN *ptrDec,decRule *ptrTbl,uint8_t size,uint8_t defMode);
+uint8_t 		candec_add(decCAN *ptrDec,unsigned long idWord,uint8_t mode,unsigned long param,uint8_t *ptrBuf);
+decRule *		candec_find(decCAN *ptrDec,unsigned long idWord);
+uint8_t 		candec_rx(decCAN *ptrDec,msgCAN *ptrMsg);
+void 			candec_clear(decCAN *ptrDec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// QB_CANDEC_H
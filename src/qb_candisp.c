@@ -0,0 +1,181 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+
+#include <stdint.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_candisp.h"
+
+/**************************************************************************************************
+Purpose: 	Initializes a dispCAN object with caller owned table storage
+Inputs:		*ptrDisp	- dispCAN pointer
+			*ptrTbl		- dispEntry array
+			size		- #of entries in *ptrTbl
+
+Outputs:	None
+**************************************************************************************************/
+void candisp_init(dispCAN *ptrDisp,dispEntry *ptrTbl,uint8_t size){
+	ptrDisp->ptrTbl = ptrTbl;
+	ptrDisp->size = size;
+	ptrDisp->cnt = 0;
+	ptrDisp->runCnt = 0;
+	ptrDisp->matched = 0;
+	ptrDisp->unmatched = 0;
+}
+/**************************************************************************************************
+Purpose: 	Registers a handler by exact ID or ID/mask (call candisp_build() after the last add)
+Inputs:		*ptrDisp	- dispCAN pointer
+			idWord		- ID (| CANID_EXT for an extended ID)
+			mask		- ID bits to compare (DISPEXACT for an exact match); CANID_EXT is always compared
+			func		- handler
+
+Outputs:	result		- error code (defined in qb_mcp251xfd.h)
+							ERR_DISPFULL = table is full
+**************************************************************************************************/
+uint8_t candisp_add(dispCAN *ptrDisp,unsigned long idWord,unsigned long mask,dispFunc func){
+	dispEntry *ptrEnt;												// used to point to the new entry
+
+	if(ptrDisp->cnt >= ptrDisp->size)								// check if table is full
+		return ERR_DISPFULL;										// return error code
+	mask = (mask & CANID_MASK) | CANID_EXT;							// std & ext IDs never cross match
+	ptrEnt = &ptrDisp->ptrTbl[ptrDisp->cnt++];
+	ptrEnt->id = idWord & mask;
+	ptrEnt->mask = mask;
+	ptrEnt->func = func;
+	ptrDisp->runCnt = 0;											// table needs building
+	return 0;
+}
+/**************************************************************************************************
+Purpose: 	Counts the ID bits a mask compares (mask specificity)
+Inputs:		mask		- ID word mask
+
+Outputs:	result		- #of 1 bits
+**************************************************************************************************/
+static uint8_t candisp_bits(unsigned long mask){
+	uint8_t cnt = 0;												// used to count 1 bits
+
+	while(mask){													// clear the lowest 1 bit per pass
+		mask &= mask - 1;
+		cnt++;
+	}
+	return cnt;
+}
+/**************************************************************************************************
+Purpose: 	Checks if entry a sorts before entry b: more mask bits 1st (most specific), then higher mask
+				value (keeps equal masks together), then ascending IDs
+**************************************************************************************************/
+static uint8_t candisp_before(dispEntry *ptrA,dispEntry *ptrB){
+	uint8_t bitsA, bitsB;											// mask specificity
+
+	if(ptrA->mask != ptrB->mask){
+		bitsA = candisp_bits(ptrA->mask);
+		bitsB = candisp_bits(ptrB->mask);
+		if(bitsA != bitsB)
+			return bitsA > bitsB;
+		return ptrA->mask > ptrB->mask;
+	}
+	return ptrA->id <= ptrB->id;
+}
+/**************************************************************************************************
+Purpose: 	Sorts the table into mask runs (most specific mask, i.e. most mask bits 1st) of ascending IDs
+				A later entry with the same ID & mask as an earlier one replaces it.
+Inputs:		*ptrDisp	- dispCAN pointer
+
+Outputs:	result		- error code (defined in qb_mcp251xfd.h)
+							ERR_DISPMASKS = more than DISPMASKS distinct masks
+**************************************************************************************************/
+uint8_t candisp_build(dispCAN *ptrDisp){
+	dispEntry temp;													// used to hold the entry being inserted
+	dispEntry *ptrTbl = ptrDisp->ptrTbl;
+	uint8_t idx, jdx, cnt;											// used to step thru entries
+
+	for(idx=1;idx<ptrDisp->cnt;idx++){								// insertion sort (stable, setup time only)
+		temp = ptrTbl[idx];
+		for(jdx=idx;jdx>0;jdx--){
+			if(candisp_before(&ptrTbl[jdx-1],&temp))
+				break;
+			ptrTbl[jdx] = ptrTbl[jdx-1];
+		}
+		ptrTbl[jdx] = temp;
+	}
+	for(idx=1,cnt=1;idx<ptrDisp->cnt;idx++){						// drop duplicates, keeping the last registered
+		if((ptrTbl[idx].mask == ptrTbl[cnt-1].mask) && (ptrTbl[idx].id == ptrTbl[cnt-1].id))
+			ptrTbl[cnt-1] = ptrTbl[idx];
+		else
+			ptrTbl[cnt++] = ptrTbl[idx];
+	}
+	if(ptrDisp->cnt)
+		ptrDisp->cnt = cnt;
+
+	ptrDisp->runCnt = 0;
+	for(idx=0;idx<ptrDisp->cnt;idx++){								// loop thru entries
+		if((idx+1 == ptrDisp->cnt) || (ptrTbl[idx+1].mask != ptrTbl[idx].mask)){	// last entry of a mask run
+			if(ptrDisp->runCnt >= DISPMASKS){
+				ptrDisp->runCnt = 0;
+				return ERR_DISPMASKS;								// return error code
+			}
+			ptrDisp->runEnd[ptrDisp->runCnt++] = idx + 1;
+		}
+	}
+	return 0;
+}
+/**************************************************************************************************
+Purpose: 	Looks up the handler for an ID
+Inputs:		*ptrDisp	- dispCAN pointer
+			idWord		- ID (| CANID_EXT for an extended ID, as returned by mcp251xfd_hdr_unpack())
+
+Outputs:	result		- handler; 0 if no entry matches
+**************************************************************************************************/
+dispFunc candisp_find(dispCAN *ptrDisp,unsigned long idWord){
+	dispEntry *ptrTbl = ptrDisp->ptrTbl;
+	uint8_t run;													// used to step thru mask runs
+	uint8_t start, end;												// mask run bounds
+	uint8_t lo, hi, mid;											// binary search bounds
+	unsigned long key;												// ID word masked by the run mask
+
+	for(run=0,start=0;run<ptrDisp->runCnt;run++,start=end){		// loop thru mask runs
+		end = ptrDisp->runEnd[run];
+		key = idWord & ptrTbl[start].mask;
+		lo = start;
+		hi = end;
+		while(lo < hi){												// binary search for 1st id >= key
+			mid = lo + ((hi - lo) >> 1);
+			if(ptrTbl[mid].id < key)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		if((lo < end) && (ptrTbl[lo].id == key))					// match found
+			return ptrTbl[lo].func;
+	}
+	return 0;
+}
+/**************************************************************************************************
+Purpose: 	Calls the handler for a msg (e.g. one read by mcp251xfd_read_frame()); unmatched msgs are counted & dropped
+Inputs:		*ptrDisp	- dispCAN pointer
+			*ptrMsg		- msgCAN pointer
+
+Outputs:	result		- 1 = handler called; 0 = no handler
+**************************************************************************************************/
+uint8_t candisp_dispatch(dispCAN *ptrDisp,msgCAN *ptrMsg){
+	dispFunc func;													// handler
+
+	func = candisp_find(ptrDisp,mcp251xfd_hdr_unpack(&ptrMsg->sid07_00));
+	if(!func){														// no handler
+		ptrDisp->unmatched++;
+		return 0;
+	}
+	ptrDisp->matched++;
+	func(ptrMsg);
+	return 1;
+}
@@ -0,0 +1,62 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#ifndef	QB_CANDISP_H
+#define	QB_CANDISP_H
+
+#include <inttypes.h>
+#include "qb_mcp251xfd.h"
+#ifdef __cplusplus
+
+extern "C"
+{
+
+#endif
+
+/**************************************************************************************************
+Algorithm variables 
+  Handlers are registered by exact ID or ID/mask at setup (candisp_add()), then candisp_build() sorts
+  the table into one run per distinct mask. candisp_dispatch() binary searches each run (exact IDs
+  1st, then masks by decreasing #of mask bits), so a lookup costs O(DISPMASKS * log n).
+**************************************************************************************************/
+#define DISPMASKS		4				// max #of distinct masks (exact IDs count as 1)
+#define DISPEXACT		(CANID_EXT | CANID_MASK)	// mask for an exact ID match
+
+typedef void (*dispFunc)(msgCAN *ptrMsg);							// handler, called with the frame that matched
+
+typedef struct{
+	unsigned long id;												// ID word (CANID_EXT for extended IDs) & mask
+	unsigned long mask;												// ID word bits compared (CANID_EXT always compared)
+	dispFunc func;													// handler
+} dispEntry;
+
+typedef struct{
+	dispEntry *ptrTbl;												// caller owned table storage
+	uint8_t size;													// #of entries the table holds
+	uint8_t cnt;													// #of entries registered
+	uint8_t runCnt;													// #of mask runs (set by candisp_build())
+	uint8_t runEnd[DISPMASKS];										// index past the last entry of each mask run
+	unsigned long matched;											// #of frames dispatched to a handler
+	unsigned long unmatched;										// #of frames dropped (no handler)
+} dispCAN;
+
+void 			candisp_init(dispCAN *ptrDisp,dispEntry *ptrTbl,uint8_t size);
+uint8_t 		candisp_add(dispCAN *ptrDisp,unsigned long idWord,unsigned long mask,dispFunc func);
+uint8_t 		candisp_build(dispCAN *ptrDisp);
+dispFunc 		candisp_find(dispCAN *ptrDisp,unsigned long idWord);
+uint8_t 		candisp_dispatch(dispCAN *ptrDisp,msgCAN *ptrMsg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// QB_CANDISP_H
@@ -0,0 +1,88 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#ifndef	QB_CANFRAME_H
+#define	QB_CANFRAME_H
+
+#include <inttypes.h>
+#include "qb_mcp251xfd.h"
+
+/**************************************************************************************************
+Fixed layout CAN frames (C++11 sketches only)
+  CanFrame<Kind,Len> holds a TX message object exactly as laid out in MCP2517 memory (T0,T1,payload).
+  The DLC, T1 flags byte & object length are resolved at compile time, so write() clocks out a
+  constant #of bytes with no length calculation per frame. Kind = CANFRAME_STD or CANFRAME_EXT/FD/BRS
+  flags (qb_mcp251xfd.h).
+    CanFrame<CANFRAME_FD | CANFRAME_BRS,16> msg(0x123);
+    msg[0] = 0xAA;
+    msg.write(TXQ,&can1);
+**************************************************************************************************/
+template<uint8_t Kind,uint8_t Len>
+class CanFrame{
+	static_assert(!(Kind & ~(CANFRAME_EXT | CANFRAME_FD | CANFRAME_BRS)),"Kind must be CANFRAME_x flags");
+	static_assert(!(Kind & CANFRAME_BRS) || (Kind & CANFRAME_FD),"CANFRAME_BRS requires CANFRAME_FD");
+	static_assert((Kind & CANFRAME_FD) ? (Len <= 64) : (Len <= 8),"Len too long for the frame Kind");
+	static_assert(CANFD_DLC_LEN(CANFD_LEN_DLC(Len)) == Len,"Len must be a CAN FD payload length (0-8,12,16,20,24,32,48,64)");
+public:
+	enum : uint8_t{
+		DLC = CANFD_LEN_DLC(Len),									// DLC field
+		T1 = Kind | DLC,											// T1 byte 0 (DLC,IDE,RTR=0,BRS,FDF)
+		OBJLEN = 8 + CANFD_MEM_LEN(Len)								// #of message object bytes in MCP2517 memory
+	};
+	uint8_t obj[OBJLEN];											// T0,T1,payload
+
+	CanFrame() : obj() { setId(0); }
+	explicit CanFrame(unsigned long id) : obj() { setId(id); }
+
+	/**************************************************************************************************
+	Purpose: 	Packs a msg ID into T0 (refer to mcp251xfd_hdr_pack())
+	**************************************************************************************************/
+	void setId(unsigned long id){
+		mcp251xfd_hdr_pack(obj,(id & CANID_MASK) | ((Kind & CANFRAME_EXT) ? CANID_EXT : 0),T1);
+	}
+	/**************************************************************************************************
+	Purpose: 	Returns the msg ID packed in T0
+	**************************************************************************************************/
+	unsigned long id() const{
+		return mcp251xfd_hdr_unpack(obj) & CANID_MASK;
+	}
+	uint8_t *data(){ return &obj[8]; }
+	uint8_t &operator[](uint8_t idx){ return obj[8 + idx]; }
+	uint8_t operator[](uint8_t idx) const{ return obj[8 + idx]; }
+
+	/**************************************************************************************************
+	Purpose: 	Writes the frame to either TXQ or TX FIFO (refer to mcp251xfd_write_object())
+	**************************************************************************************************/
+	uint8_t write(uint8_t bufIdx,chnCAN *ptrChn) const{
+		return mcp251xfd_write_object(bufIdx,ptrChn,obj,OBJLEN);
+	}
+	/**************************************************************************************************
+	Purpose: 	Unpacks a msg read by mcp251xfd_read_frame() into the frame
+	Outputs:	result	- 1 if the msg matches the frame Kind & DLC (frame updated); else 0
+	**************************************************************************************************/
+	uint8_t unpack(const msgCAN *ptrMsg){
+		uint8_t idx;												// used to step thru data buffer
+		const uint8_t *ptr_u8 = &ptrMsg->sid07_00;					// point to the 1st byte of a message object
+
+		if((ptrMsg->ide != !!(Kind & CANFRAME_EXT)) || (ptrMsg->fdf != !!(Kind & CANFRAME_FD)) || (ptrMsg->dlc != DLC) || ptrMsg->rtr)
+			return 0;
+		for(idx=0;idx<4;idx++){										// loop thru T0
+			obj[idx] = ptr_u8[idx];
+		}
+		for(idx=0;(idx<Len) && (idx<MCP251XFD_MAXPAYLOAD);idx++){	// loop thru payload
+			obj[8 + idx] = ptrMsg->rxData[idx];
+		}
+		return 1;
+	}
+};
+
+#endif	// QB_CANFRAME_H
@@ -0,0 +1,179 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+
+#include <stdint.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_cangw.h"
+
+/**************************************************************************************************
+Purpose: 	Initializes a gwCAN object for 2 channels setup by mcp251xfd_init()
+Inputs:		*ptrGw		- gwCAN pointer
+			*ptrChn1	- chnCAN pointer of channel index 0
+			rxBuf1		- RX FIFO of channel index 0
+			txBuf1		- TX FIFO of channel index 0 (batch msgs deep, refer to mcp251xfd_txfifo_depth())
+			*ptrChn2	- chnCAN pointer of channel index 1
+			rxBuf2		- RX FIFO of channel index 1
+			txBuf2		- TX FIFO of channel index 1 (batch msgs deep)
+			*ptrTbl		- gwRoute array
+			size		- #of routes in *ptrTbl
+			batch		- max msgs drained per channel per cangw_poll() (1-255)
+
+Outputs:	None
+**************************************************************************************************/
+void cangw_init(gwCAN *ptrGw,chnCAN *ptrChn1,uint8_t rxBuf1,uint8_t txBuf1,chnCAN *ptrChn2,uint8_t rxBuf2,uint8_t txBuf2,gwRoute *ptrTbl,uint8_t size,uint8_t batch){
+	ptrGw->ptrChn[0] = ptrChn1;
+	ptrGw->ptrChn[1] = ptrChn2;
+	ptrGw->rxBuf[0] = rxBuf1;
+	ptrGw->rxBuf[1] = rxBuf2;
+	ptrGw->txBuf[0] = txBuf1;
+	ptrGw->txBuf[1] = txBuf2;
+	ptrGw->ptrTbl = ptrTbl;
+	ptrGw->size = size;
+	ptrGw->cnt = 0;
+	ptrGw->batch = (batch) ? batch : 1;
+	ptrGw->fwd[0] = ptrGw->fwd[1] = 0;
+	ptrGw->noRoute = 0;
+	ptrGw->txFull = 0;
+	ptrGw->latMin = 0xFFFFFFFFUL;
+	ptrGw->latMax = 0;
+	ptrGw->latSum = 0;
+	ptrGw->latCnt = 0;
+	ptrGw->rateT = 0;
+	ptrGw->rateFwd[0] = ptrGw->rateFwd[1] = 0;
+	ptrGw->ratePeak[0] = ptrGw->ratePeak[1] = 0;
+}
+/**************************************************************************************************
+Purpose: 	Adds a route (routes are matched in the order added)
+Inputs:		*ptrGw		- gwCAN pointer
+			src			- source channel index (0/1)
+			idWord		- ID to match (| CANID_EXT for an extended ID)
+			mask		- ID bits compared (0 = any ID;CANID_EXT | CANID_MASK = exact)
+			dst			- destination channel index (0/1)
+			flags		- GWFD/GWBRS/GWREMAP
+			newId		- GWREMAP - new ID (| CANID_EXT for an extended ID)
+
+Outputs:	result		- error code (defined in qb_mcp251xfd.h)
+							ERR_GWFULL = routing table is full
+**************************************************************************************************/
+uint8_t cangw_add(gwCAN *ptrGw,uint8_t src,unsigned long idWord,unsigned long mask,uint8_t dst,uint8_t flags,unsigned long newId){
+	gwRoute *ptrRoute;
+
+	if(ptrGw->cnt >= ptrGw->size)									// check if table is full
+		return ERR_GWFULL;											// return error code
+	ptrRoute = &ptrGw->ptrTbl[ptrGw->cnt++];
+	ptrRoute->src = src & 1;
+	ptrRoute->dst = dst & 1;
+	ptrRoute->flags = flags;
+	ptrRoute->mask = mask;
+	ptrRoute->id = idWord & mask;
+	ptrRoute->newId = newId;
+	ptrRoute->fwd = 0;
+	return 0;
+}
+/**************************************************************************************************
+Purpose: 	Forwards pending msgs of both channels (call from loop())
+Inputs:		*ptrGw		- gwCAN pointer
+
+Outputs:	result		- #of msgs forwarded
+**************************************************************************************************/
+uint8_t cangw_poll(gwCAN *ptrGw){
+	gwRoute *ptrRoute;
+	msgCAN *ptrMsg = &ptrGw->msg;
+	uint8_t *ptrHdr = &ptrGw->msg.sid07_00;							// T0,T1 header of the forwarding buffer
+	unsigned long idWord, tOld, lat;
+	uint8_t src, cnt, idx, t1, dst, len, dstMap, total;
+
+	total = 0;
+	for(src=0;src<2;src++){											// loop thru source channels
+		dstMap = 0;													// destinations loaded this batch
+		tOld = 0;
+		for(cnt=0;cnt<ptrGw->batch;cnt++){							// drain up to batch msgs
+			if(mcp251xfd_read_frame(ptrGw->rxBuf[src],ptrGw->ptrChn[src],ptrMsg))	// RX FIFO empty
+				break;
+			if(!cnt)
+				tOld = ptrMsg->tStamp;								// oldest msg of the batch
+			idWord = mcp251xfd_hdr_unpack(ptrHdr);
+			for(idx=0,ptrRoute=ptrGw->ptrTbl;idx<ptrGw->cnt;idx++,ptrRoute++){	// 1st matching route
+				if((ptrRoute->src == src) && ((idWord & ptrRoute->mask) == ptrRoute->id))
+					break;
+			}
+			if(idx >= ptrGw->cnt){									// no route
+				ptrGw->noRoute++;
+				continue;
+			}
+			t1 = ptrHdr[4];											// DLC,IDE,RTR,BRS,FDF
+			if((ptrRoute->flags & GWFD) && !(t1 & (CANFRAME_FD | CANFRAME_RTR))){	// CAN 2.0 data frame -> CAN FD
+				if((t1 & 0x0F) > 8)									// CAN 2.0 DLC 9-15 = 8 bytes
+					t1 = (t1 & 0xF0) | 8;
+				t1 |= CANFRAME_FD;
+			}
+			if((ptrRoute->flags & GWBRS) && (t1 & CANFRAME_FD))
+				t1 |= CANFRAME_BRS;
+			if(ptrRoute->flags & GWREMAP)
+				idWord = ptrRoute->newId;
+			if(mcp251xfd_len_payload(t1 >> 7,t1 & 0x0F) > MCP251XFD_MAXPAYLOAD)	// RX payload was truncated
+				t1 = (t1 & 0xF0) | CANFD_LEN_DLC(MCP251XFD_MAXPAYLOAD);
+			mcp251xfd_hdr_pack(ptrHdr,idWord,t1);					// rewrite header in place
+			dst = ptrRoute->dst;
+			len = mcp251xfd_mem_payload(t1 >> 7,t1 & 0x0F);
+			if(mcp251xfd_write_parts(ptrGw->txBuf[dst],ptrGw->ptrChn[dst],ptrHdr,ptrMsg->rxData,len)){	// destination TX FIFO full
+				if(!((dstMap >> dst) & 1) ||							// nothing of this batch to send
+				   mcp251xfd_start_transmit(ptrGw->txBuf[dst],ptrGw->ptrChn[dst]) ||	// request the batch so far
+				   mcp251xfd_write_parts(ptrGw->txBuf[dst],ptrGw->ptrChn[dst],ptrHdr,ptrMsg->rxData,len)){	// & load again once
+					ptrGw->txFull++;
+					continue;
+				}
+			}
+			dstMap |= (1 << dst);
+			ptrRoute->fwd++;
+			ptrGw->fwd[t1 >> 7]++;
+			total++;
+		}
+		for(idx=0;idx<2;idx++){										// 1 transmit request per destination
+			if((dstMap >> idx) & 1)
+				mcp251xfd_start_transmit(ptrGw->txBuf[idx],ptrGw->ptrChn[idx]);
+		}
+		if(dstMap && tOld){											// latency of the oldest msg (RXTSEN=1)
+			lat = mcp251xfd_tbc_read(ptrGw->ptrChn[src]) - tOld;
+			if(lat < ptrGw->latMin)	ptrGw->latMin = lat;
+			if(lat > ptrGw->latMax)	ptrGw->latMax = lat;
+			ptrGw->latSum += lat;
+			ptrGw->latCnt++;
+		}
+	}
+	return total;
+}
+/**************************************************************************************************
+Purpose: 	Updates the peak forwarded msgs/s (call periodically, e.g. every second)
+Inputs:		*ptrGw		- gwCAN pointer
+			tNow		- current time in ms (e.g. millis())
+
+Outputs:	None
+**************************************************************************************************/
+void cangw_rate(gwCAN *ptrGw,unsigned long tNow){
+	unsigned long dt, rate;
+	uint8_t idx;
+
+	dt = tNow - ptrGw->rateT;
+	if(dt && ptrGw->rateT){
+		for(idx=0;idx<2;idx++){										// CAN 2.0 & CAN FD
+			rate = ((ptrGw->fwd[idx] - ptrGw->rateFwd[idx]) * 1000UL) / dt;
+			if(rate > ptrGw->ratePeak[idx])
+				ptrGw->ratePeak[idx] = rate;
+		}
+	}
+	ptrGw->rateT = tNow;
+	ptrGw->rateFwd[0] = ptrGw->fwd[0];
+	ptrGw->rateFwd[1] = ptrGw->fwd[1];
+}
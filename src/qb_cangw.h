@@ -0,0 +1,80 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#ifndef	QB_CANGW_H
+#define	QB_CANGW_H
+
+#include <inttypes.h>
+#include "qb_mcp251xfd.h"
+#ifdef __cplusplus
+
+extern "C"
+{
+
+#endif
+
+/**************************************************************************************************
+Algorithm variables 
+  Gateway between the 2 channels: cangw_poll() drains up to batch msgs from the RX FIFO of each
+  channel, matches each against the routing table (1st match wins) & rewrites the header in place
+  (optional ID remap, CAN 2.0 -> CAN FD conversion) before loading it into the destination TX FIFO
+  straight from the RX buffer (mcp251xfd_write_parts()). One transmit request is made per destination
+  after the batch, so the TX FIFOs should hold batch msgs (mcp251xfd_txfifo_depth()); a TX FIFO that
+  fills up gets the transmit request early & the msg is loaded again once (txFull counts the msgs still
+  dropped, e.g. by a 1 msg deep TXQ that has not sent yet). With RXTSEN=1 on the RX FIFOs, forwarding
+  latency (RX timestamp -> loaded into the TX FIFO) is measured once per batch with the source channel TBC.
+**************************************************************************************************/
+#define GWFD			0x01			// route flag - convert CAN 2.0 msgs to CAN FD
+#define GWBRS			0x02			// route flag - set BRS on CAN FD msgs
+#define GWREMAP			0x04			// route flag - replace the ID with newId
+
+typedef struct{
+	uint8_t src;													// source channel index (0 = 1st chnCAN;1 = 2nd chnCAN)
+	uint8_t dst;													// destination channel index
+	uint8_t flags;													// GWFD/GWBRS/GWREMAP
+	unsigned long id;												// ID word to match (after mask)
+	unsigned long mask;												// ID word bits compared (0 = any ID)
+	unsigned long newId;											// GWREMAP - new ID word (CANID_EXT for extended IDs)
+	unsigned long fwd;												// #of msgs forwarded by the route
+} gwRoute;
+
+typedef struct{
+	chnCAN *ptrChn[2];												// channels
+	uint8_t rxBuf[2];												// RX FIFO of each channel
+	uint8_t txBuf[2];												// TX FIFO (batch deep) of each channel
+	gwRoute *ptrTbl;												// caller owned routing table
+	uint8_t size;													// #of routes the table holds
+	uint8_t cnt;													// #of routes added
+	uint8_t batch;													// max msgs drained per channel per poll
+	msgCAN msg;														// forwarding buffer (RX in place, header rewritten in place)
+	unsigned long fwd[2];											// #of msgs forwarded [0] = CAN 2.0;[1] = CAN FD (as sent)
+	unsigned long noRoute;											// #of msgs dropped, no route
+	unsigned long txFull;											// #of msgs dropped, destination TX FIFO full
+	unsigned long latMin;											// min forwarding latency (1/40MHz periods)
+	unsigned long latMax;											// max forwarding latency (1/40MHz periods)
+	unsigned long latSum;											// sum of latency samples (mean = latSum/latCnt)
+	unsigned long latCnt;											// #of latency samples
+	unsigned long rateT;											// cangw_rate() - time of the last call
+	unsigned long rateFwd[2];										// cangw_rate() - fwd[] at the last call
+	unsigned long ratePeak[2];										// peak msgs/s forwarded [0] = CAN 2.0;[1] = CAN FD
+} gwCAN;
+
+void 			cangw_init(gwCAN *ptrGw,chnCAN *ptrChn1,uint8_t rxBuf1,uint8_t txBuf1,chnCAN *ptrChn2,uint8_t rxBuf2,uint8_t txBuf2,gwRoute *ptrTbl,uint8_t size,uint8_t batch);
+uint8_t 		cangw_add(gwCAN *ptrGw,uint8_t src,unsigned long idWord,unsigned long mask,uint8_t dst,uint8_t flags,unsigned long newId);
+uint8_t 		cangw_poll(gwCAN *ptrGw);
+void 			cangw_rate(gwCAN *ptrGw,unsigned long tNow);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// QB_CANGW_H
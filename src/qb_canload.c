@@ -0,0 +1,165 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+
+#include <stdint.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_canload.h"
+
+/**************************************************************************************************
+Purpose: 	Initializes a loadCAN object for a channel
+Inputs:		*ptrLoad	- loadCAN pointer
+			speed		- nominal CAN speed the channel was initialized with (CANSPEED_125/250/500)
+			dataBps		- CAN FD data phase bit rate (CANFD_DBPS for channels setup by mcp251xfd_init())
+			winMs		- sliding window length in ms (>= LOADBKTS)
+
+Outputs:	None
+**************************************************************************************************/
+void canload_init(loadCAN *ptrLoad,uint8_t speed,unsigned long dataBps,uint16_t winMs){
+	uint8_t idx;													// used to step thru buckets
+
+	ptrLoad->nomTq = MCP251XFD_TBCLK / (1000000UL / (speed + 1));	// CANSPEED_x = (1Mbps / nominal bit rate) - 1
+	ptrLoad->dataTq = MCP251XFD_TBCLK / dataBps;					// ticks per data phase bit
+	ptrLoad->bktTicks = (MCP251XFD_TBCLK / 1000) * winMs / LOADBKTS;	// bucket length in ticks
+	for(idx=0;idx<LOADBKTS;idx++){									// loop thru buckets
+		ptrLoad->bktBusy[idx] = 0;									// clear bucket
+	}
+	ptrLoad->bktStart = 0;
+	ptrLoad->bktIdx = 0;
+	ptrLoad->bktFill = 0;
+	ptrLoad->started = 0;
+	ptrLoad->load = 0;
+	ptrLoad->peak = 0;
+}
+/**************************************************************************************************
+Purpose: 	Returns the length in bits of a CAN frame on the bus (SOF thru IFS)
+				Stuff bits are estimated as (stuffable bits - 1)/LOADSTUFFDIV. For CAN FD frames the
+				fixed stuff bits & stuff count of the CRC field are exact.
+Inputs:		ide				- message IDE field
+			fdf				- message FDF field
+			brs				- message BRS field
+			rtr				- message RTR field (CAN 2.0 only)
+			dlc				- message DLC field
+			*ptrDataBits	- pointer to store the #of bits sent at the data phase bit rate (0 if !brs)
+
+Outputs:	result			- #of bits sent at the nominal bit rate
+**************************************************************************************************/
+uint16_t canload_frame_bits(uint8_t ide,uint8_t fdf,uint8_t brs,uint8_t rtr,uint8_t dlc,uint16_t *ptrDataBits){
+	uint16_t arbBits;												// stuffable bits of the arbitration phase
+	uint16_t datBits;												// stuffable bits of the data phase
+	uint16_t crcBits;												// CRC field bits (not dynamically stuffed in CAN FD)
+	uint16_t pLen;													// #of payload bytes
+
+	pLen = (rtr && !fdf) ? 0 : mcp251xfd_len_payload(fdf,dlc);		// remote frames carry no payload
+	if(!fdf){														// CAN 2.0 frame
+		arbBits = (ide) ? 54 : 34;									// SOF thru CRC excluding the data field
+		arbBits += 8*pLen;											// data field
+		*ptrDataBits = 0;
+		return arbBits + (arbBits - 1)/LOADSTUFFDIV + 13;			// + CRC del,ACK,ACK del,EOF,IFS
+	}
+	arbBits = (ide) ? 36 : 17;										// SOF thru BRS
+	datBits = 5 + 8*pLen;											// ESI,DLC,data field
+	crcBits = (pLen > 16) ? (4 + 21 + 7) : (4 + 17 + 6);			// stuff count,CRC,fixed stuff bits
+	datBits += (datBits - 1)/LOADSTUFFDIV + crcBits + 1;			// + CRC del
+	arbBits += (arbBits - 1)/LOADSTUFFDIV + 12;						// + ACK,ACK del,EOF,IFS
+	if(!brs){														// whole frame at nominal bit rate
+		*ptrDataBits = 0;
+		return arbBits + datBits;
+	}
+	*ptrDataBits = datBits;
+	return arbBits;
+}
+/**************************************************************************************************
+Purpose: 	Advances the sliding window up to a timestamp, closing buckets as they expire; a timestamp
+				before the current bucket start leaves the window as is
+Inputs:		*ptrLoad	- loadCAN pointer
+			tNow		- current timestamp (1/40MHz periods, RX msg timestamp or mcp251xfd_tbc_read())
+
+Outputs:	None
+**************************************************************************************************/
+void canload_update(loadCAN *ptrLoad,unsigned long tNow){
+	uint8_t idx, cnt;												// used to step thru buckets
+	unsigned long busy;												// window busy ticks
+
+	if(!ptrLoad->started){											// 1st timestamp seen
+		ptrLoad->bktStart = tNow;									// start 1st bucket
+		ptrLoad->started = 1;
+		return;
+	}
+	if((long)(tNow - ptrLoad->bktStart) < 0)						// late frame (RX timestamp older than a TBC update)
+		return;														// stays in the current bucket
+	for(cnt=0;(tNow - ptrLoad->bktStart) >= ptrLoad->bktTicks;cnt++){	// current bucket has expired
+		if(cnt >= LOADBKTS){										// whole window has expired
+			for(idx=0;idx<LOADBKTS;idx++){							// loop thru buckets
+				ptrLoad->bktBusy[idx] = 0;							// clear bucket
+			}
+			ptrLoad->bktStart = tNow;								// restart window at current timestamp
+			ptrLoad->load = 0;
+			return;
+		}
+		if(ptrLoad->bktFill < LOADBKTS)								// window warming up
+			ptrLoad->bktFill++;
+		busy = 0;
+		for(idx=0;idx<LOADBKTS;idx++){								// loop thru buckets
+			busy += ptrLoad->bktBusy[idx];							// sum window busy ticks
+		}
+		busy /= (ptrLoad->bktFill * ptrLoad->bktTicks) / 1000;		// convert to 0.1 % of window length
+		ptrLoad->load = (busy > 1000) ? 1000 : busy;				// stuffing estimate can overshoot a saturated bus
+		if(ptrLoad->load > ptrLoad->peak)
+			ptrLoad->peak = ptrLoad->load;
+
+		ptrLoad->bktIdx = (ptrLoad->bktIdx + 1) % LOADBKTS;			// open next bucket
+		ptrLoad->bktBusy[ptrLoad->bktIdx] = 0;
+		ptrLoad->bktStart += ptrLoad->bktTicks;
+	}
+}
+/**************************************************************************************************
+Purpose: 	Accounts the bus time of a CAN frame into the sliding window
+Inputs:		*ptrLoad	- loadCAN pointer
+			tStamp		- timestamp of the frame (1/40MHz periods)
+			ide			- message IDE field
+			fdf			- message FDF field
+			brs			- message BRS field
+			rtr			- message RTR field
+			dlc			- message DLC field
+
+Outputs:	None
+**************************************************************************************************/
+void canload_add(loadCAN *ptrLoad,unsigned long tStamp,uint8_t ide,uint8_t fdf,uint8_t brs,uint8_t rtr,uint8_t dlc){
+	uint16_t nomBits, datBits;										// frame bits at nominal & data phase bit rates
+
+	canload_update(ptrLoad,tStamp);									// close expired buckets
+	nomBits = canload_frame_bits(ide,fdf,brs,rtr,dlc,&datBits);		// calculate frame length
+	ptrLoad->bktBusy[ptrLoad->bktIdx] += (unsigned long)nomBits * ptrLoad->nomTq + (unsigned long)datBits * ptrLoad->dataTq;
+}
+/**************************************************************************************************
+Purpose: 	Accounts a msg read by mcp251xfd_read_frame() (RX FIFO must have RXTSEN=1)
+Inputs:		*ptrLoad	- loadCAN pointer
+			*ptrMsg		- msgCAN pointer the msg was read into
+
+Outputs:	None
+**************************************************************************************************/
+void canload_rx(loadCAN *ptrLoad,msgCAN *ptrMsg){
+	canload_add(ptrLoad,ptrMsg->tStamp,ptrMsg->ide,ptrMsg->fdf,ptrMsg->brs,ptrMsg->rtr,ptrMsg->dlc);
+}
+/**************************************************************************************************
+Purpose: 	Accounts a msg loaded by mcp251xfd_write_frame(), timestamped with the time base counter
+Inputs:		*ptrLoad	- loadCAN pointer
+			*ptrChn		- chnCAN pointer the msg was loaded on
+			*ptrMsg		- msgCAN pointer the msg was loaded from
+
+Outputs:	None
+**************************************************************************************************/
+void canload_tx(loadCAN *ptrLoad,chnCAN *ptrChn,msgCAN *ptrMsg){
+	canload_add(ptrLoad,mcp251xfd_tbc_read(ptrChn),ptrMsg->ide,ptrMsg->fdf,ptrMsg->brs,ptrMsg->rtr,ptrMsg->dlc);
+}
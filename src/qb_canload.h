@@ -0,0 +1,55 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#ifndef	QB_CANLOAD_H
+#define	QB_CANLOAD_H
+
+#include <inttypes.h>
+#include "qb_mcp251xfd.h"
+#ifdef __cplusplus
+
+extern "C"
+{
+
+#endif
+
+/**************************************************************************************************
+Algorithm variables 
+**************************************************************************************************/
+#define LOADBKTS		8				// #of buckets the sliding window is split into
+#define LOADSTUFFDIV	4				// stuff bit estimate = (stuffable bits - 1)/LOADSTUFFDIV (4=worst case)
+
+typedef struct{
+	uint16_t nomTq;													// timestamp ticks per nominal bit
+	uint16_t dataTq;												// timestamp ticks per data phase bit
+	unsigned long bktTicks;											// bucket length in timestamp ticks
+	unsigned long bktStart;											// timestamp of current bucket start
+	unsigned long bktBusy[LOADBKTS];								// bus busy timestamp ticks per bucket
+	uint8_t bktIdx;													// current bucket index
+	uint8_t bktFill;												// #of closed buckets (window warm up)
+	uint8_t started;												// 1st timestamp seen
+	uint16_t load;													// bus utilisation over the window (0.1 %)
+	uint16_t peak;													// peak bus utilisation (0.1 %)
+} loadCAN;
+
+void 			canload_init(loadCAN *ptrLoad,uint8_t speed,unsigned long dataBps,uint16_t winMs);
+uint16_t 		canload_frame_bits(uint8_t ide,uint8_t fdf,uint8_t brs,uint8_t rtr,uint8_t dlc,uint16_t *ptrDataBits);
+void 			canload_add(loadCAN *ptrLoad,unsigned long tStamp,uint8_t ide,uint8_t fdf,uint8_t brs,uint8_t rtr,uint8_t dlc);
+void 			canload_rx(loadCAN *ptrLoad,msgCAN *ptrMsg);
+void 			canload_tx(loadCAN *ptrLoad,chnCAN *ptrChn,msgCAN *ptrMsg);
+void 			canload_update(loadCAN *ptrLoad,unsigned long tNow);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// QB_CANLOAD_H
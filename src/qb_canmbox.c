@@ -0,0 +1,166 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+
+#include <stdint.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_canmbox.h"
+
+#define MBOX_BARRIER()	__asm__ __volatile__("" ::: "memory")	// keep slot accesses between the seq updates
+#define MBOX_HASH(id)	((uint8_t)((id) ^ ((id) >> 8) ^ ((id) >> 16) ^ ((id) >> 24)))	// byte wise fold of the ID word
+
+/**************************************************************************************************
+Purpose: 	Initializes a mboxCAN object with caller owned slot storage
+Inputs:		*ptrMbox	- mboxCAN pointer
+			*ptrSlot	- mboxSlot array
+			size		- #of slots in *ptrSlot (1-128; rounded down to a power of 2, keep >= 2x #of IDs)
+
+Outputs:	result		- error code (defined in qb_mcp251xfd.h)
+							ERR_MBOXSIZE = no slots (size 0); the mailbox stays empty (no ID can be added)
+**************************************************************************************************/
+uint8_t canmbox_init(mboxCAN *ptrMbox,mboxSlot *ptrSlot,uint8_t size){
+	uint8_t idx;													// used to step thru slots
+
+	ptrMbox->cnt = 0;
+	ptrMbox->unmatched = 0;
+	if(!size || !ptrSlot){											// no slot storage
+		ptrMbox->ptrSlot = 0;
+		ptrMbox->mask = 0;
+		return ERR_MBOXSIZE;										// return error code
+	}
+	for(idx=1;(idx<=64) && ((idx << 1) <= size);idx<<=1);			// largest power of 2 <= size
+	ptrMbox->ptrSlot = ptrSlot;
+	ptrMbox->mask = idx - 1;
+	for(idx=0;idx<=ptrMbox->mask;idx++){							// loop thru slots
+		ptrSlot[idx].id = MBOXFREE;
+		ptrSlot[idx].seq = 0;
+		ptrSlot[idx].len = 0;
+		ptrSlot[idx].tStamp = 0;
+	}
+	return 0;
+}
+/**************************************************************************************************
+Purpose: 	Looks up the slot of a subscribed ID
+Inputs:		*ptrMbox	- mboxCAN pointer
+			idWord		- ID (| CANID_EXT for an extended ID, as returned by mcp251xfd_hdr_unpack())
+
+Outputs:	result		- slot index; MBOXNONE if the ID is not subscribed
+**************************************************************************************************/
+uint8_t canmbox_find(mboxCAN *ptrMbox,unsigned long idWord){
+	uint8_t slot, probe;											// used to step thru slots
+
+	if(!ptrMbox->ptrSlot)											// no slots (canmbox_init() failed)
+		return MBOXNONE;
+	slot = MBOX_HASH(idWord) & ptrMbox->mask;
+	for(probe=0;probe<=ptrMbox->mask;probe++){						// linear probing
+		if(ptrMbox->ptrSlot[slot].id == idWord)
+			return slot;
+		if(ptrMbox->ptrSlot[slot].id == MBOXFREE)					// end of probe chain
+			break;
+		slot = (slot + 1) & ptrMbox->mask;
+	}
+	return MBOXNONE;
+}
+/**************************************************************************************************
+Purpose: 	Subscribes an ID (setup time)
+Inputs:		*ptrMbox	- mboxCAN pointer
+			idWord		- ID (| CANID_EXT for an extended ID)
+
+Outputs:	result		- slot index to pass to canmbox_read(); MBOXNONE if the table is full
+**************************************************************************************************/
+uint8_t canmbox_add(mboxCAN *ptrMbox,unsigned long idWord){
+	uint8_t slot, probe;											// used to step thru slots
+
+	if(!ptrMbox->ptrSlot)											// no slots (canmbox_init() failed)
+		return MBOXNONE;
+	idWord &= (CANID_EXT | CANID_MASK);
+	slot = MBOX_HASH(idWord) & ptrMbox->mask;
+	for(probe=0;probe<=ptrMbox->mask;probe++){						// linear probing
+		if(ptrMbox->ptrSlot[slot].id == idWord)						// already subscribed
+			return slot;
+		if(ptrMbox->ptrSlot[slot].id == MBOXFREE){					// free slot
+			ptrMbox->ptrSlot[slot].id = idWord;
+			ptrMbox->cnt++;
+			return slot;
+		}
+		slot = (slot + 1) & ptrMbox->mask;
+	}
+	return MBOXNONE;
+}
+/**************************************************************************************************
+Purpose: 	Overwrites the slot of a msg's ID with its payload & timestamp (e.g. after mcp251xfd_read_frame())
+				Safe to call from an ISR while the main loop uses canmbox_read().
+Inputs:		*ptrMbox	- mboxCAN pointer
+			*ptrMsg		- msgCAN pointer
+
+Outputs:	result		- 1 = slot updated; 0 = ID not subscribed (msg counted & dropped)
+**************************************************************************************************/
+uint8_t canmbox_rx(mboxCAN *ptrMbox,msgCAN *ptrMsg){
+	mboxSlot *ptrSlot;												// slot of the msg ID
+	uint8_t slot, idx, len;
+
+	slot = canmbox_find(ptrMbox,mcp251xfd_hdr_unpack(&ptrMsg->sid07_00));
+	if(slot == MBOXNONE){											// ID not subscribed
+		ptrMbox->unmatched++;
+		return 0;
+	}
+	ptrSlot = &ptrMbox->ptrSlot[slot];
+	len = (ptrMsg->pLen > MBOXLEN) ? MBOXLEN : ptrMsg->pLen;
+
+	ptrSlot->seq++;													// odd = update in progress
+	MBOX_BARRIER();
+	ptrSlot->len = len;
+	ptrSlot->tStamp = ptrMsg->tStamp;
+	for(idx=0;idx<len;idx++){										// loop thru payload
+		ptrSlot->data[idx] = ptrMsg->rxData[idx];
+	}
+	MBOX_BARRIER();
+	ptrSlot->seq += (ptrSlot->seq == 0xFF) ? 3 : 1;					// even = stable (skip 0 = never received)
+	return 1;
+}
+/**************************************************************************************************
+Purpose: 	Copies the latest value of a slot without tearing against canmbox_rx()
+Inputs:		*ptrMbox	- mboxCAN pointer
+			slot		- slot index returned by canmbox_add()
+			*ptrBuf		- buffer for the payload (MBOXLEN bytes)
+			*ptrLen		- pointer to store the #of payload bytes (0 to ignore)
+			*ptrTstamp	- pointer to store the msg timestamp (0 to ignore)
+
+Outputs:	result		- sequence number of the copy (0 = never received, MBOXNONE/slot past the table
+						  or mailbox without slots - nothing copied; changes on every update)
+**************************************************************************************************/
+uint8_t canmbox_read(mboxCAN *ptrMbox,uint8_t slot,uint8_t *ptrBuf,uint8_t *ptrLen,unsigned long *ptrTstamp){
+	mboxSlot *ptrSlot;
+	uint8_t seq, idx, len;
+	unsigned long tStamp;
+
+	if(!ptrMbox->ptrSlot || (slot > ptrMbox->mask))				// failed canmbox_init() or canmbox_add()
+		return 0;
+	ptrSlot = &ptrMbox->ptrSlot[slot];
+	do{
+		do{
+			seq = ptrSlot->seq;										// wait out an update in progress
+		}while(seq & 1);
+		MBOX_BARRIER();
+		len = ptrSlot->len;
+		tStamp = ptrSlot->tStamp;
+		for(idx=0;idx<len;idx++){									// loop thru payload
+			ptrBuf[idx] = ptrSlot->data[idx];
+		}
+		MBOX_BARRIER();
+	}while(ptrSlot->seq != seq);									// retry if updated during the copy
+
+	if(ptrLen)		*ptrLen = len;
+	if(ptrTstamp)	*ptrTstamp = tStamp;
+	return seq;
+}
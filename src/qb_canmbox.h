@@ -0,0 +1,64 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#ifndef	QB_CANMBOX_H
+#define	QB_CANMBOX_H
+
+#include <inttypes.h>
+#include "qb_mcp251xfd.h"
+#ifdef __cplusplus
+
+extern "C"
+{
+
+#endif
+
+/**************************************************************************************************
+Algorithm variables 
+  Latest value mailboxes: one slot per subscribed ID, overwritten in place by canmbox_rx() (main loop
+  or ISR). Slots are an open addressing hash table keyed by ID word; canmbox_add() returns the slot
+  index so readers go straight to it. Each slot carries a sequence number that is odd while an update
+  is in progress; canmbox_read() retries until it copies a slot with the same even sequence number
+  before & after, so a read interrupted by an update is never torn.
+**************************************************************************************************/
+#ifndef MBOXLEN
+#define MBOXLEN			8				// #of payload bytes kept per slot (longer payloads are truncated)
+#endif
+#define MBOXNONE		0xFF			// slot index returned when an ID is not subscribed / table full
+#define MBOXFREE		0xFFFFFFFFUL	// ID word of an unused slot
+
+typedef struct{
+	unsigned long id;												// ID word (CANID_EXT for extended IDs); MBOXFREE = unused
+	volatile uint8_t seq;											// sequence number (0 = never received;odd = update in progress)
+	uint8_t len;													// #of payload bytes in data
+	unsigned long tStamp;											// timestamp of the msg (1/40MHz periods)
+	uint8_t data[MBOXLEN];											// payload of the latest msg
+} mboxSlot;
+
+typedef struct{
+	mboxSlot *ptrSlot;												// caller owned slot storage (0 = none)
+	uint8_t mask;													// #of slots used - 1 (power of 2)
+	uint8_t cnt;													// #of IDs subscribed
+	unsigned long unmatched;										// #of msgs for IDs not subscribed
+} mboxCAN;
+
+uint8_t 		canmbox_init(mboxCAN *ptrMbox,mboxSlot *ptrSlot,uint8_t size);
+uint8_t 		canmbox_add(mboxCAN *ptrMbox,unsigned long idWord);
+uint8_t 		canmbox_find(mboxCAN *ptrMbox,unsigned long idWord);
+uint8_t 		canmbox_rx(mboxCAN *ptrMbox,msgCAN *ptrMsg);
+uint8_t 		canmbox_read(mboxCAN *ptrMbox,uint8_t slot,uint8_t *ptrBuf,uint8_t *ptrLen,unsigned long *ptrTstamp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// QB_CANMBOX_H
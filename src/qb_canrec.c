@@ -0,0 +1,133 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+
+#include <stdint.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_mcp251xfd_defs.h"
+#include "qb_canrec.h"
+
+/**************************************************************************************************
+Purpose: 	Initializes a recCAN object (call after mcp251xfd_init())
+Inputs:		*ptrRec		- recCAN pointer
+			*ptrChn		- chnCAN pointer
+			txMask		- TX buffers to re-request after a bus off (bit 0 = TXQ;bit n = FIFOn)
+			backoff		- 1st back-off in ms (0 = no hold)
+			backoffMax	- max back-off in ms
+			quiet		- time in ms TEC has to stay 0 after TX is re-enabled to end a bus off streak
+							(e.g. 1000; the back-off restarts at backoff after it)
+
+Outputs:	None
+**************************************************************************************************/
+void canrec_init(recCAN *ptrRec,chnCAN *ptrChn,unsigned long txMask,uint16_t backoff,uint16_t backoffMax,uint16_t quiet){
+	ptrRec->ptrChn = ptrChn;
+	ptrRec->txMask = txMask;
+	ptrRec->backoff = backoff;
+	ptrRec->backoffMax = backoffMax;
+	ptrRec->quiet = quiet;
+	ptrRec->state = RECACTIVE;
+	ptrRec->streak = 0;
+	ptrRec->opMod = CANMODE_NORMALFD;
+	ptrRec->tec = 0;
+	ptrRec->rec = 0;
+	ptrRec->tOff = 0;
+	ptrRec->tHold = 0;
+	ptrRec->tQuiet = 0;
+	ptrRec->recLast = 0;
+	ptrRec->recMax = 0;
+	ptrRec->errPasv = 0;
+	ptrRec->busOff = 0;
+}
+/**************************************************************************************************
+Purpose: 	Re-enables TX after a bus off & re-requests the TX buffers in txMask
+Inputs:		*ptrRec		- recCAN pointer
+			tNow		- current time in ms
+
+Outputs:	None
+**************************************************************************************************/
+static void canrec_restore(recCAN *ptrRec,unsigned long tNow){
+	unsigned long dt;
+	uint8_t bufIdx;
+
+	for(bufIdx=0;bufIdx<32;bufIdx++){								// loop thru TX buffers
+		if((ptrRec->txMask >> bufIdx) & 1)
+			mcp251xfd_start_transmit(bufIdx,ptrRec->ptrChn);		// ignored if the buffer is empty
+	}
+	dt = tNow - ptrRec->tOff;
+	ptrRec->recLast = dt;
+	if(dt > ptrRec->recMax)
+		ptrRec->recMax = dt;
+	ptrRec->tQuiet = tNow + ptrRec->quiet;							// streak ends if TEC stays 0 until then
+	ptrRec->state = RECACTIVE;
+}
+/**************************************************************************************************
+Purpose: 	Tracks the error state & runs the bus off recovery (call from loop(), e.g. every 1-10ms)
+Inputs:		*ptrRec		- recCAN pointer
+			tNow		- current time in ms (e.g. millis())
+
+Outputs:	result		- RECACTIVE/RECPASSIVE/RECBUSOFF/RECHOLD
+**************************************************************************************************/
+uint8_t canrec_poll(recCAN *ptrRec,unsigned long tNow){
+	chnCAN *ptrChn = ptrRec->ptrChn;
+	unsigned long hold;
+	uint8_t flg;
+
+	mcp251xfd_read_register(ADDR_C1TREC,ptrChn,4);					// read REC,TEC & error state flags
+	ptrRec->rec = ptrChn->regRd[0];
+	ptrRec->tec = ptrChn->regRd[1];
+	flg = ptrChn->regRd[2];
+
+	if((flg >> TXBO) & 1){											// bus off
+		if(ptrRec->state != RECBUSOFF){
+			ptrRec->state = RECBUSOFF;
+			ptrRec->tOff = tNow;
+			ptrRec->busOff++;
+			if(ptrRec->streak < 255)
+				ptrRec->streak++;
+		}
+		return ptrRec->state;
+	}
+	if(ptrRec->state == RECBUSOFF){									// MCP2517 left bus off
+		hold = ptrRec->backoff;
+		hold <<= (ptrRec->streak > 8) ? 7 : ptrRec->streak - 1;		// double per bus off in the streak
+		if(hold > ptrRec->backoffMax)
+			hold = ptrRec->backoffMax;
+		ptrRec->opMod = mcp251xfd_mode_get(ptrChn);
+		if(!hold || (ptrRec->opMod != CANMODE_NORMALFD) || mcp251xfd_mode_set(ptrChn,CANMODE_RESTRICT))
+			canrec_restore(ptrRec,tNow);							// no hold (restricted mode would reset FIFOs)
+		else{
+			ptrRec->state = RECHOLD;
+			ptrRec->tHold = tNow + hold;
+		}
+		return ptrRec->state;
+	}
+	if(ptrRec->state == RECHOLD){									// back-off running
+		if((long)(tNow - ptrRec->tHold) < 0)
+			return ptrRec->state;
+		mcp251xfd_mode_set(ptrChn,ptrRec->opMod);					// allow TX again
+		canrec_restore(ptrRec,tNow);
+	}
+
+	if(flg & ((1<<TXBP) | (1<<RXBP))){								// error passive
+		if(ptrRec->state != RECPASSIVE)
+			ptrRec->errPasv++;
+		ptrRec->state = RECPASSIVE;
+	}
+	else
+		ptrRec->state = RECACTIVE;
+	if(ptrRec->tec)													// TX errors - quiet time restarts
+		ptrRec->tQuiet = tNow + ptrRec->quiet;
+	else if(ptrRec->streak && ((long)(tNow - ptrRec->tQuiet) >= 0))	// TEC stayed 0 - end of streak
+		ptrRec->streak = 0;
+	return ptrRec->state;
+}
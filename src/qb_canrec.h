@@ -0,0 +1,67 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#ifndef	QB_CANREC_H
+#define	QB_CANREC_H
+
+#include <inttypes.h>
+#include "qb_mcp251xfd.h"
+#ifdef __cplusplus
+
+extern "C"
+{
+
+#endif
+
+/**************************************************************************************************
+Algorithm variables 
+  Error state tracking & bus off recovery without mcp251xfd_init(). canrec_poll() reads C1TREC once
+  per call. The MCP2517 leaves bus off by itself after the protocol minimum (128 x 11 recessive bits),
+  keeping filters & FIFOs. On repeated bus offs the channel is then held in restricted operation (RX
+  & ACK only, no TX; FIFOs kept) for a back-off doubling per bus off (backoff << (streak-1), capped at
+  backoffMax). TX requests of the FIFOs in txMask are re-issued once TX is allowed again. TEC is 0
+  right after a bus off, so the streak only ends once TEC has stayed 0 for the quiet time after TX
+  was re-enabled (any TX error restarts it). Recovery time is measured from the bus off being seen to TX re-enabled.
+**************************************************************************************************/
+#define RECACTIVE		0				// state - error active
+#define RECPASSIVE		1				// state - error passive (TEC or REC > 127)
+#define RECBUSOFF		2				// state - bus off (TEC > 255), recovering in the MCP2517
+#define RECHOLD			3				// state - recovered, TX held off for the back-off time
+
+typedef struct{
+	chnCAN *ptrChn;													// channel
+	unsigned long txMask;											// TX buffers to re-request (bit 0 = TXQ;bit n = FIFOn)
+	uint16_t backoff;												// 1st back-off (ms; 0 = TX straight after recovery)
+	uint16_t backoffMax;											// max back-off (ms)
+	uint16_t quiet;													// time TEC has to stay 0 to end a streak (ms)
+	uint8_t state;													// RECACTIVE/RECPASSIVE/RECBUSOFF/RECHOLD
+	uint8_t streak;													// #of bus offs since TEC last stayed 0 for the quiet time
+	uint8_t opMod;													// operation mode to return to after a hold
+	uint8_t tec;													// TX error counter at last poll
+	uint8_t rec;													// RX error counter at last poll
+	unsigned long tOff;												// time the bus off was seen (ms)
+	unsigned long tHold;											// time the hold ends (ms)
+	unsigned long tQuiet;											// time the streak ends if TEC stays 0 (ms)
+	unsigned long recLast;											// last recovery time (ms)
+	unsigned long recMax;											// max recovery time (ms)
+	uint16_t errPasv;												// #of transitions into error passive
+	uint16_t busOff;												// #of transitions into bus off
+} recCAN;
+
+void 			canrec_init(recCAN *ptrRec,chnCAN *ptrChn,unsigned long txMask,uint16_t backoff,uint16_t backoffMax,uint16_t quiet);
+uint8_t 		canrec_poll(recCAN *ptrRec,unsigned long tNow);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// QB_CANREC_H
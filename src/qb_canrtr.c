@@ -0,0 +1,92 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+
+#include <stdint.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_mcp251xfd_defs.h"
+#include "qb_canrtr.h"
+
+/**************************************************************************************************
+Purpose: 	Sets up a remote frame auto responder (after mcp251xfd_init() & any other TX FIFO setup;
+				the response is loaded by the 1st canrtr_refresh(), refer to qb_canrtr.h)
+Inputs:		*ptrRtr		- rtrCAN pointer
+			*ptrChn		- chnCAN pointer
+			bufIdx		- FIFO to hold the response (1-31; not the TX/RX FIFO given to mcp251xfd_init())
+			fltrNum 	- index to filter register (0-7)
+			fltrIdx		- filter number of filter register to setup (0-3)
+			*ptrMsg		- msgCAN pointer to the response (prepared by mcp251xfd_frame_prep(); the remote
+							frames answered are the ones with the same ID)
+
+Outputs:	result		- fault code (refer to mcp251xfd_txfifo_setup() & mcp251xfd_fltr_setup())
+**************************************************************************************************/
+uint8_t canrtr_setup(rtrCAN *ptrRtr,chnCAN *ptrChn,uint8_t bufIdx,uint8_t fltrNum,uint8_t fltrIdx,msgCAN *ptrMsg){
+	unsigned long idWord, fltrId;
+	uint8_t result;
+
+	ptrRtr->ptrChn = ptrChn;
+	ptrRtr->bufIdx = (bufIdx > 31) ? 31 : (bufIdx + !bufIdx);
+	ptrRtr->ptrMsg = ptrMsg;
+	ptrRtr->loaded = 0;
+	ptrRtr->answered = 0;
+
+	result = mcp251xfd_txfifo_setup(ptrChn,ptrRtr->bufIdx,0,1);	// 1 msg deep, RTREN=1
+	if(result)
+		return result;
+	idWord = mcp251xfd_hdr_unpack(&ptrMsg->sid07_00);
+	if(idWord & CANID_EXT){											// filter layout - SID<10:0>;EID<17:0>
+		fltrId = ((idWord >> 18) & 0x7FF) | ((idWord & 0x3FFFF) << 11);
+		return mcp251xfd_fltr_setup(ptrChn,ptrRtr->bufIdx,fltrNum,fltrIdx,FLTREXID,fltrId,CANID_MASK);
+	}
+	return mcp251xfd_fltr_setup(ptrChn,ptrRtr->bufIdx,fltrNum,fltrIdx,FLTRSID,idWord,0x7FF);
+}
+/**************************************************************************************************
+Purpose: 	Refreshes the response with the payload of the msgCAN given to canrtr_setup()
+				(loads the FIFO if empty, else overwrites the payload in message RAM)
+Inputs:		*ptrRtr		- rtrCAN pointer
+
+Outputs:	result		- 1 = a response was sent since the last call;0 = not
+**************************************************************************************************/
+uint8_t canrtr_refresh(rtrCAN *ptrRtr){
+	chnCAN *ptrChn = ptrRtr->ptrChn;
+	msgCAN *ptrMsg = ptrRtr->ptrMsg;
+	uint16_t objAddr;												// RAM address of the FIFO msg object
+	uint8_t result, idx;
+
+	mcp251xfd_read_register(C1FIFOSTA(ptrRtr->bufIdx),ptrChn,0);	// read in FIFO status byte 0
+	if((ptrChn->regRd[0] >> TFNRFNIF) & 1){							// FIFO empty - response went out (or not loaded yet)
+		result = ptrRtr->loaded;
+		ptrRtr->answered += result;
+		for(idx=0;idx<CSCNT;idx++);									// delay for toggling CS
+		ptrRtr->loaded = !mcp251xfd_write_frame(ptrRtr->bufIdx,ptrChn,ptrMsg);	// (re)load (no TXREQ)
+		return result;
+	}
+	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
+	mcp251xfd_read_register(C1FIFOUA(ptrRtr->bufIdx),ptrChn,4);		// read in contents of user address register (1 msg deep - the loaded object)
+	objAddr = (((uint16_t)ptrChn->regRd[1] << 8) | ptrChn->regRd[0]) + 0x400;
+	mcp251xfd_write_block(objAddr + 8,ptrChn,ptrMsg->txData,mcp251xfd_mem_payload(ptrMsg->fdf,ptrMsg->dlc));
+	ptrRtr->loaded = 1;												// still loaded (e.g. reloaded after canrtr_reload())
+	return 0;
+}
+/**************************************************************************************************
+Purpose: 	Loads the response again after a configuration mode trip emptied the FIFO, without
+				counting it as answered
+Inputs:		*ptrRtr		- rtrCAN pointer
+
+Outputs:	result		- 0 = response loaded;1 = not (write failed, retried by canrtr_refresh())
+**************************************************************************************************/
+uint8_t canrtr_reload(rtrCAN *ptrRtr){
+	ptrRtr->loaded = 0;
+	canrtr_refresh(ptrRtr);
+	return !ptrRtr->loaded;
+}
@@ -0,0 +1,56 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#ifndef	QB_CANRTR_H
+#define	QB_CANRTR_H
+
+#include <inttypes.h>
+#include "qb_mcp251xfd.h"
+#ifdef __cplusplus
+
+extern "C"
+{
+
+#endif
+
+/**************************************************************************************************
+Algorithm variables 
+  Remote frame auto responder: the response msg is preloaded into a 1 msg deep TX FIFO with RTREN=1
+  & a filter on the msg ID points to that FIFO. A matching remote frame sets TXREQ in the controller,
+  so the response goes out with no SPI or CPU involvement. The FIFO is empty after a response;
+  canrtr_refresh() (call from loop()) reloads it with the latest payload, or overwrites the payload
+  of the still loaded msg in message RAM (1 SPI burst; a response sent during the burst may mix old &
+  new bytes). A remote frame arriving before the reload is not answered.
+  Setup order: every trip thru configuration mode (mcp251xfd_txfifo_setup(), so also each further
+  canrtr_setup(), or mcp251xfd_mode_set() into/out of loopback) empties all FIFOs & may move message
+  RAM. canrtr_setup() therefore only configures the FIFO & filter; the response is loaded by the 1st
+  canrtr_refresh() & the msg object address is read on each refresh. Call canrtr_reload() for every
+  responder after a configuration mode trip made once refreshing started (an emptied FIFO cannot be
+  told from an answered one, so it would be counted as answered).
+**************************************************************************************************/
+typedef struct{
+	chnCAN *ptrChn;													// channel
+	uint8_t bufIdx;													// 1 msg deep TX FIFO with RTREN=1
+	uint8_t loaded;													// 1 = response loaded by canrtr_refresh() (an empty FIFO means answered)
+	msgCAN *ptrMsg;													// caller owned response msg
+	unsigned long answered;											// #of remote frames answered (seen by canrtr_refresh())
+} rtrCAN;
+
+uint8_t 		canrtr_setup(rtrCAN *ptrRtr,chnCAN *ptrChn,uint8_t bufIdx,uint8_t fltrNum,uint8_t fltrIdx,msgCAN *ptrMsg);
+uint8_t 		canrtr_refresh(rtrCAN *ptrRtr);
+uint8_t 		canrtr_reload(rtrCAN *ptrRtr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// QB_CANRTR_H
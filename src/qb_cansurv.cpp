@@ -0,0 +1,178 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+
+#include "qb_cansurv.h"
+
+#define SURV_HASH(id)	((uint16_t)(id) ^ (uint16_t)((id) >> 16))	// word wise fold of the ID word
+#define SURV_US(p)		(((unsigned long)(p) << SURVSHIFT) / 40)	// 2^SURVSHIFT tick units -> us
+
+/**************************************************************************************************
+Purpose: 	Initializes a survCAN object with caller owned table storage
+Inputs:		*ptrSurv	- survCAN pointer
+			*ptrTbl		- survEntry array
+			size		- #of entries in *ptrTbl (rounded down to a power of 2, keep >= 1.5x #of IDs)
+
+Outputs:	None
+**************************************************************************************************/
+void cansurv_init(survCAN *ptrSurv,survEntry *ptrTbl,uint16_t size){
+	uint16_t idx;													// used to find the power of 2
+
+	for(idx=1;(idx<=0x4000) && ((idx << 1) <= size);idx<<=1);		// largest power of 2 <= size
+	ptrSurv->ptrTbl = ptrTbl;
+	ptrSurv->mask = idx - 1;
+	cansurv_clear(ptrSurv);
+}
+/**************************************************************************************************
+Purpose: 	Clears the survey (all IDs & counters)
+Inputs:		*ptrSurv	- survCAN pointer
+
+Outputs:	None
+**************************************************************************************************/
+void cansurv_clear(survCAN *ptrSurv){
+	uint16_t idx;													// used to step thru entries
+
+	for(idx=0;idx<=ptrSurv->mask;idx++){							// loop thru entries
+		ptrSurv->ptrTbl[idx].id = SURVFREE;
+	}
+	ptrSurv->cnt = 0;
+	ptrSurv->frames = 0;
+	ptrSurv->full = 0;
+}
+/**************************************************************************************************
+Purpose: 	Looks up the entry of an ID on a channel
+Inputs:		*ptrSurv	- survCAN pointer
+			chnNum		- channel the ID was seen on (1 or 2, as chnCAN chnNum)
+			idWord		- ID (| CANID_EXT for an extended ID, as returned by mcp251xfd_hdr_unpack())
+
+Outputs:	result		- survEntry pointer; 0 if the ID has not been seen on the channel
+**************************************************************************************************/
+survEntry *cansurv_find(survCAN *ptrSurv,uint8_t chnNum,unsigned long idWord){
+	uint16_t idx, probe;											// used to step thru entries
+
+	if(chnNum > 1)													// channel 2 entries are keyed apart
+		idWord |= SURVCHN2;
+	idx = SURV_HASH(idWord) & ptrSurv->mask;
+	for(probe=0;probe<=ptrSurv->mask;probe++){						// linear probing
+		if(ptrSurv->ptrTbl[idx].id == idWord)
+			return &ptrSurv->ptrTbl[idx];
+		if(ptrSurv->ptrTbl[idx].id == SURVFREE)						// end of probe chain
+			break;
+		idx = (idx + 1) & ptrSurv->mask;
+	}
+	return 0;
+}
+/**************************************************************************************************
+Purpose: 	Accounts a msg read by mcp251xfd_read_frame() into the survey
+Inputs:		*ptrSurv	- survCAN pointer
+			chnNum		- channel the msg was read from (1 or 2, as chnCAN chnNum)
+			*ptrMsg		- msgCAN pointer
+
+Outputs:	result		- 1 = accounted; 0 = new ID & table full (counted in full)
+**************************************************************************************************/
+uint8_t cansurv_rx(survCAN *ptrSurv,uint8_t chnNum,msgCAN *ptrMsg){
+	survEntry *ptrEnt;												// entry of the msg ID
+	unsigned long idWord, temp;
+	uint16_t idx, probe;											// used to step thru entries
+	uint16_t per;													// period since the last frame
+	uint8_t len;
+
+	ptrSurv->frames++;
+	idWord = mcp251xfd_hdr_unpack(&ptrMsg->sid07_00);
+	if(chnNum > 1)													// channel 2 entries are keyed apart
+		idWord |= SURVCHN2;
+	idx = SURV_HASH(idWord) & ptrSurv->mask;
+	for(probe=0;probe<=ptrSurv->mask;probe++){						// linear probing
+		ptrEnt = &ptrSurv->ptrTbl[idx];
+		if(ptrEnt->id == idWord)									// ID seen before
+			break;
+		if(ptrEnt->id == SURVFREE){									// new ID
+			ptrEnt->id = idWord;
+			ptrEnt->cnt = 0;
+			ptrEnt->dlcMap = 0;
+			ptrEnt->pMin = 0xFFFF;
+			ptrEnt->pMax = 0;
+			ptrEnt->pSum = 0;
+			ptrEnt->jSum = 0;
+			ptrSurv->cnt++;
+			break;
+		}
+		idx = (idx + 1) & ptrSurv->mask;
+	}
+	if(probe > ptrSurv->mask){										// table full
+		ptrSurv->full++;
+		return 0;
+	}
+
+	if(ptrEnt->cnt && (ptrEnt->cnt < 0xFFFF)){						// period stats
+		temp = (ptrMsg->tStamp - ptrEnt->tLast) >> SURVSHIFT;
+		per = (temp > 0xFFFF) ? 0xFFFF : temp;
+		if(per < ptrEnt->pMin)	ptrEnt->pMin = per;
+		if(per > ptrEnt->pMax)	ptrEnt->pMax = per;
+		ptrEnt->pSum += per;
+		if(ptrEnt->cnt > 1)											// previous period exists
+			ptrEnt->jSum += (per > ptrEnt->pPrev) ? (per - ptrEnt->pPrev) : (ptrEnt->pPrev - per);
+		ptrEnt->pPrev = per;
+	}
+	if(ptrEnt->cnt < 0xFFFF)
+		ptrEnt->cnt++;
+	ptrEnt->tLast = ptrMsg->tStamp;
+	ptrEnt->dlcMap |= (1U << ptrMsg->dlc);
+	len = (ptrMsg->pLen > SURVLEN) ? SURVLEN : ptrMsg->pLen;
+	ptrEnt->len = len;
+	for(idx=0;idx<len;idx++){										// loop thru payload
+		ptrEnt->data[idx] = ptrMsg->rxData[idx];
+	}
+	return 1;
+}
+/**************************************************************************************************
+Purpose: 	Writes the survey to the Arduino serial port as .csv (one line per channel & ID, times in us)
+Inputs:		*ptrSurv	- survCAN pointer
+
+Outputs:	serial writes
+**************************************************************************************************/
+void cansurv_report(survCAN *ptrSurv){
+	survEntry *ptrEnt;
+	uint16_t idx;													// used to step thru entries
+	uint8_t j;														// used to step thru payload
+
+	Serial.print("IDs,"); Serial.print(ptrSurv->cnt);
+	Serial.print(",Frames,"); Serial.print(ptrSurv->frames);
+	Serial.print(",Dropped,"); Serial.println(ptrSurv->full);
+	Serial.println("Chn,ID,IDE,Count,Min(us),Mean(us),Max(us),Jitter(us),DLC map,Data");
+	for(idx=0;idx<=ptrSurv->mask;idx++){							// loop thru entries
+		ptrEnt = &ptrSurv->ptrTbl[idx];
+		if(ptrEnt->id == SURVFREE)
+			continue;
+		Serial.print((ptrEnt->id & SURVCHN2) ? 2 : 1);	Serial.print(",");
+		Serial.print(ptrEnt->id & CANID_MASK,HEX);		Serial.print(",");
+		Serial.print((ptrEnt->id & CANID_EXT) ? 1 : 0);	Serial.print(",");
+		Serial.print(ptrEnt->cnt);						Serial.print(",");
+		if(ptrEnt->cnt > 1){										// at least 1 period
+			Serial.print(SURV_US(ptrEnt->pMin));						Serial.print(",");
+			Serial.print(SURV_US(ptrEnt->pSum / (ptrEnt->cnt - 1)));	Serial.print(",");
+			Serial.print(SURV_US(ptrEnt->pMax));						Serial.print(",");
+		}
+		else
+			Serial.print(",,,");
+		if(ptrEnt->cnt > 2)											// at least 2 periods
+			Serial.print(SURV_US(ptrEnt->jSum / (ptrEnt->cnt - 2)));
+		Serial.print(",");
+		Serial.print(ptrEnt->dlcMap,HEX);				Serial.print(",");
+		for(j=0;j<ptrEnt->len;j++){									// loop thru payload
+			if(ptrEnt->data[j] < 0x10){Serial.print("0");}
+			Serial.print(ptrEnt->data[j],HEX);
+			if(j != ptrEnt->len - 1){Serial.print(" ");}
+		}
+		Serial.println();
+	}
+}
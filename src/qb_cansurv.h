@@ -0,0 +1,66 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+
+#ifndef QB_CANSURV_H
+#define QB_CANSURV_H
+
+#if ARDUINO>=100
+#include <Arduino.h> // Arduino 1.0
+#else
+#include <Wprogram.h> // Arduino 0022
+#endif
+#include "qb_mcp251xfd.h"
+
+/**************************************************************************************************
+Algorithm variables 
+  Bus survey: per ID frame count, inter-arrival period (min/mean/max) from the RX timestamps, jitter
+  (mean |period - previous period|), DLCs seen & last payload, kept in an open addressing hash table
+  keyed by channel & ID word (1 table serves both channels, the same ID on each is 2 entries). Each survEntry is 35 bytes of SRAM (SURVLEN=8), so size the table for the board
+  (e.g. 32 IDs on a 32U4, a few hundred on a board with 8K+ SRAM). RX FIFO must have RXTSEN=1.
+**************************************************************************************************/
+#ifndef SURVLEN
+#define SURVLEN			8				// #of payload bytes kept per ID (longer payloads are truncated)
+#endif
+#define SURVSHIFT		10				// period unit = 2^SURVSHIFT timestamp ticks (25.6 us;max 1.67 s)
+#define SURVFREE		0xFFFFFFFFUL	// ID word of an unused entry
+#define SURVCHN2		0x40000000UL	// ID word flag - frame seen on channel 2 (entry key only)
+
+typedef struct{
+	unsigned long id;												// ID word (CANID_EXT for extended IDs;SURVCHN2 for channel 2); SURVFREE = unused
+	uint16_t cnt;													// #of frames (saturates at 65535, period stats stop)
+	uint16_t dlcMap;												// bit n set = DLC n seen
+	unsigned long tLast;											// timestamp of the last frame (1/40MHz periods)
+	uint16_t pMin;													// min period (2^SURVSHIFT ticks)
+	uint16_t pMax;													// max period (2^SURVSHIFT ticks)
+	uint16_t pPrev;													// last period (2^SURVSHIFT ticks)
+	unsigned long pSum;												// sum of periods (mean = pSum/(cnt-1))
+	unsigned long jSum;												// sum of |period - previous period| (jitter = jSum/(cnt-2))
+	uint8_t len;													// #of payload bytes in data
+	uint8_t data[SURVLEN];											// last payload
+} survEntry;
+
+typedef struct{
+	survEntry *ptrTbl;												// caller owned table storage
+	uint16_t mask;													// #of entries used - 1 (power of 2)
+	uint16_t cnt;													// #of IDs seen
+	unsigned long frames;											// #of frames surveyed
+	unsigned long full;												// #of frames dropped, table full
+} survCAN;
+
+void 			cansurv_init(survCAN *ptrSurv,survEntry *ptrTbl,uint16_t size);
+void 			cansurv_clear(survCAN *ptrSurv);
+survEntry *		cansurv_find(survCAN *ptrSurv,uint8_t chnNum,unsigned long idWord);
+uint8_t 		cansurv_rx(survCAN *ptrSurv,uint8_t chnNum,msgCAN *ptrMsg);
+void 			cansurv_report(survCAN *ptrSurv);
+
+#endif
@@ -0,0 +1,198 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+
+#include <stdint.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_cansync.h"
+
+/**************************************************************************************************
+Purpose: 	Initializes a syncCAN object (no offset, no drift until the 1st samples)
+Inputs:		*ptrSync	- syncCAN pointer
+
+Outputs:	None
+**************************************************************************************************/
+void cansync_init(syncCAN *ptrSync){
+	ptrSync->ref1 = 0;
+	ptrSync->ref2 = 0;
+	ptrSync->drift = 0;
+	ptrSync->samples = 0;
+}
+/**************************************************************************************************
+Purpose: 	Adds a sample pair of simultaneous channel 1 & channel 2 times
+Inputs:		*ptrSync	- syncCAN pointer
+			t1			- channel 1 TBC / RX timestamp
+			t2			- channel 2 TBC / RX timestamp of the same instant
+
+Outputs:	None
+**************************************************************************************************/
+void cansync_sample(syncCAN *ptrSync,unsigned long t1,unsigned long t2){
+	unsigned long d2;												// chn2 ticks since the last sample
+	long err;														// chn1 - chn2 ticks since the last sample
+	long drift;														// drift of this sample interval (Q24)
+
+	d2 = t2 - ptrSync->ref2;
+	if(ptrSync->samples && (d2 >= SYNCMINTICKS) && (d2 < 0x40000000UL)){	// interval long enough for a drift update
+		err = (long)((t1 - ptrSync->ref1) - d2);
+		if((err > -0x100000L) && (err < 0x100000L))					// keeps err << 10 within 32 bits
+			drift = (err << 10) / (long)(d2 >> 14);					// err/d2 in Q24
+		else
+			drift = SYNCMAXDRIFT + 1;
+		if((drift >= -SYNCMAXDRIFT) && (drift <= SYNCMAXDRIFT)){	// ignore outliers (missed sample, TBC reset)
+			if(ptrSync->samples == 1)
+				ptrSync->drift = drift;
+			else
+				ptrSync->drift += (drift - ptrSync->drift) / 4;		// IIR filter
+		}
+	}
+	ptrSync->ref1 = t1;
+	ptrSync->ref2 = t2;
+	if(ptrSync->samples < 255)
+		ptrSync->samples++;
+}
+/**************************************************************************************************
+Purpose: 	Samples both time base counters (TBC2 read between 2 TBC1 reads, TBC1 taken at the midpoint)
+Inputs:		*ptrSync	- syncCAN pointer
+			*ptrChn1	- chnCAN pointer of channel 1 (reference time base)
+			*ptrChn2	- chnCAN pointer of channel 2
+
+Outputs:	None
+**************************************************************************************************/
+void cansync_poll(syncCAN *ptrSync,chnCAN *ptrChn1,chnCAN *ptrChn2){
+	unsigned long t1a, t1b, t2;										// TBC reads
+	uint8_t idx;													// used for CS delay
+
+	t1a = mcp251xfd_tbc_read(ptrChn1);
+	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
+	t2 = mcp251xfd_tbc_read(ptrChn2);
+	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
+	t1b = mcp251xfd_tbc_read(ptrChn1);
+	cansync_sample(ptrSync,t1a + ((t1b - t1a) >> 1),t2);
+}
+/**************************************************************************************************
+Purpose: 	Converts a channel 2 time to the channel 1 time base
+Inputs:		*ptrSync	- syncCAN pointer
+			t2			- channel 2 TBC / RX timestamp (within 10 s of the last sample)
+
+Outputs:	result		- channel 1 time
+**************************************************************************************************/
+unsigned long cansync_to1(syncCAN *ptrSync,unsigned long t2){
+	long dt;														// chn2 ticks since the last sample
+
+	dt = (long)(t2 - ptrSync->ref2);
+	return ptrSync->ref1 + dt + (((dt >> 12) * ptrSync->drift) >> 12);	// (dt * drift) >> 24 without 64 bit math
+}
+/**************************************************************************************************
+Purpose: 	Initializes a mergeCAN object with caller owned msgCAN slots for each channel
+Inputs:		*ptrMerge	- mergeCAN pointer
+			*ptrSlot1	- msgCAN array for channel 1
+			*ptrSlot2	- msgCAN array for channel 2
+			size		- #of msgCAN in each array
+			latUs		- reorder latency in us (max time a frame waits for the other channel)
+
+Outputs:	None
+**************************************************************************************************/
+void canmerge_init(mergeCAN *ptrMerge,msgCAN *ptrSlot1,msgCAN *ptrSlot2,uint8_t size,uint16_t latUs){
+	cansync_init(&ptrMerge->sync);
+	ptrMerge->q[0].ptrSlot = ptrSlot1;
+	ptrMerge->q[1].ptrSlot = ptrSlot2;
+	ptrMerge->q[0].head = ptrMerge->q[1].head = 0;
+	ptrMerge->q[0].cnt = ptrMerge->q[1].cnt = 0;
+	ptrMerge->size = size;
+	ptrMerge->maxLat = (MCP251XFD_TBCLK / 1000000UL) * latUs;
+	ptrMerge->tNow = 0;
+	ptrMerge->merged = 0;
+	ptrMerge->late = 0;
+	ptrMerge->tLast = 0;
+}
+/**************************************************************************************************
+Purpose: 	Returns the next free slot of a channel queue to read a frame into
+Inputs:		*ptrMerge	- mergeCAN pointer
+			qIdx		- 0 = channel 1;1 = channel 2
+
+Outputs:	result		- msgCAN pointer for mcp251xfd_read_frame(); 0 if the queue is full (pop 1st)
+**************************************************************************************************/
+msgCAN *canmerge_slot(mergeCAN *ptrMerge,uint8_t qIdx){
+	mergeQ *ptrQ = &ptrMerge->q[qIdx];
+
+	if(ptrQ->cnt >= ptrMerge->size)
+		return 0;
+	return &ptrQ->ptrSlot[(ptrQ->head + ptrQ->cnt) % ptrMerge->size];
+}
+/**************************************************************************************************
+Purpose: 	Queues the frame read into canmerge_slot() (channel 2 tStamp converted to channel 1 time base)
+Inputs:		*ptrMerge	- mergeCAN pointer
+			qIdx		- 0 = channel 1;1 = channel 2
+
+Outputs:	None
+**************************************************************************************************/
+void canmerge_push(mergeCAN *ptrMerge,uint8_t qIdx){
+	mergeQ *ptrQ = &ptrMerge->q[qIdx];
+	msgCAN *ptrMsg;
+
+	if(ptrQ->cnt >= ptrMerge->size)
+		return;
+	ptrMsg = &ptrQ->ptrSlot[(ptrQ->head + ptrQ->cnt) % ptrMerge->size];
+	if(qIdx)
+		ptrMsg->tStamp = cansync_to1(&ptrMerge->sync,ptrMsg->tStamp);
+	ptrQ->cnt++;
+	if((long)(ptrMsg->tStamp - ptrMerge->tNow) > 0)					// newest frame seen
+		ptrMerge->tNow = ptrMsg->tStamp;
+}
+/**************************************************************************************************
+Purpose: 	Advances the merge clock so a lone queued frame is released on a quiet bus
+Inputs:		*ptrMerge	- mergeCAN pointer
+			t1			- current channel 1 time (e.g. mcp251xfd_tbc_read() of channel 1)
+
+Outputs:	None
+**************************************************************************************************/
+void canmerge_time(mergeCAN *ptrMerge,unsigned long t1){
+	if((long)(t1 - ptrMerge->tNow) > 0)
+		ptrMerge->tNow = t1;
+}
+/**************************************************************************************************
+Purpose: 	Pops the oldest queued frame once it can no longer be preceded by a frame of the other channel
+Inputs:		*ptrMerge	- mergeCAN pointer
+			*ptrQIdx	- pointer to store the queue (0 = channel 1;1 = channel 2) of the frame
+			force		- 1 = pop the oldest frame regardless of the reorder latency (flush)
+
+Outputs:	result		- msgCAN pointer (valid until the next canmerge_slot() of that channel); 0 if none
+**************************************************************************************************/
+msgCAN *canmerge_pop(mergeCAN *ptrMerge,uint8_t *ptrQIdx,uint8_t force){
+	mergeQ *ptrQ;
+	msgCAN *ptrMsg[2];												// head frame of each queue
+	uint8_t qIdx;
+
+	ptrMsg[0] = (ptrMerge->q[0].cnt) ? &ptrMerge->q[0].ptrSlot[ptrMerge->q[0].head] : 0;
+	ptrMsg[1] = (ptrMerge->q[1].cnt) ? &ptrMerge->q[1].ptrSlot[ptrMerge->q[1].head] : 0;
+	if(!ptrMsg[0] && !ptrMsg[1])
+		return 0;
+	if(ptrMsg[0] && ptrMsg[1])										// both queued, oldest can go
+		qIdx = ((long)(ptrMsg[1]->tStamp - ptrMsg[0]->tStamp) < 0);
+	else{															// 1 queue empty, wait out the reorder latency
+		qIdx = (ptrMsg[0] == 0);
+		if(!force && ((ptrMerge->tNow - ptrMsg[qIdx]->tStamp) < ptrMerge->maxLat))
+			return 0;
+	}
+	ptrQ = &ptrMerge->q[qIdx];
+	if(++ptrQ->head >= ptrMerge->size)
+		ptrQ->head = 0;
+	ptrQ->cnt--;
+	if(ptrMerge->merged && ((long)(ptrMsg[qIdx]->tStamp - ptrMerge->tLast) < 0))	// out of order
+		ptrMerge->late++;
+	else
+		ptrMerge->tLast = ptrMsg[qIdx]->tStamp;
+	ptrMerge->merged++;
+	*ptrQIdx = qIdx;
+	return ptrMsg[qIdx];
+}
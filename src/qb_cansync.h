@@ -0,0 +1,79 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#ifndef	QB_CANSYNC_H
+#define	QB_CANSYNC_H
+
+#include <inttypes.h>
+#include "qb_mcp251xfd.h"
+#ifdef __cplusplus
+
+extern "C"
+{
+
+#endif
+
+/**************************************************************************************************
+Algorithm variables 
+  Time base sync: maps channel 2 timestamps onto the channel 1 time base. Each sample is a pair of
+  simultaneous TBC values (cansync_poll() reads TBC2 between two TBC1 reads, or cansync_sample() with
+  the RX timestamps of 1 frame seen by both channels). Offset is taken from the last sample & drift
+  (Q24 chn1 ticks per chn2 tick - 1) from the last 2 samples, IIR filtered. Sample every ~1 s.
+
+  Merge: frames read on both channels are queued per channel (caller owned msgCAN slots, read in
+  place with mcp251xfd_read_frame()) with tStamp converted to the channel 1 time base, then popped
+  in timestamp order. A frame is released once the other channel has a newer frame queued or it is
+  older than the newest time seen (queued frames or canmerge_time()) minus the reorder latency,
+  bounding the reorder delay.
+**************************************************************************************************/
+#define SYNCMINTICKS	0x100000UL		// min chn2 ticks between samples for a drift update (~26 ms)
+#define SYNCMAXDRIFT	16777L			// max |drift| accepted (Q24, 1000 ppm)
+
+typedef struct{
+	unsigned long ref1;												// last sample - channel 1 TBC
+	unsigned long ref2;												// last sample - channel 2 TBC
+	long drift;														// Q24 (chn1 ticks per chn2 tick - 1)
+	uint8_t samples;												// #of samples taken (saturates at 255)
+} syncCAN;
+
+typedef struct{
+	msgCAN *ptrSlot;												// caller owned msgCAN slots
+	uint8_t head;													// index of the oldest queued frame
+	uint8_t cnt;													// #of queued frames
+} mergeQ;
+
+typedef struct{
+	syncCAN sync;													// channel 2 -> channel 1 time base
+	mergeQ q[2];													// per channel reorder queues
+	uint8_t size;													// #of slots per queue
+	unsigned long maxLat;											// reorder latency (1/40MHz periods)
+	unsigned long tNow;												// newest timestamp queued (channel 1 time base)
+	unsigned long merged;											// #of frames popped
+	unsigned long late;												// #of frames popped older than a frame already popped
+	unsigned long tLast;											// timestamp of the last frame popped
+} mergeCAN;
+
+void 			cansync_init(syncCAN *ptrSync);
+void 			cansync_sample(syncCAN *ptrSync,unsigned long t1,unsigned long t2);
+void 			cansync_poll(syncCAN *ptrSync,chnCAN *ptrChn1,chnCAN *ptrChn2);
+unsigned long 	cansync_to1(syncCAN *ptrSync,unsigned long t2);
+void 			canmerge_init(mergeCAN *ptrMerge,msgCAN *ptrSlot1,msgCAN *ptrSlot2,uint8_t size,uint16_t latUs);
+msgCAN *		canmerge_slot(mergeCAN *ptrMerge,uint8_t qIdx);
+void 			canmerge_push(mergeCAN *ptrMerge,uint8_t qIdx);
+void 			canmerge_time(mergeCAN *ptrMerge,unsigned long t1);
+msgCAN *		canmerge_pop(mergeCAN *ptrMerge,uint8_t *ptrQIdx,uint8_t force);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// QB_CANSYNC_H
@@ -0,0 +1,136 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+
+#include <stdint.h>
+
+#include "qb_mcp251xfd.h"
+#include "qb_mcp251xfd_defs.h"
+#include "qb_canupd.h"
+
+/**************************************************************************************************
+Purpose: 	Initializes an updCAN object
+Inputs:		*ptrUpd		- updCAN pointer
+			*ptrChn		- chnCAN pointer
+			bufIdx		- 1 msg deep TX FIFO (1-31, setup by mcp251xfd_txfifo_setup())
+			mode		- UPDABORT (no torn frames) or UPDRAM (opt-in, refer to qb_canupd.h)
+
+Outputs:	None
+**************************************************************************************************/
+void canupd_init(updCAN *ptrUpd,chnCAN *ptrChn,uint8_t bufIdx,uint8_t mode){
+	ptrUpd->ptrChn = ptrChn;
+	ptrUpd->bufIdx = (bufIdx > 31) ? 31 : (bufIdx + !bufIdx);
+	ptrUpd->mode = mode;
+	ptrUpd->loaded = 0;
+	ptrUpd->overwritten = 0;
+	ptrUpd->replaced = 0;
+	ptrUpd->raced = 0;
+}
+/**************************************************************************************************
+Purpose: 	Loads a msg into an empty FIFO & requests transmission
+Inputs:		*ptrUpd		- updCAN pointer
+			*ptrMsg		- msgCAN pointer
+
+Outputs:	result		- error code (refer to mcp251xfd_write_frame())
+**************************************************************************************************/
+static uint8_t canupd_load(updCAN *ptrUpd,msgCAN *ptrMsg){
+	uint8_t result;
+
+	result = mcp251xfd_write_frame(ptrUpd->bufIdx,ptrUpd->ptrChn,ptrMsg);
+	if(!result)
+		mcp251xfd_start_transmit(ptrUpd->bufIdx,ptrUpd->ptrChn);
+	return result;
+}
+/**************************************************************************************************
+Purpose: 	Reads a FIFO control register byte until the masked bits clear
+Inputs:		*ptrUpd		- updCAN pointer
+			bits		- C1FIFOCON byte 1 bits to wait on
+
+Outputs:	result		- 0 = bits cleared;1 = timed out
+**************************************************************************************************/
+static uint8_t canupd_wait(updCAN *ptrUpd,uint8_t bits){
+	uint8_t idx, cnt;
+
+	for(cnt=0;cnt<UPDPOLL;cnt++){
+		for(idx=0;idx<CSCNT;idx++);									// delay for toggling CS
+		mcp251xfd_read_register(C1FIFOCON(ptrUpd->bufIdx),ptrUpd->ptrChn,1);	// read register data byte 1
+		if(!(ptrUpd->ptrChn->regRd[1] & bits))
+			return 0;
+	}
+	return 1;
+}
+/**************************************************************************************************
+Purpose: 	Transmits the latest value of a msg, replacing the pending msg of the FIFO if not yet sent
+Inputs:		*ptrUpd		- updCAN pointer
+			*ptrMsg		- msgCAN pointer (prepared by mcp251xfd_frame_prep(); same ID & DLC each call
+							in UPDRAM mode)
+
+Outputs:	result		- UPDNEW/UPDOVER/UPDREPLACED/UPDSENT or an error code (defined in qb_mcp251xfd.h)
+							ERR_NTXFIFO	= FIFO not configured as TX FIFO
+							ERR_TXABORT	= abort or FIFO reset did not complete
+**************************************************************************************************/
+uint8_t canupd_write(updCAN *ptrUpd,msgCAN *ptrMsg){
+	chnCAN *ptrChn = ptrUpd->ptrChn;
+	uint16_t objAddr;												// RAM address of the FIFO msg object
+	uint8_t idx, result;
+
+	mcp251xfd_read_register(C1FIFOSTA(ptrUpd->bufIdx),ptrChn,0);	// read in FIFO status byte 0
+	if((ptrChn->regRd[0] >> TFNRFNIF) & 1){							// FIFO not full (1 deep = empty)
+		result = canupd_load(ptrUpd,ptrMsg);
+		if(result)
+			return (result == ERR_FIFOFULL) ? ERR_TXABORT : result;
+		ptrUpd->loaded++;
+		return UPDNEW;
+	}
+
+	if(ptrUpd->mode == UPDRAM){										// overwrite the pending object in place
+		for(idx=0;idx<CSCNT;idx++);									// delay for toggling CS
+		mcp251xfd_read_register(C1FIFOUA(ptrUpd->bufIdx),ptrChn,4);	// read in contents of user address register (read each time, a config mode trip may move RAM)
+		objAddr = (((uint16_t)ptrChn->regRd[1] << 8) | ptrChn->regRd[0]) + 0x400;
+		mcp251xfd_write_block(objAddr,ptrChn,&ptrMsg->sid07_00,8 + mcp251xfd_mem_payload(ptrMsg->fdf,ptrMsg->dlc));
+		for(idx=0;idx<CSCNT;idx++);									// delay for toggling CS
+		mcp251xfd_read_register(C1FIFOSTA(ptrUpd->bufIdx),ptrChn,0);	// read in FIFO status byte 0
+		if(!((ptrChn->regRd[0] >> TFNRFNIF) & 1)){					// still pending - new value goes out
+			ptrUpd->overwritten++;
+			return UPDOVER;
+		}
+		ptrUpd->raced++;											// sent while being written
+		if(canupd_load(ptrUpd,ptrMsg))
+			return ERR_TXABORT;
+		return UPDSENT;
+	}
+
+	// Abort the pending msg --------------------------------------------------------------------------------------------------------------
+	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
+	ptrChn->regWr[1] = 0x00;										// FRESET=TXREQ=UINC=0 (abort request)
+	mcp251xfd_write_register(C1FIFOCON(ptrUpd->bufIdx),ptrChn,1);	// write register data byte 1
+	if(canupd_wait(ptrUpd,(1<<TXREQ)))								// frame on the bus completes 1st
+		return ERR_TXABORT;
+	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
+	mcp251xfd_read_register(C1FIFOSTA(ptrUpd->bufIdx),ptrChn,0);	// read in FIFO status byte 0
+	if((ptrChn->regRd[0] >> TFNRFNIF) & 1){							// went out before the abort
+		ptrUpd->raced++;
+		result = UPDSENT;
+	}
+	else{															// aborted - empty the FIFO
+		for(idx=0;idx<CSCNT;idx++);									// delay for toggling CS
+		ptrChn->regWr[1] = (1<<FRESET);								// FRESET=1;TXREQ=UINC=0
+		mcp251xfd_write_register(C1FIFOCON(ptrUpd->bufIdx),ptrChn,1);	// write register data byte 1
+		if(canupd_wait(ptrUpd,(1<<FRESET)))
+			return ERR_TXABORT;
+		ptrUpd->replaced++;
+		result = UPDREPLACED;
+	}
+	if(canupd_load(ptrUpd,ptrMsg))
+		return ERR_TXABORT;
+	return result;
+}
@@ -0,0 +1,63 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#ifndef	QB_CANUPD_H
+#define	QB_CANUPD_H
+
+#include <inttypes.h>
+#include "qb_mcp251xfd.h"
+#ifdef __cplusplus
+
+extern "C"
+{
+
+#endif
+
+/**************************************************************************************************
+Algorithm variables 
+  Latest value transmit: each hot msg owns a 1 msg deep TX FIFO (mcp251xfd_txfifo_setup()), so a new
+  value never queues behind a stale one. canupd_write() loads the msg if the FIFO is empty, else:
+    UPDABORT	- (default) aborts the pending msg (TXREQ=0), resets the FIFO & loads the msg (no torn
+				  frames; costs more SPI transfers & waits for a frame already on the bus to complete)
+    UPDRAM		- (opt-in) overwrites the pending msg object in message RAM without an abort. If the
+				  controller starts sending the object while it is written, a torn frame mixing old &
+				  new bytes goes on the bus (the msg is then loaded again & counted in raced). Only use
+				  it for msgs whose receivers tolerate 1 torn frame (e.g. carry their own checksum)
+**************************************************************************************************/
+#define UPDABORT		0				// mode - abort the pending msg & replace it (default)
+#define UPDRAM			1				// mode - overwrite the pending msg in message RAM (torn frames possible)
+
+#define UPDNEW			0				// canupd_write() result - FIFO was empty, msg loaded
+#define UPDOVER			1				// canupd_write() result - pending msg overwritten in RAM
+#define UPDREPLACED		2				// canupd_write() result - pending msg aborted & replaced
+#define UPDSENT			3				// canupd_write() result - pending msg went out meanwhile, msg loaded
+
+#define UPDPOLL			255				// max status reads waiting for an abort/reset
+
+typedef struct{
+	chnCAN *ptrChn;													// channel
+	uint8_t bufIdx;													// 1 msg deep TX FIFO
+	uint8_t mode;													// UPDABORT/UPDRAM
+	unsigned long loaded;											// #of msgs loaded into an empty FIFO
+	unsigned long overwritten;										// #of pending msgs overwritten in RAM
+	unsigned long replaced;											// #of pending msgs aborted & replaced
+	unsigned long raced;											// #of msgs sent while being overwritten/aborted
+} updCAN;
+
+void 			canupd_init(updCAN *ptrUpd,chnCAN *ptrChn,uint8_t bufIdx,uint8_t mode);
+uint8_t 		canupd_write(updCAN *ptrUpd,msgCAN *ptrMsg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// QB_CANUPD_H
@@ -11,6 +11,7 @@
   All text above must be included in any redistribution
  ****************************************************/
 
+#ifndef MCP251XFD_HOST
 #include <avr/io.h>
 #include <util/delay.h>
 
@@ -19,13 +20,45 @@
 #else
 #include <Wprogram.h> // Arduino 0022
 #endif
-#include <stdint.h>
 #include <avr/pgmspace.h>
+#endif
+#include <stdint.h>
 
 #include "qb_mcp251xfd_global.h"
 #include "qb_mcp251xfd.h"
 #include "qb_mcp251xfd_defs.h"
 #include "qb_mcp251xfd_defaults.h"
+#include "qb_mcp251xfd_prof.h"
+#include "qb_mcp251xfd_host.h"
+
+#ifdef MCP251XFD_HOST
+#define PROF_TCNT		mcp251xfd_host_cycles()			// host cycle counter
+#define PROGMEM											// host tables live in RAM
+#define pgm_read_byte(p)	(*(const uint8_t *)(p))
+#else
+#define PROF_TCNT		TCNT1							// Timer1 counter
+#endif
+
+// DLC/payload length codec tables (flash)
+static const uint8_t dlcLen[16] PROGMEM = {					// DLC -> #of payload bytes
+	0,1,2,3,4,5,6,7,8,12,16,20,24,32,48,64
+};
+static const uint8_t dlcMem[16] PROGMEM = {					// DLC -> #of msg object payload bytes (multiple of 4)
+	0,4,4,4,4,8,8,8,8,12,16,20,24,32,48,64
+};
+#if MCP251XFD_CLASSIC_ONLY
+static const uint8_t lenDlc[9] PROGMEM = {					// #of payload bytes -> DLC (CAN 2.0 only)
+	0,1,2,3,4,5,6,7,8											// 0-8
+};
+#else
+static const uint8_t lenDlc[65] PROGMEM = {					// #of payload bytes -> DLC (rounded up)
+	0,1,2,3,4,5,6,7,8,											// 0-8
+	9,9,9,9,10,10,10,10,11,11,11,11,12,12,12,12,				// 9-24
+	13,13,13,13,13,13,13,13,									// 25-32
+	14,14,14,14,14,14,14,14,14,14,14,14,14,14,14,14,			// 33-48
+	15,15,15,15,15,15,15,15,15,15,15,15,15,15,15,15				// 49-64
+};
+#endif
 
 /**************************************************************************************************
 Purpose: 	Writes 1 byte to the SPI line
@@ -33,9 +66,14 @@ Inputs:		data 	- 8 bit unsigned data
 Outputs:	SPDR	- SPI data register contents
 **************************************************************************************************/
 uint8_t spi_putChr( uint8_t data ){
+	PROF_SPI(1);													// instrumentation - 1 SPI byte
+#ifdef MCP251XFD_HOST
+	return mcp251xfd_host_xfer(data);								// clock byte thru host transport
+#else
 	SPDR = data;													// put byte in send-buffer
 	while( !( SPSR & (1<<SPIF) ));									// wait until byte is sent
 	return SPDR;													// return byte recieved in SPI Tx/Rx register
+#endif
 }
 /**************************************************************************************************
 Purpose: 	Writes 2 bytes to the SPI line
@@ -46,6 +84,11 @@ Outputs:	SPDR	- SPI data register contents
 uint8_t spi_putCmd(uint8_t cmd, uint16_t addr ){
 	uint8_t dummy;
 	
+	PROF_SPI(2);													// instrumentation - 2 SPI bytes
+#ifdef MCP251XFD_HOST
+	dummy = mcp251xfd_host_xfer((cmd<<4)|(addr>>8));				// clock cmd byte thru host transport
+	return mcp251xfd_host_xfer(addr & 0xFF);						// clock addr byte thru host transport
+#else
 	SPDR = (cmd<<4)|(addr>>8);										// put byte in send-buffer (MCP2517FD manual Table 4-1)
 	while( !( SPSR & (1<<SPIF) ) );									// wait until byte is sent
 	dummy = SPDR;													// read SPI RD/WR register to reset SPIF
@@ -54,6 +97,7 @@ uint8_t spi_putCmd(uint8_t cmd, uint16_t addr ){
 	while( !( SPSR & (1<<SPIF) ) );									// wait until byte is sent	
 	
 	return SPDR;													// return byte recieved in SPI Tx/Rx register
+#endif
 }
 /**************************************************************************************************
 Purpose: 	Drive CS pin low for coresponding channel num
@@ -63,10 +107,15 @@ Inputs:		chnNum	- channel #
 Outputs:	None
 **************************************************************************************************/
 void mcp251xfd_cs_clr(uint8_t chnNum){
+	PROF_CSCLR();											// instrumentation - CS assertion
+#ifdef MCP251XFD_HOST
+	mcp251xfd_host_cs(1 + (chnNum > 1),0);						// drive chip select low thru host transport
+#else
 	if(chnNum <= 1)											// check if using channel 1
 		RESET(MCP2517XFD_CS1);									// drive channel 1 chip select low
 	else 													// default to using channel 2
 		RESET(MCP2517XFD_CS2);
+#endif
 }
 /**************************************************************************************************
 Purpose: 	Drive CS pin high for coresponding channel num
@@ -76,10 +125,14 @@ Inputs:		chnNum	- channel #
 Outputs:	None
 **************************************************************************************************/
 void mcp251xfd_cs_set(uint8_t chnNum){
+#ifdef MCP251XFD_HOST
+	mcp251xfd_host_cs(1 + (chnNum > 1),1);						// drive chip select high thru host transport
+#else
 	if(chnNum <= 1)											// check if using channel 1
 		SET(MCP2517XFD_CS1);								// drive channel 1 chip select low
 	else 													// default to using channel 2
 		SET(MCP2517XFD_CS2);
+#endif
 }
 /**************************************************************************************************
 Purpose: 	Reads 1-4 bytes from the SPI line (Writes 4bit Cmd, 12bit Addr, then reads 8-32bit of register data)
@@ -102,6 +155,7 @@ void mcp251xfd_read_register(uint16_t addr,chnCAN *ptrChn,uint8_t dataNum){
 	uint8_t idx;													// used to step thru data buffer
 	uint8_t len;													// used to hold #of bytes to read from SPI line
 	
+	PROF_REGRD();													// instrumentation - register read
 	for(idx=0;idx<4;idx++){											// loop thru buffer
 		ptrChn->regRd[idx] = 0;										// clear register buffer data bytes
 	}
@@ -158,7 +212,46 @@ void mcp251xfd_write_register(uint16_t addr,chnCAN *ptrChn,uint8_t dataNum){
 	mcp251xfd_cs_set(ptrChn->chnNum);								// drive chn x chip select high (chip disable)
 }
 /**************************************************************************************************
-Purpose: 	Reads message object from RX FIFO message object memory
+Purpose: 	Reads a block of consecutive bytes from the SPI line in a single CS assertion
+				(Writes 4bit Cmd, 12bit Addr, then reads len bytes of register/RAM data)
+Inputs:		addr 		- MCP2517 12 bit address of 1st byte to read (values in MCP2517XFD_defs.h)
+			*ptrChn		- chnCAN pointer
+			*ptrBuf_u8	- pointer to a u8 buffer to store the data bytes (lowest address first)
+			len			- #of bytes to read
+Outputs:	None
+**************************************************************************************************/
+void mcp251xfd_read_block(uint16_t addr,chnCAN *ptrChn,uint8_t *ptrBuf_u8,uint8_t len){
+	uint8_t idx;													// used to step thru data buffer
+	
+	mcp251xfd_cs_clr(ptrChn->chnNum);								// drive chn x chip select low (chip enable)
+	spi_putCmd(SPI_READ,addr);										// clock out SPI MCP2517FD 4 bit cmd & 12 bit addr
+	for(idx=0;idx<len;idx++){										// loop thru buffer
+		ptrBuf_u8[idx] = spi_putChr(0xFF);							// clock out dummy bytes to read in data bytes
+	}
+	mcp251xfd_cs_set(ptrChn->chnNum);								// drive chn x chip select high (chip disable)
+}
+/**************************************************************************************************
+Purpose: 	Writes a block of consecutive bytes to the SPI line in a single CS assertion
+				(Writes 4bit Cmd, 12bit Addr, then len bytes of register/RAM data)
+Inputs:		addr 		- MCP2517 12 bit address of 1st byte to write (values in MCP2517XFD_defs.h)
+			*ptrChn		- chnCAN pointer
+			*ptrBuf_u8	- pointer to a u8 buffer holding the data bytes (lowest address first)
+			len			- #of bytes to write
+Outputs:	None
+**************************************************************************************************/
+void mcp251xfd_write_block(uint16_t addr,chnCAN *ptrChn,uint8_t *ptrBuf_u8,uint8_t len){
+	uint8_t idx;													// used to step thru data buffer
+	
+	mcp251xfd_cs_clr(ptrChn->chnNum);								// drive chn x chip select low (chip enable)
+	spi_putCmd(SPI_WRITE,addr);										// clock out SPI MCP2517FD 4 bit cmd & 12 bit addr
+	for(idx=0;idx<len;idx++){										// loop thru buffer
+		spi_putChr(ptrBuf_u8[idx]);									// clock out the data bytes
+	}
+	mcp251xfd_cs_set(ptrChn->chnNum);								// drive chn x chip select high (chip disable)
+}
+#if !MCP251XFD_COMPACT
+/**************************************************************************************************
+Purpose: 	Reads message object from RX FIFO message object memory into the chnCAN msg member
 Inputs:		bufIdx 	- selects which FIFO memory to write
 			*ptrChn	- chnCAN pointer
 Outputs:	result	- error code (defined in qb_mcp2517.h)
@@ -166,31 +259,46 @@ Outputs:	result	- error code (defined in qb_mcp2517.h)
 					ERR_FIFOEMPTY 	= FIFO is empty
 **************************************************************************************************/
 uint8_t mcp251xfd_read_memory(uint8_t bufIdx,chnCAN *ptrChn){
+	return mcp251xfd_read_frame(bufIdx,ptrChn,&ptrChn->msg);		// read straight into the channel msg member
+}
+#endif
+/**************************************************************************************************
+Purpose: 	Reads message object from RX FIFO message object memory straight into a caller owned msgCAN
+				(e.g. a ring buffer entry or log block). The header (ID, flags, DLC), timestamp & pLen
+				are decoded in place, so no copy of the frame is made & the chnCAN msg member is untouched.
+Inputs:		bufIdx 	- selects which FIFO memory to write
+			*ptrChn	- chnCAN pointer
+			*ptrMsg	- msgCAN pointer to read the message object into
+Outputs:	result	- error code (defined in qb_mcp2517.h)
+					ERR_NRXFIFO		= FIFO not configured as RX FIFO
+					ERR_FIFOEMPTY 	= FIFO is empty
+**************************************************************************************************/
+uint8_t mcp251xfd_read_frame(uint8_t bufIdx,chnCAN *ptrChn,msgCAN *ptrMsg){
 	uint8_t idx;													// used to step thru data buffer
 	uint8_t len;													// used to hold #of bytes to write to SPI line
-	uint8_t *ptr_u8;												// used to point to step thru byte members chnCAN object pointed to by *ptrChn
+	uint8_t *ptr_u8;												// used to point to step thru byte members msgCAN object pointed to by *ptrMsg
 	uint8_t bufNum;													// used to hold the calculated buffer reference
 	uint8_t tStamp;
 	uint16_t memAddr;												// used to hold the calculated memeroy address
-	uint8_t	temp[4];												// temporary storage
+	PROF_BEGIN();													// instrumentation - start of call
 	
 	bufNum = (bufIdx > 31) ? 31 : (bufIdx + !bufIdx);				// calculate RX buffer number 1 to 31=FIFO1 to FIFO31
 
 	mcp251xfd_read_register(C1FIFOCON(bufNum),ptrChn,4);			// read in contents of FIFO config register
 	if((ptrChn->regRd[0]>>TXEN) & 1)								// check if FIFO is a TX FIFO
-		return ERR_NTXFIFO;											// return error code
+		PROF_RETURN(PROF_RDMEM,ERR_NTXFIFO);						// return error code
 	
 	tStamp = (ptrChn->regRd[0]>>RXTSEN) & 1;						// Save RX timestamp enable bit
 	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
 	mcp251xfd_read_register(C1FIFOSTA(bufNum),ptrChn,4);			// read in contents of FIFO status register
 	if(!((ptrChn->regRd[0]>>TFNRFNIF) & 1))							// check if FIFO is full
-		return ERR_FIFOEMPTY;										// return error code
+		PROF_RETURN(PROF_RDMEM,ERR_FIFOEMPTY);						// return error code
 		
 	mcp251xfd_read_register(C1FIFOUA(bufNum),ptrChn,4);				// read in contents of user address register
 
 	memAddr = ptrChn->regRd[1];										// set upper byte of buffer memory address
 	memAddr = ((memAddr << 8) | ptrChn->regRd[0]) + 0x400;			// finalize the buffer memory address
-	ptr_u8 = &ptrChn->msg.sid07_00;									// point to the 1st byte of a message object
+	ptr_u8 = &ptrMsg->sid07_00;										// point to the 1st byte of a message object
 	
 	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
 	mcp251xfd_cs_clr(ptrChn->chnNum);								// drive chn x chip select low (chip enable)
@@ -200,14 +308,18 @@ uint8_t mcp251xfd_read_memory(uint8_t bufIdx,chnCAN *ptrChn){
 	}
 	
 	if(tStamp){														// FIFO configured to store RX msg object timestamp
-		ptr_u8 = &ptrChn->msg.rxTstamp[0];							// point to the 0th byte of timestamp buffer
+		ptr_u8 = &ptrMsg->rxTstamp[0];								// point to the 0th byte of timestamp buffer
 		len = 4;													// 4 bytes of the timestamp of RX msg obj
 	}
 	else{															// FIFO not configured to store RX msg object timestamp
-		ptr_u8 = &ptrChn->msg.rxData[0];							// point to the 0th byte of RX buffer
+		ptr_u8 = &ptrMsg->rxData[0];								// point to the 0th byte of RX buffer
 		len = 0;													// 0 bytes of the timestamp of RX msg obj
 	}
-	len += mcp251xfd_mem_payload(ptrChn->msg.fdf,ptrChn->msg.dlc);	// calculate the total length of the message object in bytes
+	len += mcp251xfd_mem_payload(ptrMsg->fdf,ptrMsg->dlc);			// calculate the total length of the message object in bytes
+#if MCP251XFD_MAXPAYLOAD < 64
+	if(len > (4*tStamp + MCP251XFD_MAXPAYLOAD))						// payload longer than the msgCAN buffer
+		len = 4*tStamp + MCP251XFD_MAXPAYLOAD;						// truncate (rest of the msg object is not clocked out)
+#endif
 	for(idx=0;idx<len;idx++){										// loop thru 1st 8 bytes of RX msg object
 		*(ptr_u8 + idx) = spi_putChr(0xFF);							// clock out dummy bytes to read in RX msg object bytes
 	}
@@ -218,15 +330,26 @@ uint8_t mcp251xfd_read_memory(uint8_t bufIdx,chnCAN *ptrChn){
 	ptrChn->regWr[1] = 0x01;										// FRESET=TXREQ=0;UINC=1
 	mcp251xfd_write_register(C1FIFOCON(bufNum),ptrChn,1);			// read register data bytes 
 
-	mcp251xfd_tstamp_calc(ptrChn);									// update the timestamp for the message
-	temp[0] = ptrChn->msg.fdf;										// store FDF value
-	temp[1] = ptrChn->msg.dlc;										// store DLC value
-	ptrChn->msg.pLen = mcp251xfd_len_payload(temp[0],temp[1]);		// calculate the pLen
+	if(tStamp){														// timestamp was read in
+		ptrMsg->tStamp = ptrMsg->rxTstamp[3];						// assemble the timestamp of the message
+		ptrMsg->tStamp = (ptrMsg->tStamp << 8) | ptrMsg->rxTstamp[2];
+		ptrMsg->tStamp = (ptrMsg->tStamp << 8) | ptrMsg->rxTstamp[1];
+		ptrMsg->tStamp = (ptrMsg->tStamp << 8) | ptrMsg->rxTstamp[0];
+	}
+	else															// no timestamp in RX msg object
+		ptrMsg->tStamp = 0;
+	ptrMsg->pLen = mcp251xfd_len_payload(ptrMsg->fdf,ptrMsg->dlc);	// calculate the pLen
+#if MCP251XFD_MAXPAYLOAD < 64
+	if(ptrMsg->pLen > MCP251XFD_MAXPAYLOAD)							// payload was truncated
+		ptrMsg->pLen = MCP251XFD_MAXPAYLOAD;						// pLen = #of valid bytes in rxData
+#endif
+	ptrChn->rxCnt++;												// count the msg read
 	
-	return 0;
+	PROF_RETURN(PROF_RDMEM,0);
 }
+#if !MCP251XFD_COMPACT
 /**************************************************************************************************
-Purpose: 	Writes message object to either TXQ or TX FIFO
+Purpose: 	Writes the chnCAN msg member message object to either TXQ or TX FIFO
 Inputs:		bufIdx 	- selects which TX buffer memory to write
 			*ptrChn	- chnCAN pointer
 Outputs:	result	- error code (defined in qb_mcp2517.h)
@@ -235,41 +358,85 @@ Outputs:	result	- error code (defined in qb_mcp2517.h)
 					ERR_FIFOFULL	= FIFO is full
 **************************************************************************************************/
 uint8_t mcp251xfd_write_memory(uint8_t bufIdx,chnCAN *ptrChn){
+	return mcp251xfd_write_frame(bufIdx,ptrChn,&ptrChn->msg);		// write from the channel msg member
+}
+#endif
+/**************************************************************************************************
+Purpose: 	Writes a caller owned msgCAN message object (TX staging buffer) to either TXQ or TX FIFO
+Inputs:		bufIdx 	- selects which TX buffer memory to write
+			*ptrChn	- chnCAN pointer
+			*ptrMsg	- msgCAN pointer to write the message object from
+Outputs:	result	- error code (defined in qb_mcp2517.h)
+					ERR_TXQFULL 	= TXQ is full
+					ERR_NTXFIFO 	= FIFO not configured as TX FIFO
+					ERR_FIFOFULL	= FIFO is full
+**************************************************************************************************/
+uint8_t mcp251xfd_write_frame(uint8_t bufIdx,chnCAN *ptrChn,msgCAN *ptrMsg){
+	return mcp251xfd_write_object(bufIdx,ptrChn,&ptrMsg->sid07_00,8 + mcp251xfd_mem_payload(ptrMsg->fdf,ptrMsg->dlc));
+}
+/**************************************************************************************************
+Purpose: 	Writes a raw TX message object (T0,T1,payload as laid out in MCP2517 memory) to either TXQ or TX FIFO
+Inputs:		bufIdx 	- selects which TX buffer memory to write
+			*ptrChn	- chnCAN pointer
+			*ptrObj	- pointer to the 1st byte of the message object (T0 byte 0)
+			len		- total length of the message object in bytes (8 + payload bytes in multiples of 4)
+Outputs:	result	- error code (defined in qb_mcp2517.h)
+					ERR_TXQFULL 	= TXQ is full
+					ERR_NTXFIFO 	= FIFO not configured as TX FIFO
+					ERR_FIFOFULL	= FIFO is full
+**************************************************************************************************/
+uint8_t mcp251xfd_write_object(uint8_t bufIdx,chnCAN *ptrChn,const uint8_t *ptrObj,uint8_t len){
+	return mcp251xfd_write_parts(bufIdx,ptrChn,ptrObj,ptrObj + 8,len - 8);
+}
+/**************************************************************************************************
+Purpose: 	Writes a TX message object from separate header & payload buffers to either TXQ or TX FIFO
+				(e.g. forwards a msg read by mcp251xfd_read_frame() from its rxData without a copy)
+Inputs:		bufIdx 	- selects which TX buffer memory to write
+			*ptrChn	- chnCAN pointer
+			*ptrHdr	- pointer to the 8 byte T0,T1 header (e.g. &msg.sid07_00)
+			*ptrBuf	- pointer to the payload
+			len		- #of payload bytes to write (multiple of 4, refer to mcp251xfd_mem_payload())
+Outputs:	result	- error code (defined in qb_mcp2517.h)
+					ERR_TXQFULL 	= TXQ is full
+					ERR_NTXFIFO 	= FIFO not configured as TX FIFO
+					ERR_FIFOFULL	= FIFO is full
+**************************************************************************************************/
+uint8_t mcp251xfd_write_parts(uint8_t bufIdx,chnCAN *ptrChn,const uint8_t *ptrHdr,const uint8_t *ptrBuf,uint8_t len){
 	uint8_t idx;													// used to step thru data buffer
-	uint8_t len;													// used to hold #of bytes to write to SPI line
-	uint8_t *ptr_u8;												// used to point to step thru byte members chnCAN object pointed to by *ptrChn
 	uint8_t bufNum;													// used to hold the calculated buffer reference
 	uint16_t memAddr;												// used to hold the calculated memeroy address
+	PROF_BEGIN();													// instrumentation - start of call
 	
 	bufNum = (bufIdx > 31) ? 31 : bufIdx;							// calculate TX buffer number 0=TXQ;1 to 31=FIFO1 to FIFO31	
 	if(!bufNum){													// working with TXQ buffer
 		mcp251xfd_read_register(ADDR_C1TXQSTA,ptrChn,4);			// read in contents of TXQ status register
 		if(!((ptrChn->regRd[0]>>TXQNIF) & 1))						// check if TXQ buffer is full
-			return ERR_TXQFULL;										// return error code
+			PROF_RETURN(PROF_WRMEM,ERR_TXQFULL);					// return error code
 			
 		mcp251xfd_read_register(ADDR_C1TXQUA,ptrChn,4);				// read in contents of TXQ user address register
 	}
 	else{															// working with TX FIFO
 		mcp251xfd_read_register(C1FIFOCON(bufNum),ptrChn,4);		// read in contents of FIFO config register
 		if(!((ptrChn->regRd[0]>>TXEN) & 1))							// check if FIFO is a TX FIFO
-			return ERR_NTXFIFO;										// return error code
+			PROF_RETURN(PROF_WRMEM,ERR_NTXFIFO);					// return error code
 		
 		for(idx=0;idx<CSCNT;idx++);									// delay for toggling CS
 		mcp251xfd_read_register(C1FIFOSTA(bufNum),ptrChn,4);		// read in contents of FIFO status register
 		if(!((ptrChn->regRd[0]>>TFNRFNIF) & 1))						// check if FIFO is full
-			return ERR_FIFOFULL;									// return error code
+			PROF_RETURN(PROF_WRMEM,ERR_FIFOFULL);					// return error code
 			
 		mcp251xfd_read_register(C1FIFOUA(bufNum),ptrChn,4);			// read in contents of user address register
 	}
 	memAddr = ptrChn->regRd[1];										// set upper byte of buffer memory address
 	memAddr = ((memAddr << 8) | ptrChn->regRd[0]) + 0x400;			// finalize the buffer memory address
-	len = 8 + mcp251xfd_mem_payload(ptrChn->msg.fdf,ptrChn->msg.dlc);	// calculate the total length of the message object in bytes
-	ptr_u8 = &ptrChn->msg.sid07_00;										// point to the 1st byte of a message object
 	
 	mcp251xfd_cs_clr(ptrChn->chnNum);								// drive chn x chip select low (chip enable)
 	spi_putCmd(SPI_WRITE,memAddr);									// clock out SPI MCP2517FD 4 bit cmd & 12 bit addr
-	for(idx=0;idx<len;idx++){										// loop thru buffer
-		spi_putChr(*(ptr_u8 + idx));								// clock out the register msg object bytes
+	for(idx=0;idx<8;idx++){											// loop thru header
+		spi_putChr(*(ptrHdr + idx));								// clock out the T0,T1 msg object bytes
+	}
+	for(idx=0;idx<len;idx++){										// loop thru payload
+		spi_putChr(*(ptrBuf + idx));								// clock out the payload msg object bytes
 	}
 	mcp251xfd_cs_set(ptrChn->chnNum);								// drive chn x chip select high (chip disable)
 	
@@ -280,8 +447,9 @@ uint8_t mcp251xfd_write_memory(uint8_t bufIdx,chnCAN *ptrChn){
 		mcp251xfd_write_register(ADDR_C1TXQCON,ptrChn,1);			// write register data byte 1 
 	else															// working with TX FIFO
 		mcp251xfd_write_register(C1FIFOCON(bufNum),ptrChn,1);		// read register data bytes 
+	ptrChn->txCnt++;												// count the msg loaded
 
-	return 0;
+	PROF_RETURN(PROF_WRMEM,0);
 }
 /**************************************************************************************************
 Purpose: 	Checks if MCP2517 interrupt pin is active
@@ -292,10 +460,14 @@ Outputs:	result	- status of the interrupt pin of channel pointed to by ptrChn
 					1 = channel interrupt pin active
 **************************************************************************************************/
 uint8_t mcp251xfd_check_message(chnCAN *ptrChn) {
+#ifdef MCP251XFD_HOST
+	return (!mcp251xfd_host_int(ptrChn->chnNum));
+#else
 	if(ptrChn->chnNum <= 1)
 		return (!IS_SET(MCP2517XFD_INT1));
 	else
 		return (!IS_SET(MCP2517XFD_INT2));
+#endif
 }
 /**************************************************************************************************
 Purpose: 	Requests message(s) to be transmit from in TXQ or TX FIFO
@@ -309,24 +481,25 @@ Outputs:	result	- error code (defined in qb_mcp2517.h)
 uint8_t mcp251xfd_start_transmit(uint8_t bufIdx,chnCAN *ptrChn){
 	uint8_t idx;													// used to step thru data buffer
 	uint8_t bufNum;													// used to hold the calculated buffer reference
+	PROF_BEGIN();													// instrumentation - start of call
 	
 	bufNum = (bufIdx > 31) ? 31 : bufIdx;							// calculate TX buffer number 0=TXQ;1 to 31=FIFO1 to FIFO31
 	if(!bufNum){													// working with TXQ buffer
 		mcp251xfd_read_register(ADDR_C1TXQSTA,ptrChn,4);			// read in contents of TXQ status register
 		if((ptrChn->regRd[0]>>TXQEIF) & 1)							// check if TXQ buffer is empty
-			return ERR_TXQEMPTY;									// return error code
+			PROF_RETURN(PROF_TXSTART,ERR_TXQEMPTY);					// return error code
 			
 		mcp251xfd_read_register(ADDR_C1TXQUA,ptrChn,4);				// read in contents of TXQ user address register
 	}
 	else{															// working with TX FIFO
 		mcp251xfd_read_register(C1FIFOCON(bufNum),ptrChn,4);		// read in contents of FIFO config register
 		if(!((ptrChn->regRd[0]>>TXEN) & 1))							// check if FIFO is a TX FIFO
-			return ERR_NTXFIFO;										// return error code
+			PROF_RETURN(PROF_TXSTART,ERR_NTXFIFO);					// return error code
 			
 		for(idx=0;idx<CSCNT;idx++);									// delay for toggling CS
 		mcp251xfd_read_register(C1FIFOSTA(bufNum),ptrChn,4);		// read in contents of FIFO status register
 		if((ptrChn->regRd[0]>>TFERFFIF) & 1)						// check if FIFO is empty
-			return ERR_FIFOEMPTY;									// return error code
+			PROF_RETURN(PROF_TXSTART,ERR_FIFOEMPTY);				// return error code
 	}
 
 	// Transmit request
@@ -337,8 +510,9 @@ uint8_t mcp251xfd_start_transmit(uint8_t bufIdx,chnCAN *ptrChn){
 	else															// working with TX FIFO
 		mcp251xfd_write_register(C1FIFOCON(bufNum),ptrChn,1);		// read register data bytes 
 		
-	return 0;
+	PROF_RETURN(PROF_TXSTART,0);
 }
+#if !MCP251XFD_COMPACT
 /**************************************************************************************************
 Purpose: 	Aids in preparing the chnCAN message object parameters
 Inputs:		*ptrChn	- chnCAN pointer
@@ -350,31 +524,58 @@ Inputs:		*ptrChn	- chnCAN pointer
 Outputs:	none
 **************************************************************************************************/
 void mcp251xfd_msg_write(chnCAN *ptrChn,unsigned long id,uint8_t ide,uint8_t fdf,uint8_t brs,uint8_t rtr,uint8_t bufLen,uint8_t *buf_u8){
+	mcp251xfd_frame_prep(&ptrChn->msg,id,ide,fdf,brs,rtr,bufLen,buf_u8);	// prepare the channel msg member
+}
+#endif
+/**************************************************************************************************
+Purpose: 	Aids in preparing a caller owned msgCAN message object (TX staging buffer)
+Inputs:		*ptrMsg	- msgCAN pointer
+			id		- message ID
+			fdf		- message FDF field (FDF & BRS forced to 0 by MCP251XFD_CLASSIC_ONLY)
+			bufLen	- message DLC field (capped to MCP251XFD_MAXPAYLOAD)
+			*buf_u8	- pointer to a payload u8 buffer array
+						
+Outputs:	none
+**************************************************************************************************/
+void mcp251xfd_frame_prep(msgCAN *ptrMsg,unsigned long id,uint8_t ide,uint8_t fdf,uint8_t brs,uint8_t rtr,uint8_t bufLen,uint8_t *buf_u8){
 	uint8_t idx;													// used to step thru data buffer
-	uint8_t len;													// used to hold #of bytes to write to SPI line
-	uint8_t *ptr_u8;												// used to point to step thru byte members chnCAN object pointed to by *ptrChn
+	uint8_t t1;														// used to hold T1 byte 0 (DLC & flags)
 	
-	ptr_u8 = &ptrChn->msg.sid07_00;									// point to sid07_00 member
-	if(!ide){
-	*(ptr_u8 + 0) = (id >> 0);										// sid07_00 
-	*(ptr_u8 + 1) = (id >> 8);										// eid04_00,sid10_80
-	}
-	else{
-	*(ptr_u8 + 0) = (id >> 18);										// sid07_00 
-	*(ptr_u8 + 1) = (id << 3) | (0x07 & (id >> 26));				// eid04_00,sid10_80		
-	*(ptr_u8 + 2) = (id >> 5);										// eid12_05
-	*(ptr_u8 + 3) = (id >> 13) & 0x1F;								// sid11,eid17_13
-	}
-	ptrChn->msg.fdf = (fdf > 0);									// calculate the FDF
-	ptrChn->msg.brs = (brs > 0);									// calculate the BRS
-	ptrChn->msg.rtr = (rtr > 0);									// calculate the RTR
-	ptrChn->msg.ide = (id > 0x7FF)||(ide > 0);						// calculate the IDE
-	ptrChn->msg.dlc = mcp251xfd_dlc_payload(fdf,bufLen);			// calculate the DLC
+	if(bufLen > MCP251XFD_MAXPAYLOAD)								// payload longer than the msgCAN buffer
+		bufLen = MCP251XFD_MAXPAYLOAD;
+#if MCP251XFD_CLASSIC_ONLY
+	fdf = 0;														// CAN 2.0 frames only
+	brs = 0;
+#endif
+	id &= CANID_MASK;												// 29 bit ID
+	if((id > 0x7FF) || ide)											// ID needs extended format
+		id |= CANID_EXT;
+	t1 = mcp251xfd_dlc_payload(fdf,bufLen);							// calculate the DLC
+	if(fdf)	t1 |= CANFRAME_FD;										// calculate the FDF
+	if(brs)	t1 |= CANFRAME_BRS;										// calculate the BRS
+	if(rtr)	t1 |= CANFRAME_RTR;										// calculate the RTR
+	mcp251xfd_hdr_pack(&ptrMsg->sid07_00,id,t1);					// pack T0 & T1
 	for(idx=0;idx<bufLen;idx++){									// loop thru buffer
-		ptrChn->msg.txData[idx] = buf_u8[idx];
+		ptrMsg->txData[idx] = buf_u8[idx];
 	}
 }
 /**************************************************************************************************
+Purpose: 	Prepares the C1NBTCFG register write packet for a nominal CAN speed (SYSCLK=40MHz;BRP=0)
+Inputs:		*ptrChn	- chnCAN pointer
+			speed	- CANSPEED_125/250/500/1000 (any other value = 500k)
+Outputs:	None
+**************************************************************************************************/
+static void mcp251xfd_nbt_prep(chnCAN *ptrChn,uint8_t speed){
+	if(speed == CANSPEED_125)										// CANbus speed 125k
+		mcp251xfd_reg_prep(ptrChn,1,0x00,0xFE,0x3F,0x3F);			// B3(BRP=0) B2(TSEG1=254) B1(TSEG2=63) B0(SJW=63)
+	else if(speed == CANSPEED_250)									// CANbus speed 250k
+		mcp251xfd_reg_prep(ptrChn,1,0x00,0x7E,0x1F,0x1F);			// B3(BRP=0) B2(TSEG1=126) B1(TSEG2=31) B0(SJW=31)
+	else if(speed == CANSPEED_1000)									// CANbus speed 1M
+		mcp251xfd_reg_prep(ptrChn,1,0x00,0x1E,0x07,0x07);			// B3(BRP=0) B2(TSEG1=30) B1(TSEG2=7) B0(SJW=7)
+	else															// Default CANbus speed 500k
+		mcp251xfd_reg_prep(ptrChn,1,0x00,0x3E,0x0F,0x0F);			// B3(BRP=0) B2(TSEG1=62) B1(TSEG2=15) B0(SJW=15)
+}
+/**************************************************************************************************
 Purpose: 	Sets up the GPIO interface/pins for both MCP2517 channels and configures the SPI hardware
 Inputs:		chnNum	- channel #(s)
 					  < 1 = Both
@@ -383,6 +584,12 @@ Inputs:		chnNum	- channel #(s)
 Outputs:	None
 **************************************************************************************************/
 void mcp251xfd_init_hardware(uint8_t chnNum){	
+#ifdef MCP251XFD_HOST
+	if(chnNum <= 1)											// need to setup channel 1
+		mcp251xfd_host_cs(1,1);								// default channel 1 chip select high (SPI is setup by the host)
+	if(!chnNum || chnNum > 1)								// need to setup channel 2
+		mcp251xfd_host_cs(2,1);								// default channel 2 chip select high (SPI is setup by the host)
+#else
 	if(chnNum <= 1){										// need to setup channel 1
 		SET(MCP2517XFD_CS1);								// default channel 1 chip select high 
 		SET_OUTPUT(MCP2517XFD_CS1);							// configure channel 1 chip select as an output 
@@ -408,6 +615,7 @@ void mcp251xfd_init_hardware(uint8_t chnNum){
 	// active SPI master interface
 	SPCR = (1<<SPE)|(1<<MSTR);								// config SPI - (SPI enable)|(SPI master)
 	SPSR = (1<<SPI2X);										// config SPI - (Fosc/2) = 16Mhz/2 = 8Mhz
+#endif
 }	
 /**************************************************************************************************
 Purpose: 	Initializes the specified MCP2517 channel as a CAN2.0 channel
@@ -423,13 +631,16 @@ Outputs:	None
 **************************************************************************************************/
 uint8_t mcp251xfd_init(uint8_t speed,chnCAN *ptrChn,uint8_t chnNum,uint8_t bufIdxTx,uint8_t bufIdxRx){
 	uint8_t idx, temp, txIdx, rxIdx;
+	PROF_BEGIN();													// instrumentation - start of call
 	
 	txIdx = (bufIdxTx > 31) ? 31 : bufIdxTx;						// calculate TX buffer number 0 to 31=TXQ - FIFO1 to FIFO31
 	rxIdx = (bufIdxRx > 31) ? 31 : (bufIdxRx + !bufIdxRx);			// calculate RX buffer number 1 to 31=FIFO1 to FIFO31
 	if(txIdx==rxIdx)												// TX buffer equals RX buffer
-		return 1;													// return fault code for this algorithm error
+		PROF_RETURN(PROF_INIT,1);									// return fault code for this algorithm error
 	
 	ptrChn->chnNum = 1 + (chnNum > 1);								// calculate and set the CAN FD channel number (1 or 2)
+	ptrChn->rxCnt = 0;												// reset RX msg counter
+	ptrChn->txCnt = 0;												// reset TX msg counter
 	mcp251xfd_init_hardware(chnNum);								// initialize the specified CAN FD channel hardware
 	
 	mcp251xfd_cs_clr(ptrChn->chnNum);								// drive chn x chip select low (chip enable)
@@ -443,7 +654,7 @@ uint8_t mcp251xfd_init(uint8_t speed,chnCAN *ptrChn,uint8_t chnNum,uint8_t bufId
 	for(idx=0;idx<CSCNT;idx++);
 	mcp251xfd_read_register(ADDR_OSC,ptrChn,0);						// read register data bytes 
 	if(!mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,0))		// data did not write to the MCP2517
-		return 10;													// return fault code for this register write error
+		PROF_RETURN(PROF_INIT,10);									// return fault code for this register write error
 	
 	// Setup register write packet - IOCON ----------------------------------------------------------------------------------------------------------
 	mcp251xfd_reg_prep(ptrChn,1,0x41,0x00,0x00,0x40);				// B3(SOF=TXCANOD=PM1=0;INTOD=PM0=1) B2(GPIO1=0;GPIO0=1) B1(read only) B0(XSTBYEN=1)
@@ -452,22 +663,17 @@ uint8_t mcp251xfd_init(uint8_t speed,chnCAN *ptrChn,uint8_t chnNum,uint8_t bufId
 	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
 	mcp251xfd_read_register(ADDR_IOCON,ptrChn,4);					// read register data bytes 
 	if(ptrChn->regWr[3]!=ptrChn->regRd[3])							// data did not write to the MCP2517
-		return 11;													// return fault code for this register write error
+		PROF_RETURN(PROF_INIT,11);									// return fault code for this register write error
 	if(ptrChn->regWr[0]!=ptrChn->regRd[0])							// data did not write to the MCP2517
-		return 11;													// return fault code for this register write error
+		PROF_RETURN(PROF_INIT,11);									// return fault code for this register write error
 
 	// Setup register write packet - C1NBTCFG -------------------------------------------------------------------------------------------------------
-	if(speed == CANSPEED_125)										// CANbus speed 125k
-		mcp251xfd_reg_prep(ptrChn,1,0x00,0xFE,0x3F,0x3F);			// B3(BRP=0) B2(TSEG1=254) B1(TSEG2=63) B0(SJW=63)
-	else if(speed == CANSPEED_250)									// CANbus speed 250k
-		mcp251xfd_reg_prep(ptrChn,1,0x00,0x7E,0x1F,0x1F);			// B3(BRP=0) B2(TSEG1=126) B1(TSEG2=31) B0(SJW=31)
-	else															// Default CANbus speed 500k
-		mcp251xfd_reg_prep(ptrChn,1,0x00,0x3E,0x0F,0x0F);			// B3(BRP=0) B2(TSEG1=62) B1(TSEG2=15) B0(SJW=15)
+	mcp251xfd_nbt_prep(ptrChn,speed);								// prepare nominal bit timing
 	mcp251xfd_write_register(ADDR_C1NBTCFG,ptrChn,4);				// write register data bytes
 	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
 	mcp251xfd_read_register(ADDR_C1NBTCFG,ptrChn,4);				// read register data bytes 
 	if(!mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,4))		// data did not write to the MCP2517
-		return 101;													// return fault code for this register write error
+		PROF_RETURN(PROF_INIT,101);									// return fault code for this register write error
 
 	// Setup register write packet - C1DBTCFG -------------------------------------------------------------------------------------------------------
 //	mcp251xfd_reg_prep(ptrChn,1,0x00,0x1E,0x07,0x07);				// B3(BRP=0) B2(TSEG1=30) B1(TSEG2=7) B0(SJW=7)[1MHz] (tested at 250mm)
@@ -478,7 +684,7 @@ uint8_t mcp251xfd_init(uint8_t speed,chnCAN *ptrChn,uint8_t chnNum,uint8_t bufId
 	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
 	mcp251xfd_read_register(ADDR_C1DBTCFG,ptrChn,4);				// read register data bytes 
 	if(!mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,4))		// data did not write to the MCP2517
-		return 102;													// return fault code for this register write error
+		PROF_RETURN(PROF_INIT,102);									// return fault code for this register write error
 		
 	// Setup register write packet - C1TDC ----------------------------------------------------------------------------------------------------------
 	mcp251xfd_reg_prep(ptrChn,1,0x00,0x00,0x00,0x00);				// B3(EDGFLTEN=SID11EN=0) B2(TDCMOD=0) B1(TDCO=16) B0(TDCV=0)
@@ -486,7 +692,7 @@ uint8_t mcp251xfd_init(uint8_t speed,chnCAN *ptrChn,uint8_t chnNum,uint8_t bufId
 	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
 	mcp251xfd_read_register(ADDR_C1TDC,ptrChn,4);					// read register data bytes 
 	if(!mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,4))		// data did not write to the MCP2517
-		return 103;													// return fault code for this register write error
+		PROF_RETURN(PROF_INIT,103);									// return fault code for this register write error
 	
 	// Setup register write packet - C1TSCON --------------------------------------------------------------------------------------------------------
 	mcp251xfd_reg_prep(ptrChn,1,0x00,0x01,0x00,0x00);				// B3(RESERVED=0) B2(TSRES=TSEOF=0;TBCEN=1) B1(TBCPRE[9:8]=0) B0(TBCPRE[7:0]=0)
@@ -494,7 +700,7 @@ uint8_t mcp251xfd_init(uint8_t speed,chnCAN *ptrChn,uint8_t chnNum,uint8_t bufId
 	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
 	mcp251xfd_read_register(ADDR_C1TSCON,ptrChn,4);					// read register data bytes 
 	if(!mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,4))		// data did not write to the MCP2517
-		return 105;													// return fault code for this register write error
+		PROF_RETURN(PROF_INIT,105);									// return fault code for this register write error
 		
 	// Setup register write packet - C1INT ----------------------------------------------------------------------------------------------------------
 	mcp251xfd_reg_prep(ptrChn,1,0x00,0x02,0x00,0x00);				// B3(IVMIE=WAKIE=CERRIE-SERRIE=RXOVIE=TXATIE=SPICRCIE=ECCIE=0) B2(TEFIE=MODIE=TBCIE=0;RXIE=1;TXIE=0) B1(read only) B0(read only)
@@ -502,9 +708,9 @@ uint8_t mcp251xfd_init(uint8_t speed,chnCAN *ptrChn,uint8_t chnNum,uint8_t bufId
 	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
 	mcp251xfd_read_register(ADDR_C1INT,ptrChn,4);					// read register data bytes 
 	if(!mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,3))		// data did not write to the MCP2517
-		return 107;													// return fault code for this register write error
+		PROF_RETURN(PROF_INIT,107);									// return fault code for this register write error
 	if(!mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,2))		// data did not write to the MCP2517
-		return 107;													// return fault code for this register write error
+		PROF_RETURN(PROF_INIT,107);									// return fault code for this register write error
 	
 	// Setup register write packet - C1TEFCON -------------------------------------------------------------------------------------------------------
 	mcp251xfd_reg_prep(ptrChn,1,0x1F,0x00,0x04,0x20);				// B3(FSIZE=0) B2(RESERVED=0) B1(FRESET=1;UNIC=0) B0(TEFTSEN=1;TEFOVIE=TEFFIE=TEFHIE=TEFNEIE=0)
@@ -512,7 +718,7 @@ uint8_t mcp251xfd_init(uint8_t speed,chnCAN *ptrChn,uint8_t chnNum,uint8_t bufId
 	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
 	mcp251xfd_read_register(ADDR_C1TEFCON,ptrChn,4);				// read register data bytes 
 	if(!mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,4))		// data did not write to the MCP2517
-		return 116;													// return fault code for this register write error
+		PROF_RETURN(PROF_INIT,116);									// return fault code for this register write error
 	
 	// Setup register write packet - C1TXQCON/C1FIFOCONn for Transmits  -----------------------------------------------------------------------------
 	mcp251xfd_reg_prep(ptrChn,1,0xE0,0x40,0x04,0x80);				// B3(PLSIZE=7;FSIZE=0) B2(TXAT=2;TXPRI=0) B1(FRESET=1;TXREQ=UNIC=0) B0(TXEN=1;TXATIE=TXQEIE=TXQNIE=0)
@@ -520,7 +726,7 @@ uint8_t mcp251xfd_init(uint8_t speed,chnCAN *ptrChn,uint8_t chnNum,uint8_t bufId
 	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
 	mcp251xfd_read_register(C1FIFOCON(txIdx),ptrChn,4);				// read register data bytes
 	if(!mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,4))		// data did not write to the MCP2517
-		return 119;													// return fault code for this register write error
+		PROF_RETURN(PROF_INIT,119);									// return fault code for this register write error
 		
 	// Setup register write packet - C1FIFOCONn -----------------------------------------------------------------------------------------------------
 	mcp251xfd_reg_prep(ptrChn,1,0xE3,0x60,0x04,0x21);				// B3(PLSIZE=7;FSIZE=3) B2(TXAT=3;TXPRI=0) B1(FRESET=1;TXREQ=UNIC=0) B0(TXEN=RTREN=TXATIE=RXOVIE=TFERFFIE=TFHRFHIE=0;TRNRFNIE=RXTSEN=1)
@@ -528,7 +734,7 @@ uint8_t mcp251xfd_init(uint8_t speed,chnCAN *ptrChn,uint8_t chnNum,uint8_t bufId
 	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
 	mcp251xfd_read_register(C1FIFOCON(rxIdx),ptrChn,4);				// read register data bytes 
 	if(!mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,4))		// data did not write to the MCP2517
-		return 122;													// return fault code for this register write error
+		PROF_RETURN(PROF_INIT,122);									// return fault code for this register write error
 	
 	// Setup register write packet - C1CON ----------------------------------------------------------------------------------------------------------
 	mcp251xfd_reg_prep(ptrChn,1,0x04,0x98,0x07,0x40);				// B3(TXBWS=ABAT=0;REQOP=4) B2(OPMOD=0;TXQEN=STEF=1;SERR2LOM=ESIGM=RTXAT=0) B1(BRSDIS=0;WFT=3;WAKFIL=1) B0(PXEDIS=1;ISOCRCEN=DNCNT=0)
@@ -549,9 +755,9 @@ uint8_t mcp251xfd_init(uint8_t speed,chnCAN *ptrChn,uint8_t chnNum,uint8_t bufId
 	for(idx=0;idx<CSCNT;idx++);									// delay for toggling CS
 	mcp251xfd_read_register(ADDR_C1CON,ptrChn,4);					// read register data bytes 
 	if(!mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,4))		// data did not write to the MCP2517
-		return 199;													// return fault code for this register write error
+		PROF_RETURN(PROF_INIT,199);									// return fault code for this register write error
 
-	return 0;														// return value for success
+	PROF_RETURN(PROF_INIT,0);										// return value for success
 }
 /**************************************************************************************************
 Purpose: 	Compares the contents of 2 uint8_t buffers
@@ -600,6 +806,7 @@ Outputs:	None
 **************************************************************************************************/
 uint8_t mcp251xfd_fltr_setup(chnCAN *ptrChn,uint8_t bufIdx,uint8_t fltrNum,uint8_t fltrIdx,uint8_t fltrType,unsigned long msgId,unsigned long mskId){
 	uint8_t idx, temp, bufIdx2, fltrIdx2, fltrNum2, fltrObj, fltrMsk;
+	PROF_BEGIN();													// instrumentation - start of call
 	
 	bufIdx2 = (bufIdx > 31) ? 31 : (bufIdx + !bufIdx);				// calculate RX buffer number 1 to 31=FIFO1 to FIFO31
 	fltrNum2 = (fltrNum > 7) ? 7 : fltrNum;							// calculate filter num of the filter register
@@ -615,7 +822,7 @@ uint8_t mcp251xfd_fltr_setup(chnCAN *ptrChn,uint8_t bufIdx,uint8_t fltrNum,uint8
 	mcp251xfd_read_register(C1FLTCON(fltrNum2),ptrChn,fltrIdx2);		// read register data bytes 
 	
 	if(!mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,fltrIdx2))	// data did not write to the MCP2517
-		return 11;														// return fault code for this register write error
+		PROF_RETURN(PROF_FLTR,11);										// return fault code for this register write error
 		
 	// Write to C1FLTOBJn the msg ID to filter on -----------------------------------------------------------------------------------------
 	temp = (fltrType>=2) || !fltrType;								// Calculate EXIDE bit
@@ -629,7 +836,7 @@ uint8_t mcp251xfd_fltr_setup(chnCAN *ptrChn,uint8_t bufIdx,uint8_t fltrNum,uint8
 	mcp251xfd_read_register(C1FLTOBJ(fltrObj),ptrChn,4);			// read register data bytes 
 	
 	if(!mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,4))		// data did not write to the MCP2517
-		return 21;													// return fault code for this register write error
+		PROF_RETURN(PROF_FLTR,21);									// return fault code for this register write error
 	
 	// Write to C1MASKn the mask of msg ID to filter on -----------------------------------------------------------------------------------
 	temp = (fltrType>=1);											// Calculate MIDE bit
@@ -643,7 +850,7 @@ uint8_t mcp251xfd_fltr_setup(chnCAN *ptrChn,uint8_t bufIdx,uint8_t fltrNum,uint8
 	mcp251xfd_read_register(C1MASK(fltrMsk),ptrChn,4);				// read register data bytes 
 	
 	if(!mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,4))		// data did not write to the MCP2517
-		return 31;
+		PROF_RETURN(PROF_FLTR,31);
 		
 	// Write to C1FLTCONn to enable appropriate filter number -----------------------------------------------------------------------------
 	ptrChn->regWr[fltrIdx2] = bufIdx2 | 0x80;							// FLTEN=1;F0BP=bufIdx2
@@ -653,9 +860,188 @@ uint8_t mcp251xfd_fltr_setup(chnCAN *ptrChn,uint8_t bufIdx,uint8_t fltrNum,uint8
 	mcp251xfd_read_register(C1FLTCON(fltrNum2),ptrChn,fltrIdx2);		// read register data bytes 
 	
 	if(!mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,fltrIdx2))	// data did not write to the MCP2517
-		return 12;														// return fault code for this register write error
+		PROF_RETURN(PROF_FLTR,12);										// return fault code for this register write error
 	
-	return 0;															// return value for success
+	PROF_RETURN(PROF_FLTR,0);											// return value for success
+}
+/**************************************************************************************************
+Purpose: 	Sets up a FIFO as a 1 msg deep TX FIFO (64 byte payload) after mcp251xfd_init(), e.g. 1 FIFO
+				per msg updated in place (qb_canupd) or per remote request answered (qb_canrtr). Switches the channel to configuration mode & back to
+				the operation mode it was in; FIFO RAM is reallocated, so pending msgs of all FIFOs are lost.
+Inputs:		*ptrChn		- chnCAN pointer
+			bufIdx		- FIFO to setup (1-31; must not be the RX FIFO given to mcp251xfd_init())
+			txPri		- TX priority (0-31; 31 = highest)
+			rtrEn		- 1 = transmit the loaded msg when a remote frame is received by a filter pointing
+							to the FIFO (RTREN=1);0 = transmit on request only
+
+Outputs:	result		- fault code (refer to mcp251xfd_txfifo_depth())
+**************************************************************************************************/
+uint8_t mcp251xfd_txfifo_setup(chnCAN *ptrChn,uint8_t bufIdx,uint8_t txPri,uint8_t rtrEn){
+	return mcp251xfd_txfifo_depth(ptrChn,bufIdx,txPri,rtrEn,1);
+}
+/**************************************************************************************************
+Purpose: 	Sets up a FIFO as a TX FIFO of depth msgs (64 byte payload, 72 bytes of message RAM each) after
+				mcp251xfd_init(), e.g. a TX FIFO deep enough for the msgs loaded before 1 transmit request
+				(qb_cangw batch, qb_cancyc msgs due in the same tick). The 2048 bytes of message RAM are shared
+				by all FIFOs: next to the mcp251xfd_init() FIFOs there is room for about 17 msgs. Switches the
+				channel to configuration mode & back to the operation mode it was in; FIFO RAM is reallocated,
+				so pending msgs of all FIFOs are lost.
+Inputs:		*ptrChn		- chnCAN pointer
+			bufIdx		- FIFO to setup (1-31; must not be the RX FIFO given to mcp251xfd_init())
+			txPri		- TX priority (0-31; 31 = highest)
+			rtrEn		- 1 = transmit the loaded msg when a remote frame is received by a filter pointing
+							to the FIFO (RTREN=1);0 = transmit on request only
+			depth		- #of msgs the FIFO holds (1-32)
+
+Outputs:	result		- fault code
+						0  = success
+						41 = configuration mode request timed out
+						42 = FIFO config register write error
+						43 = operation mode request timed out (refer to mcp251xfd_mode_req())
+**************************************************************************************************/
+uint8_t mcp251xfd_txfifo_depth(chnCAN *ptrChn,uint8_t bufIdx,uint8_t txPri,uint8_t rtrEn,uint8_t depth){
+	uint8_t idx, bufNum, opMod, match;
+
+	bufNum = (bufIdx > 31) ? 31 : (bufIdx + !bufIdx);				// calculate TX buffer number 1 to 31=FIFO1 to FIFO31
+	opMod = mcp251xfd_mode_get(ptrChn);								// operation mode to return to
+	if(mcp251xfd_mode_req(ptrChn,CANMODE_CONFIG))					// request configuration mode
+		return 41;													// return fault code for this mode request
+
+	// Setup register write packet - C1FIFOCONn -----------------------------------------------------------------------------------------------------
+	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
+	depth = (!depth) ? 1 : (depth > 32) ? 32 : depth;					// FSIZE = depth - 1
+	mcp251xfd_reg_prep(ptrChn,1,0xE0 | (depth - 1),0x40 | (txPri & 0x1F),0x04,0x80 | (!!rtrEn << RTREN));	// B3(PLSIZE=7;FSIZE=depth-1) B2(TXAT=2;TXPRI=txPri) B1(FRESET=1;TXREQ=UNIC=0) B0(TXEN=1;RTREN=rtrEn;TXATIE=TXQEIE=TXQNIE=0)
+	mcp251xfd_write_register(C1FIFOCON(bufNum),ptrChn,4);			// write register data bytes
+	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
+	mcp251xfd_read_register(C1FIFOCON(bufNum),ptrChn,4);			// read register data bytes
+	match = mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,4);
+
+	if(mcp251xfd_mode_req(ptrChn,opMod))							// request previous operation mode
+		return 43;													// return fault code for this mode request
+	if(!match)														// data did not write to the MCP2517
+		return 42;													// return fault code for this register write error
+	return 0;														// return value for success
+}
+/**************************************************************************************************
+Purpose: 	Returns the operation mode of a channel (C1CON.OPMOD)
+Inputs:		*ptrChn		- chnCAN pointer
+
+Outputs:	result		- CANMODE_x (defined in qb_mcp251xfd.h)
+**************************************************************************************************/
+uint8_t mcp251xfd_mode_get(chnCAN *ptrChn){
+	mcp251xfd_read_register(ADDR_C1CON,ptrChn,2);					// read register data byte 2
+	return ptrChn->regRd[2] >> OPMOD;
+}
+/**************************************************************************************************
+Purpose: 	Requests an operation mode (C1CON.REQOP) & waits for OPMOD to follow
+				The controller changes mode once the bus is idle (after a frame in progress)
+Inputs:		*ptrChn		- chnCAN pointer
+			mode		- CANMODE_x (defined in qb_mcp251xfd.h)
+
+Outputs:	result		- error code (defined in qb_mcp251xfd.h)
+							ERR_OPMODE = OPMOD did not change within MODEPOLL status reads
+**************************************************************************************************/
+uint8_t mcp251xfd_mode_req(chnCAN *ptrChn,uint8_t mode){
+	uint16_t cnt;
+	uint8_t idx;
+
+	ptrChn->regWr[3] = mode & 0x07;									// TXBWS=ABAT=0;REQOP=mode
+	mcp251xfd_write_register(ADDR_C1CON,ptrChn,3);					// write register data byte 3
+	for(cnt=0;cnt<MODEPOLL;cnt++){									// wait for OPMOD=mode
+		for(idx=0;idx<CSCNT;idx++);									// delay for toggling CS
+		if(mcp251xfd_mode_get(ptrChn) == (mode & 0x07))
+			return 0;
+	}
+	return ERR_OPMODE;												// return error code
+}
+/**************************************************************************************************
+Purpose: 	Switches the operation mode of a channel without re-running mcp251xfd_init()
+				Normal CAN FD, listen only & restricted operation switch directly & keep all FIFO contents.
+				Switches into/out of a loopback mode & between normal CAN FD/CAN 2.0 pass thru configuration
+				mode, which resets the FIFOs (pending msgs lost); bit timing, filters & FIFO setup are kept.
+Inputs:		*ptrChn		- chnCAN pointer
+			mode		- CANMODE_x (defined in qb_mcp251xfd.h)
+
+Outputs:	result		- error code (defined in qb_mcp251xfd.h)
+							ERR_OPMODE = OPMOD did not change within MODEPOLL status reads
+**************************************************************************************************/
+uint8_t mcp251xfd_mode_set(chnCAN *ptrChn,uint8_t mode){
+	uint8_t opMod, result;
+
+	mode &= 0x07;
+	opMod = mcp251xfd_mode_get(ptrChn);
+	if(opMod == mode)												// already in the mode
+		return 0;
+	if((opMod != CANMODE_CONFIG) && (mode != CANMODE_CONFIG) &&
+	   ((opMod == CANMODE_INTLOOP) || (opMod == CANMODE_EXTLOOP) || (mode == CANMODE_INTLOOP) || (mode == CANMODE_EXTLOOP) ||
+	    (opMod == CANMODE_NORMAL20) || (mode == CANMODE_NORMAL20))){	// no direct transition
+		result = mcp251xfd_mode_req(ptrChn,CANMODE_CONFIG);
+		if(result)
+			return result;
+	}
+	return mcp251xfd_mode_req(ptrChn,mode);
+}
+/**************************************************************************************************
+Purpose: 	Changes the nominal & data phase bit rates of a channel without re-running mcp251xfd_init()
+				(passes thru configuration mode, so the FIFOs are reset; filters & FIFO setup are kept)
+Inputs:		*ptrChn		- chnCAN pointer
+			speed		- nominal CAN speed (CANSPEED_125/250/500/1000)
+			dataSpeed	- CAN FD data phase speed (CANDATA_1M/2M/4M; any other value = 2M; 4M runs
+							with automatic transmitter delay compensation, else TDC is off as after init)
+			mode		- operation mode to switch to afterwards (CANMODE_x, e.g. CANMODE_LISTEN)
+
+Outputs:	result		- fault code
+						0  = success
+						51 = configuration mode request timed out
+						52 = C1NBTCFG register write error
+						53 = C1DBTCFG register write error
+						54 = operation mode request timed out
+						55 = C1TDC register write error
+**************************************************************************************************/
+uint8_t mcp251xfd_bitrate_set(chnCAN *ptrChn,uint8_t speed,uint8_t dataSpeed,uint8_t mode){
+	uint8_t idx;
+
+	if(mcp251xfd_mode_req(ptrChn,CANMODE_CONFIG))					// request configuration mode
+		return 51;													// return fault code for this mode request
+
+	// Setup register write packet - C1NBTCFG -------------------------------------------------------------------------------------------------------
+	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
+	mcp251xfd_nbt_prep(ptrChn,speed);								// prepare nominal bit timing
+	mcp251xfd_write_register(ADDR_C1NBTCFG,ptrChn,4);				// write register data bytes
+	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
+	mcp251xfd_read_register(ADDR_C1NBTCFG,ptrChn,4);				// read register data bytes 
+	if(!mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,4))		// data did not write to the MCP2517
+		return 52;													// return fault code for this register write error
+
+	// Setup register write packet - C1DBTCFG -------------------------------------------------------------------------------------------------------
+	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
+	if(dataSpeed == CANDATA_1M)
+		mcp251xfd_reg_prep(ptrChn,1,0x00,0x1E,0x07,0x07);			// B3(BRP=0) B2(TSEG1=30) B1(TSEG2=7) B0(SJW=7)[1MHz]
+	else if(dataSpeed == CANDATA_4M)
+		mcp251xfd_reg_prep(ptrChn,1,0x00,0x06,0x01,0x01);			// B3(BRP=0) B2(TSEG1=6)  B1(TSEG2=1) B0(SJW=1)[4MHz]
+	else
+		mcp251xfd_reg_prep(ptrChn,1,0x00,0x0E,0x03,0x03);			// B3(BRP=0) B2(TSEG1=14) B1(TSEG2=3) B0(SJW=3)[2MHz]
+	mcp251xfd_write_register(ADDR_C1DBTCFG,ptrChn,4);				// write register data bytes
+	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
+	mcp251xfd_read_register(ADDR_C1DBTCFG,ptrChn,4);				// read register data bytes 
+	if(!mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,4))		// data did not write to the MCP2517
+		return 53;													// return fault code for this register write error
+
+	// Setup register write packet - C1TDC ----------------------------------------------------------------------------------------------------------
+	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
+	if(dataSpeed == CANDATA_4M)										// transceiver loop delay is a large part of a 250ns bit
+		mcp251xfd_reg_prep(ptrChn,1,0x00,0x02,0x07,0x00);			// B3(EDGFLTEN=SID11EN=0) B2(TDCMOD=2 auto) B1(TDCO=7=(TSEG1+1)*(BRP+1)) B0(TDCV=0)
+	else
+		mcp251xfd_reg_prep(ptrChn,1,0x00,0x00,0x00,0x00);			// B3(EDGFLTEN=SID11EN=0) B2(TDCMOD=0) B1(TDCO=0) B0(TDCV=0)
+	mcp251xfd_write_register(ADDR_C1TDC,ptrChn,4);					// write register data bytes
+	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
+	mcp251xfd_read_register(ADDR_C1TDC,ptrChn,4);					// read register data bytes 
+	if(!mcp251xfd_reg_compr(&ptrChn->regWr,&ptrChn->regRd,4))		// data did not write to the MCP2517
+		return 55;													// return fault code for this register write error
+
+	if(mcp251xfd_mode_req(ptrChn,mode))								// request operation mode
+		return 54;													// return fault code for this mode request
+	return 0;														// return value for success
 }
 /**************************************************************************************************
 Purpose: 	Returns #of payload bytes to write to MCP2517 memory for a CAN message
@@ -671,21 +1057,9 @@ Outputs:	result	- #of payload bytes in multiples of 4
 						result = 12,16,20,24,32,48,64
 **************************************************************************************************/
 uint8_t mcp251xfd_mem_payload(uint8_t fdf,uint8_t dlc){
-	if(dlc <= 8){	return dlc;								// valid for both CAN2.0 & CAN FD frames
-		if		(dlc == 0) 		return 0;
-		else if	(dlc <= 4) 		return 4;
-		else if	(dlc <= 8) 		return 8;
-	}
-	else if(!fdf)	return 8;								// valid for CAN2.0 frames	
-	else{													// CAN FD frame and DLC > 8
-		if		(dlc == 9) 		return 12;
-		else if	(dlc == 10) 	return 16;
-		else if	(dlc == 11) 	return 20;
-		else if	(dlc == 12) 	return 24;
-		else if	(dlc == 13) 	return 32;
-		else if	(dlc == 14) 	return 48;
-		else if	(dlc == 15) 	return 64;
-	}
+	dlc &= 0x0F;											// DLC field is 4 bits
+	if(!fdf && (dlc > 8))	dlc = 8;						// CAN2.0 frames carry at most 8 bytes
+	return pgm_read_byte(&dlcMem[dlc]);
 }
 /**************************************************************************************************
 Purpose: 	Returns #of payload bytes based on DLC and FDF fields
@@ -701,19 +1075,9 @@ Outputs:	result	- #of payload bytes
 						result = 12-64
 **************************************************************************************************/
 uint8_t mcp251xfd_len_payload(uint8_t fdf,uint8_t dlc){
-    if(dlc <= 8){   return dlc;                             // valid for both CAN2.0 & CAN FD frames
-        return dlc;											// DLC = payload length
-    }
-    else if(!fdf)   return 8;                               // valid for CAN2.0 frames  
-    else{                                                   // CAN FD frame and DLC > 8
-        if      (dlc == 9)      return 12;					// CAN FD standard
-        else if (dlc == 10)     return 16;					// CAN FD standard
-        else if (dlc == 11)     return 20;					// CAN FD standard
-        else if (dlc == 12)     return 24;					// CAN FD standard
-        else if (dlc == 13)     return 32;					// CAN FD standard
-        else if (dlc == 14)     return 48;					// CAN FD standard
-        else if (dlc == 15)     return 64;					// CAN FD standard
-    }
+	dlc &= 0x0F;											// DLC field is 4 bits
+	if(!fdf && (dlc > 8))	dlc = 8;						// CAN2.0 frames carry at most 8 bytes
+	return pgm_read_byte(&dlcLen[dlc]);
 }
 /**************************************************************************************************
 Purpose: 	Returns DLC for a CAN message
@@ -723,18 +1087,15 @@ Inputs:		fdf		- message FDF field
 Outputs:	result	- DLC (0-15)				
 **************************************************************************************************/
 uint8_t mcp251xfd_dlc_payload(uint8_t fdf,uint8_t bufLen){
-	if(bufLen <= 8)	return bufLen;							// valid for both CAN2.0 & CAN FD frames		
-	else if(!fdf)	return 8;								// valid for CAN2.0 frames	
-	else{													// CAN FD frame and payload lengths > 8
-		if		(bufLen <= 12) 	return 9;					// CAN FD encoded
-		else if	(bufLen <= 16) 	return 10;					// CAN FD encoded
-		else if	(bufLen <= 20) 	return 11;					// CAN FD encoded
-		else if	(bufLen <= 24) 	return 12;					// CAN FD encoded
-		else if	(bufLen <= 32) 	return 13;					// CAN FD encoded
-		else if	(bufLen <= 48) 	return 14;					// CAN FD encoded
-		else					return 15;					// CAN FD encoded
-	}
+#if MCP251XFD_CLASSIC_ONLY
+	if(bufLen > 8)			bufLen = 8;						// CAN2.0 frames carry at most 8 bytes
+#else
+	if(bufLen > 64)			bufLen = 64;					// CAN FD frames carry at most 64 bytes
+	if(!fdf && (bufLen > 8))	bufLen = 8;					// CAN2.0 frames carry at most 8 bytes
+#endif
+	return pgm_read_byte(&lenDlc[bufLen]);
 }
+#if !MCP251XFD_COMPACT
 /**************************************************************************************************
 Purpose: 	Calculates CANbus msg ID
 Inputs:		*ptrChn	- chnCAN pointer
@@ -742,33 +1103,62 @@ Inputs:		*ptrChn	- chnCAN pointer
 Outputs:	result	- msg ID
 **************************************************************************************************/
 unsigned long mcp251xfd_id_calc(chnCAN *ptrChn) {
-	unsigned long data, temp;
-	
-	temp = (temp << 3) | ptrChn->msg.sid10_08;
-	data = (temp << 8) | ptrChn->msg.sid07_00;
-	if(ptrChn->msg.ide){
-		temp = ptrChn->msg.eid17_13;
-		temp = (temp << 8) | ptrChn->msg.eid12_05;
-		temp = (temp << 5) | ptrChn->msg.eid04_00;
-		return ((data << 18) | temp);
-	}
-	else{
-		return data;
-	}
-/* 	unsigned long data, temp;								// temporary data storage
-
-	temp = (temp << 3) | ptrChn->msg.sid10_08;				// 11 bit ID (MSB)
-	data = (temp << 8) | ptrChn->msg.sid07_00;				// 11 bit ID (LSB)
-	if(ptrChn->msg.ide){									// dealing with a 29 bit ID
-		temp = ptrChn->msg.eid17_13;						// 29 bit ID (bits 28-24)
-		temp = (temp << 8) | ptrChn->msg.eid12_05;			// 29 bit ID (bits 23-16)
-		temp = (temp << 5) | ptrChn->msg.eid04_00;			// 29 bit ID (bits 15-11)
-		return ((temp << 11) | data);						// assemble & return the 29 bit ID
-	}
-	else{													// dealing with an 11 bit ID
-		return data;										// return the 11 bit ID
-	} */
+	return mcp251xfd_msg_id(&ptrChn->msg);
+}
+#endif
+/**************************************************************************************************
+Purpose: 	Calculates CANbus msg ID of a msgCAN object (e.g. one read by mcp251xfd_read_frame())
+Inputs:		*ptrMsg	- msgCAN pointer
+						
+Outputs:	result	- msg ID
+**************************************************************************************************/
+unsigned long mcp251xfd_msg_id(msgCAN *ptrMsg) {
+	return mcp251xfd_hdr_unpack(&ptrMsg->sid07_00) & CANID_MASK;
+}
+/**************************************************************************************************
+Purpose: 	Packs an ID word into the T0 & T1 words of a message object (canonical header codec)
+				T0 = SID[10:0] | EID[17:0]<<11 (SID11=0). Extended IDs split as SID = ID[28:18];EID = ID[17:0],
+				standard IDs as SID = ID[10:0];EID = 0
+Inputs:		*ptrObj	- pointer to the 1st byte of the message object (T0 byte 0, e.g. &msg.sid07_00)
+			idWord	- ID[28:0] | CANID_EXT for an extended ID
+			t1		- T1 byte 0 (DLC | CANFRAME_FD/BRS/RTR flags; IDE is taken from idWord)
+
+Outputs:	None
+**************************************************************************************************/
+void mcp251xfd_hdr_pack(uint8_t *ptrObj,unsigned long idWord,uint8_t t1){
+	unsigned long mask;												// used to select the extended/standard layout without branching
+	unsigned long t0;												// used to assemble T0
+
+	mask = 0UL - (idWord >> 31);									// all 1s for an extended ID
+	t0 = ((idWord >> 18) & mask) | (idWord & ~mask);				// SID = ID[28:18] or ID[10:0]
+	t0 = (t0 & 0x7FF) | ((idWord & mask & 0x3FFFF) << 11);			// EID = ID[17:0] or 0
+	ptrObj[0] = t0;													// sid07_00
+	ptrObj[1] = t0 >> 8;											// eid04_00,sid10_08
+	ptrObj[2] = t0 >> 16;											// eid12_05
+	ptrObj[3] = t0 >> 24;											// sid11,eid17_13
+	ptrObj[4] = (t1 & ~CANFRAME_EXT) | (CANFRAME_EXT & (uint8_t)mask);	// DLC,IDE,RTR,BRS,FDF
+	ptrObj[5] = 0;													// SEQ
+	ptrObj[6] = 0;
+	ptrObj[7] = 0;
+}
+/**************************************************************************************************
+Purpose: 	Unpacks the T0 & T1 words of a message object into an ID word (inverse of mcp251xfd_hdr_pack())
+Inputs:		*ptrObj	- pointer to the 1st byte of the message object (T0 byte 0, e.g. &msg.sid07_00)
+
+Outputs:	result	- ID[28:0] | CANID_EXT for an extended ID (T1 flags & DLC stay in ptrObj[4])
+**************************************************************************************************/
+unsigned long mcp251xfd_hdr_unpack(const uint8_t *ptrObj){
+	unsigned long mask;												// used to select the extended/standard layout without branching
+	unsigned long t0;												// used to assemble T0
+
+	mask = 0UL - ((ptrObj[4] >> 4) & 1);							// all 1s for an extended ID (IDE)
+	t0 = ptrObj[3];
+	t0 = (t0 << 8) | ptrObj[2];
+	t0 = (t0 << 8) | ptrObj[1];
+	t0 = (t0 << 8) | ptrObj[0];
+	return ((((t0 & 0x7FF) << 18) | ((t0 >> 11) & 0x3FFFF) | CANID_EXT) & mask) | (t0 & 0x7FF & ~mask);
 }
+#if !MCP251XFD_COMPACT
 /**************************************************************************************************
 Purpose: 	Calculates the timestamp of an Rx message from timestamp register bytes
 Inputs:		*ptrChn	- chnCAN pointer
@@ -781,6 +1171,7 @@ void mcp251xfd_tstamp_calc(chnCAN *ptrChn){
 	ptrChn->msg.tStamp = (ptrChn->msg.tStamp << 8) | ptrChn->msg.rxTstamp[1];
 	ptrChn->msg.tStamp = (ptrChn->msg.tStamp << 8) | ptrChn->msg.rxTstamp[0];
 }
+#endif
 /**************************************************************************************************
 Purpose: 	Prepares the regWr & regRd member in the chnCAN object pointed to by ptrChn
 Inputs:		*ptrChn	- chnCAN pointer
@@ -806,3 +1197,201 @@ void mcp251xfd_reg_prep(chnCAN *ptrChn, uint8_t bitRdWr, uint8_t byte3, uint8_t
 		ptrChn->regRd[0] = byte0;
 	}
 }
+/**************************************************************************************************
+Purpose: 	Reads the current value of the time base counter (same clock as RX msg timestamps)
+Inputs:		*ptrChn	- chnCAN pointer
+			
+Outputs:	result	- C1TBC register value (1/40MHz periods)
+**************************************************************************************************/
+unsigned long mcp251xfd_tbc_read(chnCAN *ptrChn){
+	unsigned long tbc;												// temporary data storage
+	uint8_t	regBuf[4];												// C1TBC register bytes
+	
+	mcp251xfd_read_block(ADDR_C1TBC,ptrChn,regBuf,4);				// read in contents of time base counter register
+	tbc = regBuf[3];												// TBC<31:24>
+	tbc = (tbc << 8) | regBuf[2];									// TBC<23:16>
+	tbc = (tbc << 8) | regBuf[1];									// TBC<15:08>
+	tbc = (tbc << 8) | regBuf[0];									// TBC<07:00>
+	return tbc;
+}
+/**************************************************************************************************
+Purpose: 	Resets a statCAN object & synchronizes it to the chnCAN msg counters
+Inputs:		*ptrChn		- chnCAN pointer
+			*ptrStat	- statCAN pointer
+			
+Outputs:	None
+**************************************************************************************************/
+void mcp251xfd_stat_init(chnCAN *ptrChn,statCAN *ptrStat){
+	uint8_t idx;													// used to step thru data buffer
+	uint8_t *ptr_u8;												// used to step thru byte members of statCAN object
+	
+	ptr_u8 = (uint8_t *)ptrStat;									// point to the 1st byte of statCAN object
+	for(idx=0;idx<sizeof(statCAN);idx++){							// loop thru statCAN object
+		*(ptr_u8 + idx) = 0;										// clear statCAN byte
+	}
+	ptrStat->rxCntPrev = ptrChn->rxCnt;								// synchronize to RX msg counter
+	ptrStat->txCntPrev = ptrChn->txCnt;								// synchronize to TX msg counter
+}
+/**************************************************************************************************
+Purpose: 	Samples bus & controller health registers and accumulates them into a statCAN object
+				C1RXOVIF thru C1BDIAG1 are read in a single 24 byte SPI transaction, then C1BDIAG0 & 
+				C1BDIAG1 are cleared in a single 8 byte SPI transaction. Overflow/attempt flags are only
+				cleared (per FIFO) when set, so a healthy bus costs 2 SPI transactions per sample.
+				Errors flagged between the read & the clear of C1BDIAGx are not counted.
+Inputs:		*ptrChn		- chnCAN pointer
+			*ptrStat	- statCAN pointer (reset with mcp251xfd_stat_init() before 1st use)
+			
+Outputs:	result		- current C1TREC error state flags (byte 2: EWARN,RXWARN,TXWARN,RXBP,TXBP,TXBO)
+**************************************************************************************************/
+uint8_t mcp251xfd_stat_sample(chnCAN *ptrChn,statCAN *ptrStat){
+	uint8_t idx;													// used to step thru data buffer
+	uint8_t bit;													// used to step thru flag bits
+	uint8_t	regBuf[24];												// C1RXOVIF,C1TXATIF,C1TXREQ,C1TREC,C1BDIAG0,C1BDIAG1
+	uint8_t	regClr[8] = {0};										// C1BDIAG0,C1BDIAG1 cleared values
+	uint8_t	flg;													// error state flags
+	uint16_t cnt;													// temporary counter storage
+	
+	mcp251xfd_read_block(ADDR_C1RXOVIF,ptrChn,regBuf,24);			// read C1RXOVIF thru C1BDIAG1 in one go
+	for(idx=0;idx<CSCNT;idx++);										// delay for toggling CS
+	mcp251xfd_write_block(ADDR_C1BDIAG0,ptrChn,regClr,8);			// clear C1BDIAG0 & C1BDIAG1
+	
+	// Frame counters -------------------------------------------------------------------------------------------------------------------
+	cnt = ptrChn->rxCnt;											// snapshot RX msg counter
+	ptrStat->rxFrames += (uint16_t)(cnt - ptrStat->rxCntPrev);		// accumulate msgs read since last sample
+	ptrStat->rxCntPrev = cnt;
+	cnt = ptrChn->txCnt;											// snapshot TX msg counter
+	ptrStat->txFrames += (uint16_t)(cnt - ptrStat->txCntPrev);		// accumulate msgs loaded since last sample
+	ptrStat->txCntPrev = cnt;
+	cnt = regBuf[21];												// EFMSGCNT<15:8>
+	cnt = (cnt << 8) | regBuf[20];									// EFMSGCNT<7:0>
+	ptrStat->busFrames += cnt;										// accumulate error free msgs since last clear
+	
+	// RX overflow & TX attempts (1 bit per FIFO, cleared in C1FIFOSTAn) ----------------------------------------------------------------
+	for(idx=0;idx<8;idx++){											// loop thru C1RXOVIF & C1TXATIF bytes
+		if(!regBuf[idx])											// no flags set in this byte
+			continue;
+		for(bit=0;bit<8;bit++){										// loop thru flag bits
+			if(!((regBuf[idx] >> bit) & 1))							// flag not set
+				continue;
+			if(idx < 4){											// C1RXOVIF
+				ptrStat->rxOvflw++;									// count overflow event
+				ptrChn->regWr[0] = ~(1 << FFRXOVIF);				// clear RXOVIF (HS/C)
+			}
+			else{													// C1TXATIF
+				ptrStat->txAtmpt++;									// count attempts exhausted event
+				ptrChn->regWr[0] = ~(1 << FFTXATIF);				// clear TXATIF (HS/C)
+			}
+			for(cnt=0;cnt<CSCNT;cnt++);								// delay for toggling CS
+			mcp251xfd_write_register(C1FIFOSTA((8*(idx & 3) + bit)),ptrChn,0);	// write register data byte 0 (FIFO0=TXQ)
+		}
+	}
+	
+	// Error counters & state -----------------------------------------------------------------------------------------------------------
+	ptrStat->rec = regBuf[12];										// REC
+	ptrStat->tec = regBuf[13];										// TEC
+	flg = regBuf[14];												// EWARN,RXWARN,TXWARN,RXBP,TXBP,TXBO
+	if((flg & ((1<<RXBP)|(1<<TXBP))) && !(ptrStat->trecFlg & ((1<<RXBP)|(1<<TXBP))))
+		ptrStat->errPasv++;											// entered error passive
+	if(((flg >> TXBO) & 1) && !((ptrStat->trecFlg >> TXBO) & 1))
+		ptrStat->busOff++;											// entered bus off
+	else if((regBuf[22] >> TXBOERR) & 1)							// went bus off & recovered between samples
+		ptrStat->busOff++;
+	ptrStat->trecFlg = flg;											// save error state for next sample
+	
+	ptrStat->rxErr += regBuf[16];									// NRERRCNT
+	ptrStat->txErr += regBuf[17];									// NTERRCNT
+	ptrStat->rxErr += regBuf[18];									// DRERRCNT
+	ptrStat->txErr += regBuf[19];									// DTERRCNT
+	
+	if(((regBuf[22] | regBuf[23]) >> NBIT0ERR) & 1 || ((regBuf[22] | regBuf[23]) >> NBIT1ERR) & 1)
+		ptrStat->bitErr++;											// bit 0/1 error (nominal or data phase)
+	if(((regBuf[22] | regBuf[23]) >> NSTUFERR) & 1)
+		ptrStat->stufErr++;											// stuff error (nominal or data phase)
+	if(((regBuf[22] | regBuf[23]) >> NCRCERR) & 1)
+		ptrStat->crcErr++;											// CRC error (nominal or data phase)
+	if(((regBuf[22] | regBuf[23]) >> NFORMERR) & 1)
+		ptrStat->formErr++;											// form error (nominal or data phase)
+	if((regBuf[22] >> NACKERR) & 1)
+		ptrStat->ackErr++;											// ACK error (nominal phase only)
+	
+	return flg;
+}
+#if MCP251XFD_PROF
+profOp 		mcp251xfd_prof[PROF_OPS];								// per call statistics
+uint16_t 	mcp251xfd_profRun[PROF_CYC];							// running counters of the call in progress
+
+/**************************************************************************************************
+Purpose: 	Starts Timer1 free running at Fosc/MCP251XFD_PROF_DIV & resets the instrumentation statistics
+Inputs:		None
+Outputs:	None
+**************************************************************************************************/
+void mcp251xfd_prof_init(void){
+#ifndef MCP251XFD_HOST
+	TCCR1A = 0;														// normal mode (no PWM)
+#if   MCP251XFD_PROF_DIV == 8
+	TCCR1B = (1<<CS11);												// Fosc/8
+#elif MCP251XFD_PROF_DIV == 64
+	TCCR1B = (1<<CS11)|(1<<CS10);									// Fosc/64
+#elif MCP251XFD_PROF_DIV == 256
+	TCCR1B = (1<<CS12);												// Fosc/256
+#elif MCP251XFD_PROF_DIV == 1024
+	TCCR1B = (1<<CS12)|(1<<CS10);									// Fosc/1024
+#else
+	TCCR1B = (1<<CS10);												// Fosc/1
+#endif
+#endif
+	mcp251xfd_prof_reset();
+}
+/**************************************************************************************************
+Purpose: 	Resets the instrumentation statistics
+Inputs:		None
+Outputs:	None
+**************************************************************************************************/
+void mcp251xfd_prof_reset(void){
+	uint8_t op, idx;												// used to step thru statistics
+
+	for(op=0;op<PROF_OPS;op++){										// loop thru profiled calls
+		mcp251xfd_prof[op].calls = 0;
+		for(idx=0;idx<PROF_METRICS;idx++){							// loop thru metrics
+			mcp251xfd_prof[op].sum[idx] = 0;
+			mcp251xfd_prof[op].min[idx] = 0xFFFF;
+			mcp251xfd_prof[op].max[idx] = 0;
+		}
+	}
+}
+/**************************************************************************************************
+Purpose: 	Marks the start of a profiled call (called thru PROF_BEGIN())
+Inputs:		None
+Outputs:	result	- Timer1 count at start of call
+**************************************************************************************************/
+uint16_t mcp251xfd_prof_begin(void){
+	mcp251xfd_profRun[PROF_BYTES] = 0;								// reset running counters
+	mcp251xfd_profRun[PROF_CS] = 0;
+	mcp251xfd_profRun[PROF_RDREG] = 0;
+	return PROF_TCNT;
+}
+/**************************************************************************************************
+Purpose: 	Marks the end of a profiled call & folds its counters into the call statistics (called thru PROF_RETURN())
+Inputs:		op	- profiled call (PROF_RDMEM,PROF_WRMEM,PROF_TXSTART,PROF_FLTR,PROF_INIT)
+			t0	- Timer1 count at start of call
+Outputs:	None
+**************************************************************************************************/
+void mcp251xfd_prof_end(uint8_t op,uint16_t t0){
+	uint8_t idx;													// used to step thru metrics
+	uint16_t val[PROF_METRICS];										// metric values of this call
+
+	val[PROF_CYC] = (uint16_t)(PROF_TCNT - t0);						// Timer1 ticks spent in call
+	val[PROF_BYTES] = mcp251xfd_profRun[PROF_BYTES];
+	val[PROF_CS] = mcp251xfd_profRun[PROF_CS];
+	val[PROF_RDREG] = mcp251xfd_profRun[PROF_RDREG];
+
+	mcp251xfd_prof[op].calls++;
+	for(idx=0;idx<PROF_METRICS;idx++){								// loop thru metrics
+		mcp251xfd_prof[op].sum[idx] += val[idx];
+		if(val[idx] < mcp251xfd_prof[op].min[idx])
+			mcp251xfd_prof[op].min[idx] = val[idx];
+		if(val[idx] > mcp251xfd_prof[op].max[idx])
+			mcp251xfd_prof[op].max[idx] = val[idx];
+	}
+}
+#endif
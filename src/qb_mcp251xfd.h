@@ -33,6 +33,17 @@ Algorithm error codes
 #define ERR_FIFOEMPTY	5				// Error Code = FIFO is empty
 
 #define ERR_NRXFIFO		6				// Error Code = FIFO not configured as RX FIFO
+#define ERR_DISPFULL	7				// Error Code = dispatch table is full (qb_candisp)
+#define ERR_DISPMASKS	8				// Error Code = dispatch table has more than DISPMASKS distinct masks (qb_candisp)
+#define ERR_DECFULL		9				// Error Code = decimation rule table is full (qb_candec)
+#define ERR_GWFULL		10				// Error Code = gateway routing table is full (qb_cangw)
+#define ERR_CYCFULL		11				// Error Code = cyclic TX msg table is full (qb_cancyc)
+#define ERR_TXABORT		12				// Error Code = TX FIFO abort/reset did not complete (qb_canupd)
+#define ERR_OPMODE		13				// Error Code = operation mode request timed out
+#define ERR_OBD2FULL	14				// Error Code = OBD2 request table is full (qb_obd2cli)
+#define ERR_OBD2PID		15				// Error Code = OBD2 request PID count/length not supported (qb_obd2cli)
+#define ERR_MBOXSIZE	16				// Error Code = mailbox table has no slots (qb_canmbox)
+#define ERR_DECBUF		17				// Error Code = DECCHANGE rule without a payload buffer (qb_candec)
 
 /**************************************************************************************************
 Algorithm variables 
@@ -43,9 +54,40 @@ Algorithm variables
 #define BRS     		1				// BRS bit
 #define RTR     		1				// RTR bit
 
+#define CANID_EXT		0x80000000UL	// ID word flag - extended (29 bit) ID (mcp251xfd_hdr_pack/unpack())
+#define CANID_MASK		0x1FFFFFFFUL	// ID word - ID bits
+#define CANFRAME_STD	0x00			// T1 flags - CAN 2.0 frame with standard (11 bit) ID
+#define CANFRAME_EXT	0x10			// T1 flags - extended (29 bit) ID (IDE bit)
+#define CANFRAME_RTR	0x20			// T1 flags - remote frame (RTR bit, CAN 2.0 only)
+#define CANFRAME_BRS	0x40			// T1 flags - CAN FD frame with bit rate switch (BRS bit)
+#define CANFRAME_FD		0x80			// T1 flags - CAN FD frame (FDF bit)
+
 #define CANSPEED_125 	7				// CAN speed at 125 kbps
 #define CANSPEED_250  	3				// CAN speed at 250 kbps
 #define CANSPEED_500	1				// CAN speed at 500 kbps
+#define CANSPEED_1000	0				// CAN speed at 1 Mbps
+#define CANDATA_1M		1				// CAN FD data phase speed at 1 Mbps (mcp251xfd_bitrate_set())
+#define CANDATA_2M		2				// CAN FD data phase speed at 2 Mbps (set by mcp251xfd_init())
+#define CANDATA_4M		4				// CAN FD data phase speed at 4 Mbps (mcp251xfd_bitrate_set(), auto TDC)
+#define CANFD_DBPS		2000000UL		// CAN FD data phase bit rate set by mcp251xfd_init() (C1DBTCFG)
+#define MCP251XFD_TBCLK	40000000UL		// time base counter clock (SYSCLK=40MHz;TBCPRE=0) used for timestamps
+
+#define CANMODE_NORMALFD	0			// operation mode - normal CAN FD (set by mcp251xfd_init())
+#define CANMODE_SLEEP		1			// operation mode - sleep
+#define CANMODE_INTLOOP		2			// operation mode - internal loopback (TX not on the bus)
+#define CANMODE_LISTEN		3			// operation mode - listen only (no ACK, no error frames)
+#define CANMODE_CONFIG		4			// operation mode - configuration
+#define CANMODE_EXTLOOP		5			// operation mode - external loopback (TX on the bus, own msgs received)
+#define CANMODE_NORMAL20	6			// operation mode - normal CAN 2.0 (FD frames cause errors)
+#define CANMODE_RESTRICT	7			// operation mode - restricted operation (receive & ACK only)
+#define MODEPOLL			1000		// max C1CON reads waiting for OPMOD (~10ms)
+
+// DLC/payload length codec as constant expressions (compile time; run time uses mcp251xfd_len/mem/dlc_payload())
+#define CANFD_DLC_LEN(dlc)	((dlc) <= 8 ? (dlc) : (dlc) == 9 ? 12 : (dlc) == 10 ? 16 : (dlc) == 11 ? 20 : \
+							 (dlc) == 12 ? 24 : (dlc) == 13 ? 32 : (dlc) == 14 ? 48 : 64)		// CAN FD DLC -> #of payload bytes
+#define CANFD_LEN_DLC(len)	((len) <= 8 ? (len) : (len) <= 12 ? 9 : (len) <= 16 ? 10 : (len) <= 20 ? 11 : \
+							 (len) <= 24 ? 12 : (len) <= 32 ? 13 : (len) <= 48 ? 14 : 15)		// #of payload bytes -> CAN FD DLC (rounded up)
+#define CANFD_MEM_LEN(len)	((((len) + 3) >> 2) << 2)	// #of payload bytes -> msg object payload bytes (multiple of 4)
 
 #define FLTRBOTH		0				// input for mcp2517_fltr_setup() to apply filter to both extended (29 bit) & standard (11 bit) CAN FD/CAN 2.0 frames
 #define FLTRSID			1				// input for mcp2517_fltr_setup() to apply filter to only standard (11 bit) CAN FD/CAN 2.0 frames
@@ -108,58 +150,115 @@ Algorithm variables
 #define FIFO30			30
 #define FIFO31			31
 
+/**************************************************************************************************
+Build profile (change the values here to shrink SRAM use; do not #define them in a sketch - Arduino
+  compiles the library files without the sketch's defines, so sketch & library would disagree on the
+  msgCAN/chnCAN layout. Builds passing -D to every file, e.g. extras/host, may override them)
+  SRAM per object on AVR:	msgCAN = 17 + MCP251XFD_MAXPAYLOAD bytes (81 default, 25 classic only)
+							chnCAN = 13 bytes compact, else 13 + msgCAN (94 default, 38 classic only)
+  (checked per profile by extras/host footprint; flash per profile with the footprint_avr target)
+  Classic only also stages CAN 2.0 frames only (frame_prep/msg_write clear FDF/BRS) & drops the
+  CAN FD part of the length -> DLC table; CAN FD frames received are still decoded (payload truncated).
+**************************************************************************************************/
+#ifndef MCP251XFD_CLASSIC_ONLY
+#define MCP251XFD_CLASSIC_ONLY	0				// 1 = CAN 2.0 only build (msgCAN payload buffers sized for 8 bytes, CAN 2.0 TX frames)
+#endif
+#ifndef MCP251XFD_MAXPAYLOAD
+#if MCP251XFD_CLASSIC_ONLY
+#define MCP251XFD_MAXPAYLOAD	8
+#else
+#define MCP251XFD_MAXPAYLOAD	64				// msgCAN payload buffer size (8,12,16,20,24,32,48,64); longer RX payloads are truncated
+#endif
+#endif
+#ifndef MCP251XFD_COMPACT
+#define MCP251XFD_COMPACT		0				// 1 = chnCAN without msg member (use *_frame() sub-routines with caller owned msgCAN)
+#endif
+
+#if (MCP251XFD_MAXPAYLOAD != 8) && (MCP251XFD_MAXPAYLOAD != 12) && (MCP251XFD_MAXPAYLOAD != 16) && (MCP251XFD_MAXPAYLOAD != 20) && \
+	(MCP251XFD_MAXPAYLOAD != 24) && (MCP251XFD_MAXPAYLOAD != 32) && (MCP251XFD_MAXPAYLOAD != 48) && (MCP251XFD_MAXPAYLOAD != 64)
+#error "MCP251XFD_MAXPAYLOAD must be a CAN FD payload length (8,12,16,20,24,32,48,64)"
+#endif
+
+typedef struct{
+	// R0/T0 ------------------------
+	uint8_t sid07_00;
+	
+	uint8_t sid10_08 		: 3;
+	uint8_t eid04_00 		: 5;
+	
+	uint8_t eid12_05;
+	
+	uint8_t eid17_13 		: 5;
+	uint8_t sid11 			: 1;
+	uint8_t 	 			: 2;
+	
+	// R1/T1 ------------------------
+	uint8_t dlc 			: 4;
+	uint8_t ide 			: 1;
+	uint8_t rtr 			: 1;
+	uint8_t brs 			: 1;
+	uint8_t fdf 			: 1;
+	
+	union {
+		struct{
+			uint8_t esi 	: 1;
+			uint8_t seq 	: 7;
+		};
+		struct{
+			uint8_t 		: 3;
+			uint8_t filhit 	: 5;
+		};
+	};
+	
+	uint8_t :8;
+	uint8_t :8;
+	
+	// R2/T2 ------------------------
+	union{
+		uint8_t txData[MCP251XFD_MAXPAYLOAD];
+		struct{
+			uint8_t rxTstamp[4];
+			uint8_t rxData[MCP251XFD_MAXPAYLOAD];
+		};
+		uint8_t txTstamp[4];
+	};
+	unsigned long tStamp;
+	uint8_t pLen;
+} msgCAN;
+
 typedef struct{
 	uint8_t chnNum;
 	uint8_t regWr[4];
 	uint8_t regRd[4];
-	struct {
-		// R0/T0 ------------------------
-		uint8_t sid07_00;
-		
-		uint8_t sid10_08 		: 3;
-		uint8_t eid04_00 		: 5;
-		
-		uint8_t eid12_05;
-		
-		uint8_t eid17_13 		: 5;
-		uint8_t sid11 			: 1;
-		uint8_t 	 			: 2;
-		
-		// R1/T1 ------------------------
-		uint8_t dlc 			: 4;
-		uint8_t ide 			: 1;
-		uint8_t rtr 			: 1;
-		uint8_t brs 			: 1;
-		uint8_t fdf 			: 1;
-		
-		union {
-			struct{
-				uint8_t esi 	: 1;
-				uint8_t seq 	: 7;
-			};
-			struct{
-				uint8_t 		: 3;
-				uint8_t filhit 	: 5;
-			};
-		};
-		
-		uint8_t :8;
- 		uint8_t :8;
-		
-		// R2/T2 ------------------------
-		union{
-			uint8_t txData[64];
-			struct{
-				uint8_t rxTstamp[4];
-				uint8_t rxData[64];
-			};
-			uint8_t txTstamp[4];
-		};
-		unsigned long tStamp;
-		uint8_t pLen;
-	} msg;
+	uint16_t rxCnt;													// #of msgs read from RX FIFOs (free running, folded by mcp251xfd_stat_sample())
+	uint16_t txCnt;													// #of msgs loaded into TXQ/TX FIFOs (free running, folded by mcp251xfd_stat_sample())
+#if !MCP251XFD_COMPACT
+	msgCAN msg;
+#endif
 } chnCAN;
 
+typedef struct{
+	unsigned long rxFrames;											// #of msgs read from RX FIFOs
+	unsigned long txFrames;											// #of msgs loaded into TXQ/TX FIFOs
+	unsigned long busFrames;										// #of error free msgs seen on the bus (C1BDIAG1 EFMSGCNT)
+	unsigned long rxOvflw;											// #of RX FIFO overflow events (C1RXOVIF)
+	unsigned long txAtmpt;											// #of TX attempts exhausted events (C1TXATIF)
+	unsigned long rxErr;											// #of RX errors (C1BDIAG0 NRERRCNT + DRERRCNT)
+	unsigned long txErr;											// #of TX errors (C1BDIAG0 NTERRCNT + DTERRCNT)
+	uint16_t errPasv;												// #of transitions into error passive (C1TREC TXBP/RXBP)
+	uint16_t busOff;												// #of transitions into bus off (C1TREC TXBO or C1BDIAG1 TXBOERR)
+	uint16_t bitErr;												// #of samples with a bit error flagged (C1BDIAG1 xBIT0ERR/xBIT1ERR)
+	uint16_t stufErr;												// #of samples with a stuff error flagged (C1BDIAG1 xSTUFERR)
+	uint16_t crcErr;												// #of samples with a CRC error flagged (C1BDIAG1 xCRCERR)
+	uint16_t formErr;												// #of samples with a form error flagged (C1BDIAG1 xFORMERR)
+	uint16_t ackErr;												// #of samples with an ACK error flagged (C1BDIAG1 NACKERR)
+	uint8_t tec;													// TX error counter at last sample (C1TREC TEC)
+	uint8_t rec;													// RX error counter at last sample (C1TREC REC)
+	uint8_t trecFlg;												// error state flags at last sample (C1TREC byte 2)
+	uint16_t rxCntPrev;												// chnCAN rxCnt at last sample
+	uint16_t txCntPrev;												// chnCAN txCnt at last sample
+} statCAN;
+
 uint8_t 		spi_putChr(uint8_t data);
 uint8_t 		spi_putCmd(uint8_t cmd,uint16_t addr );
 
@@ -167,26 +266,48 @@ void 			mcp251xfd_cs_clr(uint8_t chnNum);
 void 			mcp251xfd_cs_set(uint8_t chnNum);
 void 			mcp251xfd_read_register(uint16_t addr,chnCAN *ptrChn,uint8_t dataNum);
 void 			mcp251xfd_write_register(uint16_t addr,chnCAN *ptrChn,uint8_t dataNum);
+void 			mcp251xfd_read_block(uint16_t addr,chnCAN *ptrChn,uint8_t *ptrBuf_u8,uint8_t len);
+void 			mcp251xfd_write_block(uint16_t addr,chnCAN *ptrChn,uint8_t *ptrBuf_u8,uint8_t len);
 
+#if !MCP251XFD_COMPACT
 uint8_t 		mcp251xfd_read_memory(uint8_t bufIdx,chnCAN *ptrChn);
 uint8_t 		mcp251xfd_write_memory(uint8_t bufIdx,chnCAN *ptrChn);
+void 			mcp251xfd_msg_write(chnCAN *ptrChn,unsigned long id,uint8_t ide,uint8_t fdf,uint8_t brs,uint8_t rtr,uint8_t bufLen,uint8_t *buf_u8);
+unsigned long 	mcp251xfd_id_calc(chnCAN *ptrChn);
+void 			mcp251xfd_tstamp_calc(chnCAN *ptrChn);
+#endif
+uint8_t 		mcp251xfd_read_frame(uint8_t bufIdx,chnCAN *ptrChn,msgCAN *ptrMsg);
+uint8_t 		mcp251xfd_write_frame(uint8_t bufIdx,chnCAN *ptrChn,msgCAN *ptrMsg);
+uint8_t 		mcp251xfd_write_object(uint8_t bufIdx,chnCAN *ptrChn,const uint8_t *ptrObj,uint8_t len);
+uint8_t 		mcp251xfd_write_parts(uint8_t bufIdx,chnCAN *ptrChn,const uint8_t *ptrHdr,const uint8_t *ptrBuf,uint8_t len);
 uint8_t 		mcp251xfd_check_message(chnCAN *ptrChn);
 uint8_t 		mcp251xfd_start_transmit(uint8_t bufIdx,chnCAN *ptrChn);
-void 			mcp251xfd_msg_write(chnCAN *ptrChn,unsigned long id,uint8_t ide,uint8_t fdf,uint8_t brs,uint8_t rtr,uint8_t bufLen,uint8_t *buf_u8);
+void 			mcp251xfd_frame_prep(msgCAN *ptrMsg,unsigned long id,uint8_t ide,uint8_t fdf,uint8_t brs,uint8_t rtr,uint8_t bufLen,uint8_t *buf_u8);
 
 void 			mcp251xfd_init_hardware(uint8_t chnNum);
 uint8_t 		mcp251xfd_init(uint8_t speed,chnCAN *ptrChn,uint8_t chnNum,uint8_t bufIdxTx,uint8_t bufIdxRx);
 uint8_t 		mcp251xfd_reg_compr(uint8_t *ptrBuf0,uint8_t *ptrBuf1,uint8_t dataNum);
 uint8_t 		mcp251xfd_fltr_setup(chnCAN *ptrChn,uint8_t bufIdx,uint8_t fltrNum,uint8_t fltrIdx,uint8_t fltrType,unsigned long msgId,unsigned long mskId);
+uint8_t 		mcp251xfd_txfifo_setup(chnCAN *ptrChn,uint8_t bufIdx,uint8_t txPri,uint8_t rtrEn);
+uint8_t 		mcp251xfd_txfifo_depth(chnCAN *ptrChn,uint8_t bufIdx,uint8_t txPri,uint8_t rtrEn,uint8_t depth);
+uint8_t 		mcp251xfd_mode_get(chnCAN *ptrChn);
+uint8_t 		mcp251xfd_mode_req(chnCAN *ptrChn,uint8_t mode);
+uint8_t 		mcp251xfd_mode_set(chnCAN *ptrChn,uint8_t mode);
+uint8_t 		mcp251xfd_bitrate_set(chnCAN *ptrChn,uint8_t speed,uint8_t dataSpeed,uint8_t mode);
 
 
 uint8_t 		mcp251xfd_mem_payload(uint8_t fdf,uint8_t dlc);
 uint8_t 		mcp251xfd_len_payload(uint8_t fdf,uint8_t dlc);
 uint8_t 		mcp251xfd_dlc_payload(uint8_t fdf,uint8_t bufLen);
-unsigned long 	mcp251xfd_id_calc(chnCAN *ptrChn);
-void 			mcp251xfd_tstamp_calc(chnCAN *ptrChn);
+unsigned long 	mcp251xfd_msg_id(msgCAN *ptrMsg);
+void 			mcp251xfd_hdr_pack(uint8_t *ptrObj,unsigned long idWord,uint8_t t1);
+unsigned long 	mcp251xfd_hdr_unpack(const uint8_t *ptrObj);
 void 			mcp251xfd_reg_prep(chnCAN *ptrChn, uint8_t bitRdWr, uint8_t byte3, uint8_t byte2, uint8_t byte1, uint8_t byte0);
 
+unsigned long 	mcp251xfd_tbc_read(chnCAN *ptrChn);
+void 			mcp251xfd_stat_init(chnCAN *ptrChn,statCAN *ptrStat);
+uint8_t 		mcp251xfd_stat_sample(chnCAN *ptrChn,statCAN *ptrStat);
+
 #ifdef __cplusplus
 }
 #endif
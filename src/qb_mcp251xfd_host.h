@@ -0,0 +1,41 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#ifndef	QB_MCP251XFD_HOST_H
+#define	QB_MCP251XFD_HOST_H
+
+#include <inttypes.h>
+#ifdef __cplusplus
+
+extern "C"
+{
+
+#endif
+
+/**************************************************************************************************
+Host transport shim (compile qb_mcp251xfd.c with MCP251XFD_HOST defined)
+  Replaces the AVR SPI, chip select, interrupt pin & Timer1 accesses with the hooks below so the
+  driver can run off-target against a simulated MCP2517FD (extras/host/sim_mcp251xfd.c). The hooks are
+  supplied by the host program; with MCP251XFD_PROF=1 the profiled calls report SPI bytes, CS
+  assertions & register reads per call exactly as they do on target, with cycles taken from
+  mcp251xfd_host_cycles().
+**************************************************************************************************/
+uint8_t 		mcp251xfd_host_xfer(uint8_t data);					// clock 1 byte out & return the byte clocked in
+void 			mcp251xfd_host_cs(uint8_t chnNum,uint8_t level);	// drive chip select of chnNum (0=low/enabled;1=high)
+uint8_t 		mcp251xfd_host_int(uint8_t chnNum);					// level of INT pin of chnNum (0=active)
+uint16_t 		mcp251xfd_host_cycles(void);						// free running cycle counter (replaces TCNT1)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// QB_MCP251XFD_HOST_H
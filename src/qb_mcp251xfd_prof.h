@@ -0,0 +1,82 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+#ifndef	QB_MCP251XFD_PROF_H
+#define	QB_MCP251XFD_PROF_H
+
+#include <inttypes.h>
+#ifdef __cplusplus
+
+extern "C"
+{
+
+#endif
+
+/**************************************************************************************************
+Hot path instrumentation (change MCP251XFD_PROF to 1 to enable, 0 compiles all hooks to nothing)
+  Counts SPI bytes clocked, CS assertions, register reads & CPU cycles per profiled API call.
+  Cycles are taken from Timer1 running free at Fosc/MCP251XFD_PROF_DIV (setup by mcp251xfd_prof_init(),
+  which takes Timer1 away from analogWrite() on its PWM pins). A profiled call must complete within
+  65535 Timer1 ticks. Profiled calls must not be made from an ISR while another is in progress.
+**************************************************************************************************/
+#ifndef MCP251XFD_PROF
+#define MCP251XFD_PROF		0				// 1 = instrumentation enabled
+#endif
+#define MCP251XFD_PROF_DIV	1				// Timer1 prescaler (1,8,64,256,1024); use 64 to profile mcp251xfd_init()
+
+#define PROF_RDMEM			0				// profiled call - mcp251xfd_read_frame() (incl. mcp251xfd_read_memory())
+#define PROF_WRMEM			1				// profiled call - mcp251xfd_write_parts() (incl. write_memory/frame/object)
+#define PROF_TXSTART		2				// profiled call - mcp251xfd_start_transmit()
+#define PROF_FLTR			3				// profiled call - mcp251xfd_fltr_setup()
+#define PROF_INIT			4				// profiled call - mcp251xfd_init()
+#define PROF_OPS			5				// #of profiled calls
+
+#define PROF_BYTES			0				// metric - SPI bytes clocked
+#define PROF_CS				1				// metric - CS assertions
+#define PROF_RDREG			2				// metric - register reads (status reads & write readbacks)
+#define PROF_CYC			3				// metric - CPU cycles
+#define PROF_METRICS		4				// #of metrics
+
+typedef struct{
+	unsigned long calls;											// #of calls profiled
+	unsigned long sum[PROF_METRICS];								// metric totals (mean = sum/calls)
+	uint16_t min[PROF_METRICS];										// metric minimum per call
+	uint16_t max[PROF_METRICS];										// metric maximum per call
+} profOp;
+
+#if MCP251XFD_PROF
+extern profOp 		mcp251xfd_prof[PROF_OPS];
+extern uint16_t 	mcp251xfd_profRun[PROF_CYC];
+
+void 			mcp251xfd_prof_init(void);
+void 			mcp251xfd_prof_reset(void);
+uint16_t 		mcp251xfd_prof_begin(void);
+void 			mcp251xfd_prof_end(uint8_t op,uint16_t t0);
+
+#define PROF_SPI(n)				mcp251xfd_profRun[PROF_BYTES] += (n)
+#define PROF_CSCLR()			mcp251xfd_profRun[PROF_CS]++
+#define PROF_REGRD()			mcp251xfd_profRun[PROF_RDREG]++
+#define PROF_BEGIN()			uint16_t profT0 = mcp251xfd_prof_begin()
+#define PROF_RETURN(op,val)		do{ mcp251xfd_prof_end((op),profT0); return (val); }while(0)
+#else
+#define PROF_SPI(n)
+#define PROF_CSCLR()
+#define PROF_REGRD()
+#define PROF_BEGIN()
+#define PROF_RETURN(op,val)		return (val)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// QB_MCP251XFD_PROF_H
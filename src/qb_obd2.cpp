@@ -11,7 +11,190 @@
   All text above must be included in any redistribution
  ****************************************************/
 
+#include <avr/pgmspace.h>
 #include "qb_obd2.h"
+
+#define OBD2WORD		0x08			// descriptor flag - 16 bit value (data bytes ofs,ofs+1)
+#define OBD2SIGNED		0x10			// descriptor flag - 16 bit value is 2's complement
+#define OBD2MORE		0x20			// descriptor flag - next descriptor is the next value of the PID
+#define OBD2_D(ofs,flg,unit,dec,mul,div,off)	{(uint8_t)((ofs) | (flg)),(uint8_t)((unit) | ((dec) << 5)),(mul),(div),(off)}
+
+typedef struct{
+	uint8_t ofsFlg;													// data byte offset (0=A..4=E) | OBD2x flags
+	uint8_t unitDec;												// OBD2U_x unit | #of decimals << 5
+	int16_t mul;													// scale numerator
+	uint16_t div;													// scale denominator
+	int16_t rawOff;													// offset added to the raw value before scaling
+} obd2Desc;
+
+// Value descriptors (SAE J1979 service 0x01 formulas)
+static const obd2Desc obd2DescTbl[] PROGMEM = {
+	OBD2_D(0,0,OBD2U_PCT,1,1000,255,0),								//  0 - A*100/255 %
+	OBD2_D(0,0,OBD2U_DEGC,0,1,1,-40),								//  1 - A-40 C
+	OBD2_D(0,0,OBD2U_PCT,1,1000,128,-128),							//  2 - A*100/128-100 %
+	OBD2_D(0,0,OBD2U_KPA,0,3,1,0),									//  3 - A*3 kPa
+	OBD2_D(0,0,OBD2U_KPA,0,1,1,0),									//  4 - A kPa
+	OBD2_D(0,OBD2WORD,OBD2U_RPM,2,25,1,0),							//  5 - (256A+B)/4 rpm
+	OBD2_D(0,0,OBD2U_KMH,0,1,1,0),									//  6 - A km/h
+	OBD2_D(0,0,OBD2U_DEG,1,5,1,-128),								//  7 - A/2-64 deg
+	OBD2_D(0,OBD2WORD,OBD2U_GS,2,1,1,0),							//  8 - (256A+B)/100 g/s
+	OBD2_D(0,OBD2MORE,OBD2U_V,3,5,1,0),								//  9 - A/200 V
+	OBD2_D(1,0,OBD2U_PCT,1,1000,128,-128),							// 10 - B*100/128-100 %
+	OBD2_D(0,OBD2WORD,OBD2U_S,0,1,1,0),								// 11 - 256A+B s
+	OBD2_D(0,OBD2WORD,OBD2U_KM,0,1,1,0),							// 12 - 256A+B km
+	OBD2_D(0,OBD2WORD,OBD2U_KPA,3,79,1,0),							// 13 - (256A+B)*0.079 kPa
+	OBD2_D(0,OBD2WORD,OBD2U_KPA,0,10,1,0),							// 14 - (256A+B)*10 kPa
+	OBD2_D(0,OBD2WORD | OBD2MORE,OBD2U_RATIO,4,625,2048,0),			// 15 - (256A+B)*2/65536 ratio
+	OBD2_D(2,OBD2WORD,OBD2U_V,3,125,1024,0),						// 16 - (256C+D)*8/65536 V
+	OBD2_D(0,0,OBD2U_CNT,0,1,1,0),									// 17 - A count
+	OBD2_D(0,OBD2WORD | OBD2SIGNED,OBD2U_PA,2,25,1,0),				// 18 - (signed 256A+B)/4 Pa
+	OBD2_D(0,OBD2WORD | OBD2MORE,OBD2U_RATIO,4,625,2048,0),			// 19 - (256A+B)*2/65536 ratio
+	OBD2_D(2,OBD2WORD,OBD2U_MA,3,125,32,-32768),					// 20 - (256C+D)/256-128 mA
+	OBD2_D(0,OBD2WORD,OBD2U_DEGC,1,1,1,-400),						// 21 - (256A+B)/10-40 C
+	OBD2_D(0,OBD2WORD,OBD2U_V,3,1,1,0),								// 22 - (256A+B)/1000 V
+	OBD2_D(0,OBD2WORD,OBD2U_PCT,1,1000,255,0),						// 23 - (256A+B)*100/255 %
+	OBD2_D(0,OBD2WORD,OBD2U_RATIO,4,625,2048,0),					// 24 - (256A+B)*2/65536 ratio
+	OBD2_D(0,OBD2WORD,OBD2U_MIN,0,1,1,0),							// 25 - 256A+B min
+	OBD2_D(0,OBD2MORE,OBD2U_RATIO,0,1,1,0),							// 26 - A ratio
+	OBD2_D(1,OBD2MORE,OBD2U_V,0,1,1,0),								// 27 - B V
+	OBD2_D(2,OBD2MORE,OBD2U_MA,0,1,1,0),							// 28 - C mA
+	OBD2_D(3,0,OBD2U_KPA,0,10,1,0),									// 29 - D*10 kPa
+	OBD2_D(0,0,OBD2U_GS,0,10,1,0),									// 30 - A*10 g/s
+	OBD2_D(0,OBD2WORD,OBD2U_KPA,3,5,1,0),							// 31 - (256A+B)/200 kPa
+	OBD2_D(0,OBD2WORD | OBD2SIGNED,OBD2U_PA,0,1,1,0),				// 32 - signed 256A+B Pa
+	OBD2_D(0,OBD2MORE,OBD2U_PCT,1,1000,128,-128),					// 33 - A*100/128-100 %
+	OBD2_D(1,0,OBD2U_PCT,1,1000,128,-128),							// 34 - B*100/128-100 %
+	OBD2_D(0,OBD2WORD,OBD2U_DEG,2,25,32,-26880),					// 35 - (256A+B)/128-210 deg
+	OBD2_D(0,OBD2WORD,OBD2U_LH,2,5,1,0),							// 36 - (256A+B)/20 L/h
+	OBD2_D(0,0,OBD2U_PCT,0,1,1,-125),								// 37 - A-125 %
+	OBD2_D(0,OBD2WORD,OBD2U_NM,0,1,1,0),							// 38 - 256A+B Nm
+	OBD2_D(0,OBD2MORE,OBD2U_PCT,0,1,1,-125),						// 39 - A-125 %
+	OBD2_D(1,OBD2MORE,OBD2U_PCT,0,1,1,-125),						// 40 - B-125 %
+	OBD2_D(2,OBD2MORE,OBD2U_PCT,0,1,1,-125),						// 41 - C-125 %
+	OBD2_D(3,OBD2MORE,OBD2U_PCT,0,1,1,-125),						// 42 - D-125 %
+	OBD2_D(4,0,OBD2U_PCT,0,1,1,-125)								// 43 - E-125 %
+};
+
+// PID -> 1st descriptor index (NP = PID not decoded), #of data bytes (SAE J1979; 0 = not known)
+#define NP				0xFF
+#define OBD2MAXPID		0x8F
+static const uint8_t obd2PidMap[OBD2MAXPID + 1][2] PROGMEM = {
+	{NP, 4},{NP, 4},{NP, 2},{NP, 2},{ 0, 1},{ 1, 1},{ 2, 1},{ 2, 1},		// PID 0x00-0x07
+	{ 2, 1},{ 2, 1},{ 3, 1},{ 4, 1},{ 5, 2},{ 6, 1},{ 7, 1},{ 1, 1},		// PID 0x08-0x0F
+	{ 8, 2},{ 0, 1},{NP, 1},{NP, 1},{ 9, 2},{ 9, 2},{ 9, 2},{ 9, 2},		// PID 0x10-0x17
+	{ 9, 2},{ 9, 2},{ 9, 2},{ 9, 2},{NP, 1},{NP, 1},{NP, 1},{11, 2},		// PID 0x18-0x1F
+	{NP, 4},{12, 2},{13, 2},{14, 2},{15, 4},{15, 4},{15, 4},{15, 4},		// PID 0x20-0x27
+	{15, 4},{15, 4},{15, 4},{15, 4},{ 0, 1},{ 2, 1},{ 0, 1},{ 0, 1},		// PID 0x28-0x2F
+	{17, 1},{12, 2},{18, 2},{ 4, 1},{19, 4},{19, 4},{19, 4},{19, 4},		// PID 0x30-0x37
+	{19, 4},{19, 4},{19, 4},{19, 4},{21, 2},{21, 2},{21, 2},{21, 2},		// PID 0x38-0x3F
+	{NP, 4},{NP, 4},{22, 2},{23, 2},{24, 2},{ 0, 1},{ 1, 1},{ 0, 1},		// PID 0x40-0x47
+	{ 0, 1},{ 0, 1},{ 0, 1},{ 0, 1},{ 0, 1},{25, 2},{25, 2},{26, 4},		// PID 0x48-0x4F
+	{30, 4},{NP, 1},{ 0, 1},{31, 2},{32, 2},{33, 2},{33, 2},{33, 2},		// PID 0x50-0x57
+	{33, 2},{14, 2},{ 0, 1},{ 0, 1},{ 1, 1},{35, 2},{36, 2},{NP, 1},		// PID 0x58-0x5F
+	{NP, 4},{37, 1},{37, 1},{38, 2},{39, 5},{NP, 2},{NP, 5},{NP, 3},		// PID 0x60-0x67
+	{NP, 0},{NP, 0},{NP, 0},{NP, 0},{NP, 0},{NP, 0},{NP, 0},{NP, 0},		// PID 0x68-0x6F
+	{NP, 0},{NP, 0},{NP, 0},{NP, 0},{NP, 0},{NP, 0},{NP, 0},{NP, 0},		// PID 0x70-0x77
+	{NP, 0},{NP, 0},{NP, 0},{NP, 0},{NP, 0},{NP, 0},{NP, 0},{NP, 0},		// PID 0x78-0x7F
+	{NP, 4},{NP, 0},{NP, 0},{NP, 0},{NP, 0},{NP, 0},{NP, 0},{NP, 0},		// PID 0x80-0x87
+	{NP, 0},{NP, 0},{NP, 0},{NP, 0},{NP, 0},{NP, 0},{37, 1},{NP, 0},		// PID 0x88-0x8F
+};
+#undef NP
+
+// Unit strings (OBD2U_x order)
+#define OBD2ULEN		9				// max unit string length + null
+static const char obd2UnitTbl[][OBD2ULEN] PROGMEM = {
+	""," %"," C"," kPa"," Pa"," rpm"," km/h"," degrees"," grams/s",
+	" V"," seconds"," km"," mA"," ratio"," minutes"," L/h"," Nm"," count"
+};
+static const long obd2Pow10[5] = {1,10,100,1000,10000};
+
+/**************************************************************************************************
+Purpose: 	Decodes a service 0x01 PID response into fixed point values (no serial writes)
+Inputs:		*ptrBuf_u8	- service 0x01 PID response data packet (e.g. msgCAN rxData member)
+						  ptrBuf_u8[0] - #of additional bytes
+						  ptrBuf_u8[1] - service 0x01 + 0x40
+						  ptrBuf_u8[2] - service 0x01 PID
+						  ptrBuf_u8[3] - ptrBuf_u8[7] - service 0x01 data bytes A - E
+			*ptrVal		- obd2Val pointer to store the values
+
+Outputs:	result		- #of values decoded (0 = not a service 0x01 response or PID not supported)
+**************************************************************************************************/
+uint8_t obd2s1PidDecode(const uint8_t *ptrBuf_u8,obd2Val *ptrVal){
+	const obd2Desc *ptrDesc;
+	const uint8_t *ptrData = &ptrBuf_u8[3];							// data byte A
+	uint8_t idx, ofsFlg, unitDec;
+	long raw;
+
+	ptrVal->pid = ptrBuf_u8[2];
+	ptrVal->cnt = 0;
+	if((ptrBuf_u8[1] != 0x41) || (ptrVal->pid > OBD2MAXPID))		// not a service 0x01 response or PID unknown
+		return 0;
+	idx = pgm_read_byte(&obd2PidMap[ptrVal->pid][0]);
+	if(idx == 0xFF)													// PID not supported
+		return 0;
+
+	ptrDesc = &obd2DescTbl[idx];
+	do{
+		ofsFlg = pgm_read_byte(&ptrDesc->ofsFlg);
+		unitDec = pgm_read_byte(&ptrDesc->unitDec);
+		raw = ptrData[ofsFlg & 0x07];
+		if(ofsFlg & OBD2WORD){										// 16 bit value
+			raw = (raw << 8) | ptrData[(ofsFlg & 0x07) + 1];
+			if(ofsFlg & OBD2SIGNED)
+				raw = (int16_t)raw;
+		}
+		raw += (int16_t)pgm_read_word(&ptrDesc->rawOff);
+		raw *= (int16_t)pgm_read_word(&ptrDesc->mul);
+		ptrVal->val[ptrVal->cnt] = raw / (long)pgm_read_word(&ptrDesc->div);
+		ptrVal->unit[ptrVal->cnt] = unitDec & 0x1F;
+		ptrVal->dec[ptrVal->cnt] = unitDec >> 5;
+		ptrVal->cnt++;
+		ptrDesc++;
+	}while((ofsFlg & OBD2MORE) && (ptrVal->cnt < OBD2MAXVAL));
+	return ptrVal->cnt;
+}
+/**************************************************************************************************
+Purpose: 	Returns the #of data bytes of a service 0x01 PID (splits multi PID responses)
+Inputs:		pid			- service 0x01 PID
+
+Outputs:	result		- #of data bytes (0 = length not known, e.g. PID 0x68-0x8F except bitmaps & 0x8E)
+**************************************************************************************************/
+uint8_t obd2s1PidLen(uint8_t pid){
+	if(pid > OBD2MAXPID)
+		return (pid & 0x1F) ? 0 : 4;								// supported PIDs bitmap (0xA0,0xC0,0xE0) = 4
+	return pgm_read_byte(&obd2PidMap[pid][1]);
+}
+/**************************************************************************************************
+Purpose: 	Writes decoded PID values with their units to the Arduino serial port (e.g. "12.5 %, 3.2 V")
+Inputs:		*ptrVal		- obd2Val pointer (filled by obd2s1PidDecode())
+
+Outputs:	serial writes
+**************************************************************************************************/
+void obd2s1PidPrint(const obd2Val *ptrVal){
+	uint8_t idx, dec;
+	long val, frac, scale;
+
+	for(idx=0;idx<ptrVal->cnt;idx++){
+		if(idx){Serial.print(", ");}
+		val = ptrVal->val[idx];
+		dec = ptrVal->dec[idx];
+		if(val < 0){
+			Serial.print("-");
+			val = -val;
+		}
+		scale = obd2Pow10[dec];
+		Serial.print(val / scale);
+		if(dec){													// fractional digits with leading zeros
+			Serial.print(".");
+			frac = val % scale;
+			for(scale/=10;(scale > 1) && (frac < scale);scale/=10){
+				Serial.print("0");
+			}
+			Serial.print(frac);
+		}
+		Serial.print((const __FlashStringHelper *)obd2UnitTbl[ptrVal->unit[idx]]);
+	}
+}
 /**************************************************************************************************
 Purpose: 	Performs OBD2 service 0x01 PID data algorithms & writes to the Arduino serial port
 Inputs:		*ptrBuf_u8	- intended as pointer to the chnCan struct rxData member that has 
@@ -28,16 +211,8 @@ Inputs:		*ptrBuf_u8	- intended as pointer to the chnCan struct rxData member tha
 Outputs:	serial writes
 **************************************************************************************************/	
 void obd2s1PidDecrypt(uint8_t *ptrBuf_u8){	
-	uint8_t j, pid_u8, A, B, C, D, E;
-	char pCent2[3] = " %";
-	char pCent4[5] = " %, ";
-	
-	pid_u8 = ptrBuf_u8[2];
-	A 	   = ptrBuf_u8[3];
-	B 	   = ptrBuf_u8[4];
-	C 	   = ptrBuf_u8[5];
-	D 	   = ptrBuf_u8[6];
-	E 	   = ptrBuf_u8[7];
+	uint8_t j;
+	obd2Val val;
 	
 	Serial.print("Data [");
 	for(j=0;j<8;j++){
@@ -47,192 +222,7 @@ void obd2s1PidDecrypt(uint8_t *ptrBuf_u8){
 	}
 	Serial.print("] ");
 	
-	if(pid_u8 == 0x04){
-		Serial.print(A/255 * 100); 
-	}
-	else if(pid_u8 == 0x05){
-		Serial.print(A - 40); 
-	}	
-	else if(pid_u8 >= 0x06 && pid_u8 <= 0x09){
-		Serial.print(A/1.28 - 100); 
-	}
-	else if(pid_u8 == 0x0A){
-		Serial.print(A * 3); 
-	}
-	else if(pid_u8 == 0x0B){
-		Serial.print(A); 
-	}
-	else if(pid_u8 == 0x0C){
-		Serial.print(A * 64 + 0.25 * B); Serial.print(" rpm");
-	}
-	else if(pid_u8 == 0x0D){
-		Serial.print(A); Serial.print(" km/h");
-	}
-	else if(pid_u8 == 0x0E){
-		Serial.print(A>>2 - 64); Serial.print(" degrees before TDC");
-	}
-	else if(pid_u8 == 0x0F){
-		Serial.print(A - 40); 
-	}
-	else if(pid_u8 == 0x10){
-		Serial.print((256*A + B)/100); Serial.print(" grams/s");
-	}
-	else if(pid_u8 == 0x11){
-		Serial.print(A/255 * 100); 
-	}
-	else if(pid_u8 >= 0x14 && pid_u8 <= 0x1B){
-		if(B != 0xFF){
-		  Serial.print(A/200); Serial.print(" V, ");
-		  Serial.print(B*100/128 - 100); Serial.print(pCent2);
-		}
-	}
-	else if(pid_u8 == 0x1F){
-		Serial.print(A*256 + B); Serial.print(" seconds");
-	}
-	else if(pid_u8 == 0x21){
-		Serial.print(A*256 + B); Serial.print(" km");
-	}
-	else if(pid_u8 == 0x22){
-		Serial.print(0.079*(A*256 + B)); 
-	}
-	else if(pid_u8 == 0x23){
-		Serial.print(10*(A*256 + B)); 
-	}
-	else if(pid_u8 >= 0x24 && pid_u8 <= 0x2B){
-		Serial.print(2/65536*(A*256 + B)); Serial.print(" ratio, ");
-		Serial.print(2/65536*(C*256 + D)); Serial.print(" V");
-	}
-	else if(pid_u8 == 0x2C){
-		Serial.print(A/255 * 100); 
-	}
-	else if(pid_u8 == 0x2D){
-		Serial.print(A/128 * 100 - 100); 
-	}
-	else if(pid_u8 == 0x2E){
-		Serial.print(A/255 * 100); 
-	}
-	else if(pid_u8 == 0x2F){
-		Serial.print(A/255 * 100); 
-	}
-	else if(pid_u8 == 0x30){
-		Serial.print(A); Serial.print(" count");
-	}
-	else if(pid_u8 == 0x31){
-		Serial.print(A*256 + B); Serial.print(" km");
-	}
-	else if(pid_u8 == 0x32){
-		Serial.print(0.25*(A*256 + B)); Serial.print(" Pa");
-	}
-	else if(pid_u8 == 0x33){
-		Serial.print(A); 
-	}
-	else if(pid_u8 >= 0x34 && pid_u8 <= 0x3B){
-		Serial.print(2/65536*(A*256 + B)); Serial.print(" ratio, ");
-		Serial.print(1/65536*(C*256 + D)-128); Serial.print(" mA");
-	}
-	else if(pid_u8 >= 0x3C && pid_u8 <= 0x3F){
-		Serial.print(1/10*(A*256 + B)-40); 
-	}
-	else if(pid_u8 == 0x42){
-		Serial.print(1/1000*(A*256 + B)); Serial.print(" V");
-	}
-	else if(pid_u8 == 0x43){
-		Serial.print(100/256*(A*256 + B)); 
-	}
-	else if(pid_u8 >= 0x44 && pid_u8 <= 0x3B){
-		Serial.print(2/65536*(A*256 + B)); Serial.print(" ratio, ");
-	}
-	else if(pid_u8 == 0x45){
-		Serial.print(A/255 * 100); 
-	}
-	else if(pid_u8 == 0x46){
-		Serial.print(A - 40); 
-	}
-	else if(pid_u8 >= 0x47 && pid_u8 <= 0x4C){
-		Serial.print(A/255 * 100); 
-	}
-	else if(pid_u8 >= 0x4D && pid_u8 <= 0x4E){
-		Serial.print(A*256 + B); Serial.print(" minutes");
-	}
-	else if(pid_u8 == 0x4F){
-		Serial.print(A); Serial.print(" ratio, ");
-		Serial.print(B); Serial.print(" V, ");
-		Serial.print(C); Serial.print(" mA, ");
-		Serial.print(D*10); Serial.print(" kPa");
-	}
-	else if(pid_u8 == 0x50){
-		Serial.print(A*10); Serial.print(" g/s");
-	}
-	else if(pid_u8 == 0x52){
-		Serial.print(A/255 * 100); 
-	}
-	else if(pid_u8 == 0x53){
-		Serial.print(1/200*(A*256 + B)); 
-	}
-	else if(pid_u8 == 0x54){
-		Serial.print((A*256 + B)-32767); 
-	}
-	else if(pid_u8 >= 0x55 && pid_u8 <= 0x58){
-		Serial.print(A*100/128 - 100); Serial.print(pCent4);
-		Serial.print(B*100/128 - 100); Serial.print(pCent2);
-	}
-	else if(pid_u8 == 0x59){
-		Serial.print(10*(A*256 + B)); 
-	}
-	else if(pid_u8 >= 0x5A && pid_u8 <= 0x5B){
-		Serial.print(A/255 * 100); 
-	}
-	else if(pid_u8 == 0x5C){
-		Serial.print(A - 40); 
-	}
-	else if(pid_u8 == 0x5D){
-		Serial.print(1/128*(A*256 + B)-210); Serial.print(" degree");
-	}
-	else if(pid_u8 == 0x5E){
-		Serial.print(1/20*(A*256 + B)); Serial.print(" L/h");
-	}
-	else if(pid_u8 >= 0x61 && pid_u8 <= 0x62){
-		Serial.print(A-125); 
-	}
-	else if(pid_u8 == 0x63){
-		Serial.print((A*256 + B)); Serial.print(" Nm");
-	}
-	else if(pid_u8 == 0x64){
-		Serial.print(A-125); Serial.print(pCent4);
-		Serial.print(B-125); Serial.print(pCent4);
-		Serial.print(C-125); Serial.print(pCent4);
-		Serial.print(D-125); Serial.print(pCent4);
-		Serial.print(E-125); Serial.print(pCent2);
-	}
-	else if(pid_u8 == 0x8E){
-		Serial.print(A-125); 
-	}
-
-	if  (pid_u8 == 0x04 || (pid_u8 >= 0x06 && pid_u8 <= 0x09) || pid_u8 == 0x11 || 
-		(pid_u8 >= 0x2C && pid_u8 <= 0x2F) || pid_u8 == 0x43 || pid_u8 == 0x45 || 
-		 pid_u8 == 0x47 || pid_u8 == 0x52 || (pid_u8 >= 0x5A && pid_u8 <= 0x5B) ||
-		(pid_u8 >= 0x61 && pid_u8 <= 0x62) || pid_u8 == 0x8E)
-		Serial.print(pCent2);
-
-	else if  (pid_u8 == 0x05 || pid_u8 == 0x0F || (pid_u8 >= 0x3C && pid_u8 <= 0x3F) || 
-			  pid_u8 == 0x46 || pid_u8 == 0x5C)
-		Serial.print(" C");
-		
-	else if  ((pid_u8 >= 0x0A && pid_u8 <= 0x0B) || (pid_u8 >= 0x22 && pid_u8 <= 0x23) || 
-			  pid_u8 == 0x33 || (pid_u8 >= 0x53 && pid_u8 <= 0x54) || pid_u8 == 0x59)
-		Serial.print(" kPa");	
-
-	
+	if(obd2s1PidDecode(ptrBuf_u8,&val))
+		obd2s1PidPrint(&val);
 	Serial.println();
 }
-
-
-
-
-
-
-
-
-
-
-
@@ -20,6 +20,47 @@
 #include <Wprogram.h> // Arduino 0022
 #endif
 
+/**************************************************************************************************
+Algorithm variables 
+  Service 0x01 PIDs are decoded thru 2 flash tables: a PID -> (descriptor index, #of data bytes) map
+  & descriptors of (data byte, 8/16 bit, signed, scale, offset, unit, decimals) per value, so each PID
+  costs 1 map lookup & integer math per value. The #of data bytes is the full SAE J1979 length (e.g.
+  4 for PID 0x50 of which only A is decoded), so multi PID responses split at the right byte. Values
+  are fixed point: val = (raw + rawOff) * mul / div in units of 10^-dec (e.g. val = 12345, dec = 2 ->
+  123.45).
+**************************************************************************************************/
+#define OBD2MAXVAL		5				// max #of values per PID
+
+#define OBD2U_NONE		0				// unit - none
+#define OBD2U_PCT		1				// unit - %
+#define OBD2U_DEGC		2				// unit - degrees C
+#define OBD2U_KPA		3				// unit - kPa
+#define OBD2U_PA		4				// unit - Pa
+#define OBD2U_RPM		5				// unit - rpm
+#define OBD2U_KMH		6				// unit - km/h
+#define OBD2U_DEG		7				// unit - degrees (crank angle)
+#define OBD2U_GS		8				// unit - grams/s
+#define OBD2U_V			9				// unit - V
+#define OBD2U_S			10				// unit - seconds
+#define OBD2U_KM		11				// unit - km
+#define OBD2U_MA		12				// unit - mA
+#define OBD2U_RATIO		13				// unit - ratio (lambda)
+#define OBD2U_MIN		14				// unit - minutes
+#define OBD2U_LH		15				// unit - L/h
+#define OBD2U_NM		16				// unit - Nm
+#define OBD2U_CNT		17				// unit - count
+
+typedef struct{
+	uint8_t pid;													// service 0x01 PID
+	uint8_t cnt;													// #of values decoded (0 = PID not supported)
+	long val[OBD2MAXVAL];											// fixed point values
+	uint8_t dec[OBD2MAXVAL];										// #of decimals of each value
+	uint8_t unit[OBD2MAXVAL];										// OBD2U_x unit of each value
+} obd2Val;
+
+uint8_t obd2s1PidLen(uint8_t pid);
+uint8_t obd2s1PidDecode(const uint8_t *ptrBuf_u8,obd2Val *ptrVal);
+void obd2s1PidPrint(const obd2Val *ptrVal);
 void obd2s1PidDecrypt(uint8_t *ptrBuf_u8);
 
 #endif
@@ -0,0 +1,414 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+
+#include "qb_obd2cli.h"
+
+static const uint8_t obd2DiscPid[OBD2MAXPIDS] = {0x00,0x20,0x40,0x60,0x80,0xA0};	// supported PIDs bitmap pages
+
+/**************************************************************************************************
+Purpose: 	Initializes an obd2Cli object with caller owned request table storage
+Inputs:		*ptrCli		- obd2Cli pointer
+			*ptrChn		- chnCAN pointer
+			txBuf		- TXQ or TX FIFO for requests & flow control frames
+			rxBuf		- RX FIFO receiving the responses
+			*ptrTbl		- obd2Req array
+			size		- #of entries in *ptrTbl
+
+Outputs:	None
+**************************************************************************************************/
+void obd2cli_init(obd2Cli *ptrCli,chnCAN *ptrChn,uint8_t txBuf,uint8_t rxBuf,obd2Req *ptrTbl,uint8_t size){
+	ptrCli->ptrChn = ptrChn;
+	ptrCli->txBuf = txBuf;
+	ptrCli->rxBuf = rxBuf;
+	ptrCli->cnt = 0;
+	ptrCli->size = size;
+	ptrCli->ptrTbl = ptrTbl;
+	ptrCli->sent = 0;
+	ptrCli->done = 0;
+	ptrCli->neg = 0;
+	ptrCli->tmo = 0;
+	ptrCli->disc = 0;
+}
+/**************************************************************************************************
+Purpose: 	Adds a service 0x01 request (idle until obd2cli_send()); requests are indexed in the order added
+Inputs:		*ptrCli		- obd2Cli pointer
+			ecuId		- physical request ID (0x7E0-0x7E7 -> response 0x7E8-0x7EF, or 0x18DAxxF1 |
+						  CANID_EXT -> response 0x18DAF1xx)
+			*ptrPid		- PIDs to request
+			cnt			- #of PIDs (1 to OBD2MAXPIDS; with > 1 PID each must be known to obd2s1PidLen())
+			timeout		- response timeout in ms (0 = OBD2TIMEOUT)
+
+Outputs:	result		- error code (defined in qb_mcp251xfd.h)
+							ERR_OBD2FULL = request table is full
+							ERR_OBD2PID  = PID count/length not supported
+**************************************************************************************************/
+uint8_t obd2cli_add(obd2Cli *ptrCli,unsigned long ecuId,const uint8_t *ptrPid,uint8_t cnt,uint16_t timeout){
+	obd2Req *ptrReq;
+	uint8_t idx;
+
+	if(ptrCli->cnt >= ptrCli->size)
+		return ERR_OBD2FULL;
+	if(!cnt || (cnt > OBD2MAXPIDS))
+		return ERR_OBD2PID;
+	for(idx=0;(cnt > 1) && (idx<cnt);idx++){						// multi PID responses are split by PID length
+		if(!obd2s1PidLen(ptrPid[idx]))
+			return ERR_OBD2PID;
+	}
+
+	ptrReq = &ptrCli->ptrTbl[ptrCli->cnt++];
+	ptrReq->txId = ecuId;
+	if(ecuId & CANID_EXT)											// 29 bit - swap target & source addresses
+		ptrReq->rxId = (ecuId & 0xFFFF0000UL) | ((ecuId & 0xFF) << 8) | ((ecuId >> 8) & 0xFF);
+	else
+		ptrReq->rxId = ecuId + 8;
+	for(idx=0;idx<cnt;idx++){
+		ptrReq->pid[idx] = ptrPid[idx];
+	}
+	ptrReq->pidCnt = cnt;
+	ptrReq->state = OBD2IDLE;
+	ptrReq->timeout = timeout ? timeout : OBD2TIMEOUT;
+	ptrReq->len = 0;
+	ptrReq->got = 0;
+	ptrReq->tRsp = 0;
+	return 0;
+}
+/**************************************************************************************************
+Purpose: 	Queues a request to be sent by the next obd2cli_poll() (re-arms a finished request)
+Inputs:		*ptrCli		- obd2Cli pointer
+			idx			- request index
+
+Outputs:	None
+**************************************************************************************************/
+void obd2cli_send(obd2Cli *ptrCli,uint8_t idx){
+	if(idx < ptrCli->cnt)
+		ptrCli->ptrTbl[idx].state = OBD2QUEUED;
+}
+/**************************************************************************************************
+Purpose: 	Writes a classic 8 byte frame to the client TX buffer (no transmit request)
+Inputs:		*ptrCli		- obd2Cli pointer
+			idWord		- ID word
+			*ptrData	- 8 data bytes
+
+Outputs:	result		- error code (refer to mcp251xfd_write_parts())
+**************************************************************************************************/
+static uint8_t obd2cli_tx(obd2Cli *ptrCli,unsigned long idWord,const uint8_t *ptrData){
+	uint8_t hdr[8];
+
+	mcp251xfd_hdr_pack(hdr,idWord,8);								// DLC 8, classic
+	return mcp251xfd_write_parts(ptrCli->txBuf,ptrCli->ptrChn,hdr,ptrData,8);
+}
+/**************************************************************************************************
+Purpose: 	Checks for a request in flight to an ECU (ECUs handle 1 request at a time)
+Inputs:		*ptrCli		- obd2Cli pointer
+			txId		- request ID
+
+Outputs:	result		- 1 = request in flight; else 0
+**************************************************************************************************/
+static uint8_t obd2cli_busy(obd2Cli *ptrCli,unsigned long txId){
+	uint8_t idx;
+
+	for(idx=0;idx<ptrCli->cnt;idx++){
+		if((ptrCli->ptrTbl[idx].txId == txId) && (ptrCli->ptrTbl[idx].state >= OBD2WAIT) && (ptrCli->ptrTbl[idx].state <= OBD2CF))
+			return 1;
+	}
+	return 0;
+}
+/**************************************************************************************************
+Purpose: 	Appends response bytes of a frame to a request
+Inputs:		*ptrReq		- obd2Req pointer
+			*ptrData	- response bytes
+			len			- #of response bytes
+
+Outputs:	None
+**************************************************************************************************/
+static void obd2cli_store(obd2Req *ptrReq,const uint8_t *ptrData,uint8_t len){
+	uint8_t idx;
+
+	for(idx=0;(idx<len) && (ptrReq->got < ptrReq->len);idx++){
+		if(ptrReq->got < OBD2RSPLEN)								// longer responses are truncated
+			ptrReq->rsp[ptrReq->got] = ptrData[idx];
+		ptrReq->got++;
+	}
+}
+/**************************************************************************************************
+Purpose: 	Processes a response frame (ISO 15765-2 single, first & consecutive frames)
+Inputs:		*ptrCli		- obd2Cli pointer
+			*ptrReq		- obd2Req pointer of the response ID
+			*ptrData	- 8 data bytes of the frame
+			tNow		- current time in ms
+
+Outputs:	result		- 1 = request finished; else 0
+**************************************************************************************************/
+static uint8_t obd2cli_rx(obd2Cli *ptrCli,obd2Req *ptrReq,const uint8_t *ptrData,unsigned long tNow){
+	uint8_t pci = ptrData[0] >> 4;									// protocol control info
+
+	if((pci == 0) && (ptrReq->state == OBD2WAIT)){					// single frame
+		ptrReq->len = ptrData[0] & 0x0F;
+		if(!ptrReq->len || (ptrReq->len > 7))
+			return 0;
+		if((ptrData[1] != 0x41) && (ptrData[1] != 0x7F))			// not a service 0x01 response
+			return 0;
+		ptrReq->got = 0;
+		obd2cli_store(ptrReq,&ptrData[1],ptrReq->len);
+		if(ptrData[1] == 0x7F){										// negative response
+			ptrReq->state = OBD2NEG;
+			ptrCli->neg++;
+		}
+		else{
+			ptrReq->state = OBD2DONE;
+			ptrCli->done++;
+		}
+	}
+	else if((pci == 1) && (ptrReq->state == OBD2WAIT)){				// first frame
+		if((ptrData[0] & 0x0F) || (ptrData[1] < 8) || (ptrData[2] != 0x41))	// not a service 0x01 response
+			return 0;
+		ptrReq->len = ptrData[1];
+		ptrReq->got = 0;
+		obd2cli_store(ptrReq,&ptrData[2],6);
+		ptrReq->sn = 1;
+		ptrReq->state = OBD2FC;										// flow control sent by obd2cli_poll()
+		return 0;
+	}
+	else if((pci == 2) && (ptrReq->state == OBD2CF)){				// consecutive frame
+		if((ptrData[0] & 0x0F) != ptrReq->sn){						// frame lost
+			ptrReq->state = OBD2TMO;
+			ptrCli->tmo++;
+			return 1;
+		}
+		ptrReq->sn = (ptrReq->sn + 1) & 0x0F;
+		obd2cli_store(ptrReq,&ptrData[1],7);
+		if(ptrReq->got < ptrReq->len)
+			return 0;
+		ptrReq->state = OBD2DONE;
+		ptrCli->done++;
+	}
+	else
+		return 0;
+	ptrReq->tRsp = tNow - ptrReq->t0;
+	return 1;
+}
+/**************************************************************************************************
+Purpose: 	Adds a request for an ECU answering the functional request & processes its 1st frame; an
+				ECU found by an earlier discovery reuses its request (bitmaps refreshed), an ECU with a
+				request from obd2cli_add() is left to that request
+Inputs:		*ptrCli		- obd2Cli pointer
+			idWord		- response ID
+			*ptrData	- 8 data bytes of the frame
+			tNow		- current time in ms
+
+Outputs:	result		- 1 = request finished; else 0 (not an OBD2 response ID, ECU known or table full)
+**************************************************************************************************/
+static uint8_t obd2cli_found(obd2Cli *ptrCli,unsigned long idWord,const uint8_t *ptrData,unsigned long tNow){
+	obd2Req *ptrReq;
+	unsigned long txId;
+	uint8_t idx, pos;
+
+	if((ptrCli->disc & OBD2DISC11) && (idWord >= 0x7E8) && (idWord <= 0x7EF))
+		txId = idWord - 8;
+	else if((ptrCli->disc & OBD2DISC29) && ((idWord & 0xFFFFFF00UL) == (0x18DAF100UL | CANID_EXT)))
+		txId = (idWord & 0xFFFF0000UL) | ((idWord & 0xFF) << 8) | 0xF1;
+	else
+		return 0;
+	for(idx=0;idx<ptrCli->cnt;idx++){								// request of the response ID (not in flight)
+		if(ptrCli->ptrTbl[idx].rxId == idWord)
+			break;
+	}
+	if(idx == ptrCli->cnt){											// new ECU
+		if(obd2cli_add(ptrCli,txId,obd2DiscPid,OBD2MAXPIDS,ptrCli->discWin))
+			return 0;
+	}
+	ptrReq = &ptrCli->ptrTbl[idx];
+	for(pos=0;pos<OBD2MAXPIDS;pos++){								// not a bitmaps request - keep the caller's request
+		if((ptrReq->pidCnt != OBD2MAXPIDS) || (ptrReq->pid[pos] != obd2DiscPid[pos]))
+			return 0;
+	}
+	ptrReq->timeout = ptrCli->discWin;
+	ptrReq->state = OBD2WAIT;										// in flight since the functional request
+	ptrReq->t0 = ptrCli->discT0;
+	return obd2cli_rx(ptrCli,ptrReq,ptrData,tNow);
+}
+/**************************************************************************************************
+Purpose: 	Runs the client: drains the RX FIFO, sends flow control & queued requests, times out requests
+Inputs:		*ptrCli		- obd2Cli pointer
+			tNow		- current time in ms (e.g. millis())
+
+Outputs:	result		- #of requests finished (OBD2DONE/OBD2NEG/OBD2TMO) in this call
+**************************************************************************************************/
+uint8_t obd2cli_poll(obd2Cli *ptrCli,unsigned long tNow){
+	msgCAN msg;
+	obd2Req *ptrReq;
+	unsigned long idWord;
+	uint8_t idx, pos, fin = 0, txCnt = 0;
+	uint8_t data[8];
+
+	while(!mcp251xfd_read_frame(ptrCli->rxBuf,ptrCli->ptrChn,&msg)){	// drain RX FIFO
+		if(msg.fdf || msg.rtr || (msg.dlc < 2))
+			continue;
+		idWord = mcp251xfd_hdr_unpack(&msg.sid07_00);
+		for(idx=0;idx<ptrCli->cnt;idx++){							// request of the response ID
+			ptrReq = &ptrCli->ptrTbl[idx];
+			if((ptrReq->rxId == idWord) && (ptrReq->state >= OBD2WAIT) && (ptrReq->state <= OBD2CF)){
+				fin += obd2cli_rx(ptrCli,ptrReq,msg.rxData,tNow);
+				break;
+			}
+		}
+		if((idx == ptrCli->cnt) && ptrCli->disc)					// new ECU answering the functional request
+			fin += obd2cli_found(ptrCli,idWord,msg.rxData,tNow);
+	}
+	if(ptrCli->disc && ((tNow - ptrCli->discT0) > ptrCli->discWin))	// discovery window over
+		ptrCli->disc = 0;
+
+	for(idx=0;idx<ptrCli->cnt;idx++){								// loop thru requests
+		ptrReq = &ptrCli->ptrTbl[idx];
+		if((ptrReq->state >= OBD2WAIT) && (ptrReq->state <= OBD2CF) && ((tNow - ptrReq->t0) > ptrReq->timeout)){
+			ptrReq->state = OBD2TMO;
+			ptrCli->tmo++;
+			fin++;
+		}
+		else if(ptrReq->state == OBD2FC){							// flow control - send all, no separation time
+			for(pos=0;pos<8;pos++){
+				data[pos] = 0;
+			}
+			data[0] = 0x30;
+			if(!obd2cli_tx(ptrCli,ptrReq->txId,data)){
+				ptrReq->state = OBD2CF;
+				txCnt++;
+			}
+		}
+		else if((ptrReq->state == OBD2QUEUED) && !obd2cli_busy(ptrCli,ptrReq->txId)){
+			data[0] = ptrReq->pidCnt + 1;							// #of additional bytes
+			data[1] = 0x01;											// service code
+			for(pos=0;pos<6;pos++){									// PIDs, zero padded
+				data[pos + 2] = (pos < ptrReq->pidCnt) ? ptrReq->pid[pos] : 0;
+			}
+			if(!obd2cli_tx(ptrCli,ptrReq->txId,data)){
+				ptrReq->state = OBD2WAIT;
+				ptrReq->t0 = tNow;
+				ptrCli->sent++;
+				txCnt++;
+			}
+		}
+	}
+	if(txCnt)
+		mcp251xfd_start_transmit(ptrCli->txBuf,ptrCli->ptrChn);
+	return fin;
+}
+/**************************************************************************************************
+Purpose: 	Looks up the data bytes of a PID in a completed response
+Inputs:		*ptrReq		- obd2Req pointer (state OBD2DONE)
+			pid			- service 0x01 PID
+			*ptrLen		- #of data bytes (written on success)
+
+Outputs:	result		- pointer to the data bytes (A,B,..); 0 if the PID is not in the response
+**************************************************************************************************/
+const uint8_t *obd2cli_data(const obd2Req *ptrReq,uint8_t pid,uint8_t *ptrLen){
+	uint8_t idx = 1, len, end;
+
+	if(ptrReq->state != OBD2DONE)
+		return 0;
+	end = (ptrReq->len < OBD2RSPLEN) ? ptrReq->len : OBD2RSPLEN;
+	while(idx < end){												// loop thru PID,data.. records
+		len = obd2s1PidLen(ptrReq->rsp[idx]);
+		if(!len){													// unknown length - only a single PID response can be split
+			if(ptrReq->pidCnt > 1)
+				return 0;
+			len = end - idx - 1;
+		}
+		if(ptrReq->rsp[idx] == pid){
+			if((idx + 1 + len) > end)								// truncated record
+				return 0;
+			*ptrLen = len;
+			return &ptrReq->rsp[idx + 1];
+		}
+		idx += 1 + len;
+	}
+	return 0;
+}
+/**************************************************************************************************
+Purpose: 	Decodes a PID of a completed response into fixed point values (refer to obd2s1PidDecode())
+Inputs:		*ptrReq		- obd2Req pointer (state OBD2DONE)
+			pid			- service 0x01 PID
+			*ptrVal		- obd2Val pointer to store the values
+
+Outputs:	result		- #of values decoded (0 = PID not in the response or not supported)
+**************************************************************************************************/
+uint8_t obd2cli_decode(const obd2Req *ptrReq,uint8_t pid,obd2Val *ptrVal){
+	const uint8_t *ptrData;
+	uint8_t idx, len, buf[8];
+
+	ptrVal->pid = pid;
+	ptrVal->cnt = 0;
+	ptrData = obd2cli_data(ptrReq,pid,&len);
+	if(!ptrData)
+		return 0;
+	buf[0] = len + 2;												// same layout as a single frame response
+	buf[1] = 0x41;
+	buf[2] = pid;
+	for(idx=0;idx<5;idx++){
+		buf[idx + 3] = (idx < len) ? ptrData[idx] : 0;
+	}
+	return obd2s1PidDecode(buf,ptrVal);
+}
+/**************************************************************************************************
+Purpose: 	Starts ECU discovery: 1 functional request for the supported PIDs bitmaps 0x00-0xA0, every ECU
+				answering within the window is added as a request (state OBD2DONE, rsp = bitmaps) by
+				obd2cli_poll(), once per response ID (a repeated discovery refreshes the bitmaps); discovery
+				is over when disc reads 0. No requests should be in flight.
+Inputs:		*ptrCli		- obd2Cli pointer
+			flags		- OBD2DISC11 (0x7DF -> 0x7E8-0x7EF) | OBD2DISC29 (0x18DB33F1 -> 0x18DAF1xx)
+			window		- response window in ms (0 = OBD2TIMEOUT)
+			tNow		- current time in ms (e.g. millis())
+
+Outputs:	result		- error code (refer to mcp251xfd_write_parts())
+**************************************************************************************************/
+uint8_t obd2cli_discover(obd2Cli *ptrCli,uint8_t flags,uint16_t window,unsigned long tNow){
+	uint8_t idx, rVal = 0;
+	uint8_t data[8];
+
+	data[0] = OBD2MAXPIDS + 1;										// #of additional bytes
+	data[1] = 0x01;													// service code
+	for(idx=0;idx<OBD2MAXPIDS;idx++){
+		data[idx + 2] = obd2DiscPid[idx];
+	}
+	if(flags & OBD2DISC11)
+		rVal = obd2cli_tx(ptrCli,0x7DF,data);
+	if(!rVal && (flags & OBD2DISC29))
+		rVal = obd2cli_tx(ptrCli,0x18DB33F1UL | CANID_EXT,data);
+	if(rVal)
+		return rVal;
+	mcp251xfd_start_transmit(ptrCli->txBuf,ptrCli->ptrChn);
+	ptrCli->sent++;
+	ptrCli->disc = flags;
+	ptrCli->discWin = window ? window : OBD2TIMEOUT;
+	ptrCli->discT0 = tNow;
+	return 0;
+}
+/**************************************************************************************************
+Purpose: 	Checks a PID against the supported PIDs bitmaps of a completed response
+Inputs:		*ptrReq		- obd2Req pointer (state OBD2DONE, e.g. a discovered ECU)
+			pid			- service 0x01 PID
+
+Outputs:	result		- 1 = PID supported; else 0
+**************************************************************************************************/
+uint8_t obd2cli_spt(const obd2Req *ptrReq,uint8_t pid){
+	const uint8_t *ptrData;
+	uint8_t len;
+
+	if(!pid)														// bitmap page 0x00 answered
+		return !!obd2cli_data(ptrReq,0x00,&len);
+	pid--;
+	ptrData = obd2cli_data(ptrReq,pid & 0xE0,&len);
+	if(!ptrData || (len < 4))
+		return 0;
+	return (ptrData[(pid & 0x1F) >> 3] >> (7 - (pid & 0x07))) & 1;	// byte A bit 7 = 1st PID of the page
+}
@@ -0,0 +1,98 @@
+/***************************************************
+  This is our library for the QBcircuits Arduino Pro mini/micro CAN FD shield
+  ----> https://www.qbcircuits.com
+
+  Check out the link above for our tutorials, wiring diagrams
+  QBcircuits invests time and effort providing this open source code,
+  please support QBcircuits and open-source hardware by purchasing
+  products from QBcircuits - GoLong!
+
+  Written by Brother Q for QBcircuits
+  All text above must be included in any redistribution
+ ****************************************************/
+
+#ifndef QB_OBD2CLI_H
+#define QB_OBD2CLI_H
+
+#if ARDUINO>=100
+#include <Arduino.h> // Arduino 1.0
+#else
+#include <Wprogram.h> // Arduino 0022
+#endif
+#include "qb_mcp251xfd.h"
+#include "qb_obd2.h"
+
+/**************************************************************************************************
+Algorithm variables 
+  Non blocking OBD2 service 0x01 client: each obd2Req packs up to 6 PIDs into 1 request to 1 ECU &
+  completes on the response (single frame, or first frame + flow control + consecutive frames per
+  ISO 15765-2) instead of a fixed delay. obd2cli_poll() drains the RX FIFO, sends queued requests
+  (1 in flight per ECU, any #of ECUs in flight), flow control & times out requests. A finished request
+  is re-armed with obd2cli_send():
+    obd2cli_add(&obd,0x7E0,pids,6,0);
+    obd2cli_send(&obd,0);
+    if(obd2cli_poll(&obd,millis()) && (req[0].state == OBD2DONE)){ obd2cli_decode(&req[0],0x0C,&val); obd2cli_send(&obd,0); }
+  Requests are classic 8 byte frames; the RX FIFO filter must pass the response IDs (0x7E8-0x7EF or
+  0x18DAF1xx) & nothing else the client should skip.
+  ECU discovery is 1 round trip: obd2cli_discover() sends 1 functional request for the supported PIDs
+  bitmaps & every ECU answering within the window becomes a request (physical ID, bitmap PIDs) with
+  its bitmaps in rsp (obd2cli_spt()), flow control going to its physical ID. An ECU already in the
+  table is not added again: its bitmaps request is reused, a request from obd2cli_add() is left as is.
+**************************************************************************************************/
+#define OBD2MAXPIDS		6				// max #of PIDs per service 0x01 request
+#define OBD2RSPLEN		32				// response buffer (0x41 + 6 x (PID + 4 data bytes) = 31)
+#define OBD2TIMEOUT		50				// default response timeout (ms, P2 max of ISO 15765-4)
+
+#define OBD2DISC11		0x01			// discovery - 11 bit functional request 0x7DF
+#define OBD2DISC29		0x02			// discovery - 29 bit functional request 0x18DB33F1
+
+#define OBD2IDLE		0				// request state - not queued
+#define OBD2QUEUED		1				// request state - waiting to be sent
+#define OBD2WAIT		2				// request state - sent, waiting for the response
+#define OBD2FC			3				// request state - first frame received, flow control to send
+#define OBD2CF			4				// request state - receiving consecutive frames
+#define OBD2DONE		5				// request state - response complete (rsp/len)
+#define OBD2NEG			6				// request state - negative response (rsp[2] = response code)
+#define OBD2TMO			7				// request state - timed out
+
+typedef struct{
+	unsigned long txId;												// request ID (| CANID_EXT for 29 bit)
+	unsigned long rxId;												// response ID
+	uint8_t pid[OBD2MAXPIDS];										// requested PIDs
+	uint8_t pidCnt;													// #of PIDs
+	uint8_t state;													// OBD2x request state
+	uint8_t sn;														// next consecutive frame sequence #
+	uint8_t len;													// #of response bytes (from SF/FF)
+	uint8_t got;													// #of response bytes received
+	uint16_t timeout;												// response timeout (ms)
+	uint16_t tRsp;													// time from request to response complete (ms)
+	unsigned long t0;												// time of request / last frame (ms)
+	uint8_t rsp[OBD2RSPLEN];										// response (0x41,PID,data,PID,data..)
+} obd2Req;
+
+typedef struct{
+	chnCAN *ptrChn;													// channel
+	uint8_t txBuf;													// TXQ or TX FIFO for requests & flow control
+	uint8_t rxBuf;													// RX FIFO of the responses
+	uint8_t cnt;													// #of requests added
+	uint8_t size;													// #of entries in *ptrTbl
+	obd2Req *ptrTbl;												// caller owned request table
+	unsigned long sent;												// #of requests sent
+	unsigned long done;												// #of positive responses
+	unsigned long neg;												// #of negative responses
+	unsigned long tmo;												// #of timeouts
+	uint8_t disc;													// OBD2DISCx flags while discovering; 0 = not discovering
+	uint16_t discWin;												// discovery response window (ms)
+	unsigned long discT0;											// time of the functional request (ms)
+} obd2Cli;
+
+void 			obd2cli_init(obd2Cli *ptrCli,chnCAN *ptrChn,uint8_t txBuf,uint8_t rxBuf,obd2Req *ptrTbl,uint8_t size);
+uint8_t 		obd2cli_add(obd2Cli *ptrCli,unsigned long ecuId,const uint8_t *ptrPid,uint8_t cnt,uint16_t timeout);
+void 			obd2cli_send(obd2Cli *ptrCli,uint8_t idx);
+uint8_t 		obd2cli_poll(obd2Cli *ptrCli,unsigned long tNow);
+const uint8_t *	obd2cli_data(const obd2Req *ptrReq,uint8_t pid,uint8_t *ptrLen);
+uint8_t 		obd2cli_decode(const obd2Req *ptrReq,uint8_t pid,obd2Val *ptrVal);
+uint8_t 		obd2cli_discover(obd2Cli *ptrCli,uint8_t flags,uint16_t window,unsigned long tNow);
+uint8_t 		obd2cli_spt(const obd2Req *ptrReq,uint8_t pid);
+
+#endif